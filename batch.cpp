@@ -0,0 +1,552 @@
+#include "batch.h"
+
+#include <math.h>
+
+#define _ROW(r) (this->_registers + (size_t)(r) * this->_stride)
+#define _LANES for (uint32_t l = 0; l < n; l++)
+// write the scratch row into the lanes taking part in the step, keep the rest
+#define _BLEND(dst) _LANES dst[l] = (tmp[l] & mask[l]) | (dst[l] & ~mask[l]);
+#define _FLOAT(row) ((float *)(row))
+#define _INT(row) ((int32_t *)(row))
+
+// the fast path only decodes instructions fully inside the shared code image
+// and leaves anything that could fault or write IP to the scalar interpreter
+#define _OPERANDS(len)                      \
+    if ((uint32_t)ip + len > this->_progLen) \
+        return false;
+// IP is read after the operands in the scalar VM, so leave it to that
+#define _SRC(r)                           \
+    if (r >= REGISTER_COUNT || r == IP) \
+        return false;
+#define _DST(r)                           \
+    if (r >= REGISTER_COUNT || r == IP) \
+        return false;
+
+#define _BINARY(expr)                              \
+    {                                              \
+        _OPERANDS(4)                               \
+        _DST(code[1])                              \
+        _SRC(code[2])                              \
+        _SRC(code[3])                              \
+        uint32_t *dst = _ROW(code[1]);             \
+        const uint32_t *a = _ROW(code[2]);         \
+        const uint32_t *b = _ROW(code[3]);         \
+        _LANES expr;                               \
+        _BLEND(dst)                                \
+        next = ip + 4;                             \
+        break;                                     \
+    }
+// register and immediate operands; the immediate is a byte for len 4, an int for len 7
+#define _IMMEDIATE(len, expr)                                              \
+    {                                                                      \
+        _OPERANDS(len)                                                     \
+        _DST(code[1])                                                      \
+        _SRC(code[2])                                                      \
+        uint32_t *dst = _ROW(code[1]);                                     \
+        const uint32_t *a = _ROW(code[2]);                                 \
+        uint32_t imm = code[3];                                            \
+        if (len == 7)                                                      \
+            imm |= code[4] << 8 | code[5] << 16 | (uint32_t)code[6] << 24; \
+        _LANES expr;                                                       \
+        _BLEND(dst)                                                        \
+        next = ip + len;                                                   \
+        break;                                                             \
+    }
+#define _UNARY(len, expr)                  \
+    {                                      \
+        _OPERANDS(len)                     \
+        _DST(code[1])                      \
+        _SRC(code[len - 1])                \
+        uint32_t *dst = _ROW(code[1]);     \
+        const uint32_t *a = _ROW(code[len - 1]); \
+        _LANES expr;                       \
+        _BLEND(dst)                        \
+        next = ip + len;                   \
+        break;                             \
+    }
+#define _CONST(len, value)             \
+    {                                  \
+        _OPERANDS(len)                 \
+        _DST(code[1])                  \
+        uint32_t *dst = _ROW(code[1]); \
+        const uint32_t val = value;    \
+        _LANES tmp[l] = val;           \
+        _BLEND(dst)                    \
+        next = ip + len;               \
+        break;                         \
+    }
+#define _BRANCH(expr)                                               \
+    {                                                               \
+        _OPERANDS(5)                                                \
+        _SRC(code[1])                                               \
+        _SRC(code[2])                                               \
+        const uint32_t *a = _ROW(code[1]);                          \
+        const uint32_t *b = _ROW(code[2]);                          \
+        const uint32_t addr = code[3] | code[4] << 8;               \
+        _LANES tmp[l] = (expr) ? addr : ip + 5;                     \
+        _BLEND(ipRow)                                               \
+        return true;                                                \
+    }
+#define _BRANCH_IMM(expr)                                                                      \
+    {                                                                                          \
+        _OPERANDS(8)                                                                           \
+        _SRC(code[1])                                                                          \
+        const uint32_t *a = _ROW(code[1]);                                                     \
+        const uint32_t imm = code[2] | code[3] << 8 | code[4] << 16 | (uint32_t)code[5] << 24; \
+        const uint32_t addr = code[6] | code[7] << 8;                                          \
+        _LANES tmp[l] = (expr) ? addr : ip + 8;                                                \
+        _BLEND(ipRow)                                                                          \
+        return true;                                                                           \
+    }
+// decrement the register, then branch to target while it is not zero
+#define _DJNZ(len, target)                             \
+    {                                                  \
+        _OPERANDS(len)                                 \
+        _DST(code[1])                                  \
+        uint32_t *dst = _ROW(code[1]);                 \
+        const uint32_t addr = target;                  \
+        _LANES tmp[l] = dst[l] - 1;                    \
+        _BLEND(dst)                                    \
+        _LANES tmp[l] = dst[l] != 0 ? addr : ip + len; \
+        _BLEND(ipRow)                                  \
+        return true;                                   \
+    }
+
+// Scalar interpreter for the instructions the lockstep path does not decode.
+// It executes a single instruction directly on a lane's memory and registers.
+class LaneVM : public VM
+{
+  public:
+    LaneVM(uint8_t *program, uint16_t progLen, uint16_t stackSize)
+        : VM(program, progLen, stackSize)
+    {
+    }
+
+    ExecResult step(uint8_t *memory, uint32_t *registers)
+    {
+        uint8_t *own = this->_memory;
+        this->_memory = memory;
+        memcpy(this->_registers, registers, sizeof(this->_registers));
+        // one step is not a run of its own, so nothing goes to the stats
+        const ExecResult result = this->_runUnpublished(1);
+        memcpy(registers, this->_registers, sizeof(this->_registers));
+        this->_memory = own;
+        return result;
+    }
+};
+
+VMBatch::VMBatch(uint8_t *program, uint16_t progLen, uint32_t lanes, uint16_t stackSize)
+    : _lanes(lanes), _stride((lanes + 7) & ~7U), _memSize(progLen + stackSize), _stackSize(stackSize), _progLen(progLen)
+{
+    this->_code = new uint8_t[progLen];
+    memcpy(this->_code, program, progLen);
+    this->_memory = new uint8_t[(size_t)lanes * this->_memSize];
+    this->_registers = new uint32_t[(size_t)REGISTER_COUNT * this->_stride];
+    this->_mask = new uint32_t[this->_stride];
+    this->_tmp = new uint32_t[this->_stride];
+    this->_counts = new uint32_t[this->_stride];
+    this->_results = new ExecResult[lanes];
+    this->_running = new bool[lanes];
+    this->_scalar = new LaneVM(program, progLen, stackSize);
+    this->reset();
+}
+
+VMBatch::~VMBatch()
+{
+    delete this->_scalar;
+    delete[] this->_running;
+    delete[] this->_results;
+    delete[] this->_counts;
+    delete[] this->_tmp;
+    delete[] this->_mask;
+    delete[] this->_registers;
+    delete[] this->_memory;
+    delete[] this->_code;
+}
+
+void VMBatch::reset()
+{
+    for (uint32_t l = 0; l < this->_lanes; l++)
+    {
+        memcpy(this->memory(l), this->_code, this->_progLen);
+        memset(this->memory(l, this->_progLen), 0, this->_stackSize);
+        this->_results[l] = ExecResult::VM_PAUSED;
+        this->_running[l] = false;
+    }
+    memset(this->_registers, 0, (size_t)REGISTER_COUNT * this->_stride * sizeof(uint32_t));
+    memset(this->_mask, 0, this->_stride * sizeof(uint32_t));
+    memset(this->_counts, 0, this->_stride * sizeof(uint32_t));
+
+    uint32_t *sp = _ROW(SP);
+    uint32_t *bp = _ROW(BP);
+    for (uint32_t l = 0; l < this->_lanes; l++)
+        sp[l] = bp[l] = this->_progLen + this->_stackSize;
+}
+
+void VMBatch::onInterrupt(bool (*callback)(uint8_t))
+{
+    this->_scalar->onInterrupt(callback);
+}
+
+uint32_t VMBatch::laneCount()
+{
+    return this->_lanes;
+}
+
+ExecResult VMBatch::result(uint32_t lane)
+{
+    return this->_results[lane];
+}
+
+uint32_t VMBatch::instrCount(uint32_t lane)
+{
+    return this->_counts[lane];
+}
+
+uint8_t *VMBatch::memory(uint32_t lane, uint16_t addr)
+{
+    return &this->_memory[(size_t)lane * this->_memSize + addr];
+}
+
+uint32_t *VMBatch::lanes(Register reg)
+{
+    return _ROW(reg);
+}
+
+uint32_t VMBatch::getRegister(uint32_t lane, Register reg)
+{
+    return _ROW(reg)[lane];
+}
+
+void VMBatch::setRegister(uint32_t lane, Register reg, uint32_t val)
+{
+    _ROW(reg)[lane] = val;
+}
+
+void VMBatch::run(uint32_t maxInstr)
+{
+    uint32_t *ipRow = _ROW(IP);
+
+    // lanes paused by a previous run resume, like VM::run does
+    for (uint32_t l = 0; l < this->_lanes; l++)
+    {
+        this->_running[l] = this->_results[l] == ExecResult::VM_PAUSED;
+        this->_counts[l] = 0;
+    }
+
+    while (true)
+    {
+        uint32_t leader = UINT32_MAX;
+        for (uint32_t l = 0; l < this->_lanes; l++)
+            if (this->_running[l] && ipRow[l] < leader)
+                leader = ipRow[l];
+        if (leader == UINT32_MAX)
+            return;
+
+        // lanes ahead of the leader wait until it catches up with them
+        for (uint32_t l = 0; l < this->_lanes; l++)
+            this->_mask[l] = (this->_running[l] && ipRow[l] == leader) ? ~0U : 0;
+
+        if (leader < this->_progLen && this->_code[leader] == OP_HALT)
+        {
+            for (uint32_t l = 0; l < this->_lanes; l++)
+                if (this->_mask[l])
+                {
+                    this->_running[l] = false;
+                    this->_results[l] = ExecResult::VM_FINISHED;
+                }
+            continue;
+        }
+
+        if (leader >= this->_progLen || !this->step(leader))
+            this->stepScalar();
+
+        for (uint32_t l = 0; l < this->_lanes; l++)
+        {
+            if (!this->_mask[l] || !this->_running[l])
+                continue;
+            if (++this->_counts[l] == maxInstr)
+                this->_running[l] = false;
+        }
+    }
+}
+
+bool VMBatch::step(uint32_t ip)
+{
+    const uint8_t *code = &this->_code[ip];
+    const uint32_t n = this->_stride;
+    uint32_t *__restrict tmp = this->_tmp;
+    const uint32_t *__restrict mask = this->_mask;
+    uint32_t *ipRow = _ROW(IP);
+    uint32_t next;
+
+    switch (code[0])
+    {
+    case OP_NOP:
+        next = ip + 1;
+        break;
+    case OP_MOV:
+        _UNARY(3, tmp[l] = a[l])
+    case OP_LCONS:
+        _CONST(6, code[2] | code[3] << 8 | code[4] << 16 | (uint32_t)code[5] << 24)
+    case OP_LCONSW:
+        _CONST(4, code[2] | code[3] << 8)
+    case OP_LCONSB:
+        _CONST(3, code[2])
+    case OP_INC:
+        _UNARY(2, tmp[l] = a[l] + 1)
+    case OP_DEC:
+        _UNARY(2, tmp[l] = a[l] - 1)
+    case OP_U2I:
+    case OP_I2U:
+        _UNARY(2, tmp[l] = a[l])
+    case OP_NOT:
+        _UNARY(3, tmp[l] = ~a[l])
+    case OP_I2F:
+        _UNARY(3, _FLOAT(tmp)[l] = (float)_INT(a)[l])
+    case OP_F2I:
+        _UNARY(3, _INT(tmp)[l] = (int32_t)_FLOAT(a)[l])
+    case OP_ADD:
+        _BINARY(tmp[l] = a[l] + b[l])
+    case OP_SUB:
+        _BINARY(tmp[l] = a[l] - b[l])
+    case OP_MUL:
+    case OP_IMUL:
+        _BINARY(tmp[l] = a[l] * b[l])
+    case OP_AND:
+        _BINARY(tmp[l] = a[l] & b[l])
+    case OP_OR:
+        _BINARY(tmp[l] = a[l] | b[l])
+    case OP_XOR:
+        _BINARY(tmp[l] = a[l] ^ b[l])
+    case OP_SHL:
+        _BINARY(tmp[l] = a[l] << (b[l] & 31))
+    case OP_SHR:
+        _BINARY(tmp[l] = a[l] >> (b[l] & 31))
+    case OP_ISHR:
+        _BINARY(_INT(tmp)[l] = _INT(a)[l] >> (b[l] & 31))
+    case OP_FADD:
+        _BINARY(_FLOAT(tmp)[l] = _FLOAT(a)[l] + _FLOAT(b)[l])
+    case OP_FSUB:
+        _BINARY(_FLOAT(tmp)[l] = _FLOAT(a)[l] - _FLOAT(b)[l])
+    case OP_FMUL:
+        _BINARY(_FLOAT(tmp)[l] = _FLOAT(a)[l] * _FLOAT(b)[l])
+    case OP_FDIV:
+        _BINARY(_FLOAT(tmp)[l] = _FLOAT(a)[l] / _FLOAT(b)[l])
+    case OP_ADDI:
+        _IMMEDIATE(7, tmp[l] = a[l] + imm)
+    case OP_ADDIB:
+        _IMMEDIATE(4, tmp[l] = a[l] + imm)
+    case OP_SUBI:
+        _IMMEDIATE(7, tmp[l] = a[l] - imm)
+    case OP_SUBIB:
+        _IMMEDIATE(4, tmp[l] = a[l] - imm)
+    case OP_MULI:
+        _IMMEDIATE(7, tmp[l] = a[l] * imm)
+    case OP_MULIB:
+        _IMMEDIATE(4, tmp[l] = a[l] * imm)
+    case OP_ANDI:
+        _IMMEDIATE(7, tmp[l] = a[l] & imm)
+    case OP_ANDIB:
+        _IMMEDIATE(4, tmp[l] = a[l] & imm)
+    case OP_ORI:
+        _IMMEDIATE(7, tmp[l] = a[l] | imm)
+    case OP_ORIB:
+        _IMMEDIATE(4, tmp[l] = a[l] | imm)
+    case OP_XORI:
+        _IMMEDIATE(7, tmp[l] = a[l] ^ imm)
+    case OP_XORIB:
+        _IMMEDIATE(4, tmp[l] = a[l] ^ imm)
+    case OP_SHLIB:
+        _IMMEDIATE(4, tmp[l] = a[l] << (imm & 31))
+    case OP_SHRIB:
+        _IMMEDIATE(4, tmp[l] = a[l] >> (imm & 31))
+    case OP_ISHRIB:
+        _IMMEDIATE(4, _INT(tmp)[l] = _INT(a)[l] >> (imm & 31))
+    case OP_FADDI:
+        _IMMEDIATE(7, _FLOAT(tmp)[l] = _FLOAT(a)[l] + _FLOAT(&imm)[0])
+    case OP_FSUBI:
+        _IMMEDIATE(7, _FLOAT(tmp)[l] = _FLOAT(a)[l] - _FLOAT(&imm)[0])
+    case OP_FMULI:
+        _IMMEDIATE(7, _FLOAT(tmp)[l] = _FLOAT(a)[l] * _FLOAT(&imm)[0])
+    case OP_FDIVI:
+        _IMMEDIATE(7, _FLOAT(tmp)[l] = _FLOAT(a)[l] / _FLOAT(&imm)[0])
+    case OP_POPCNT:
+        _UNARY(3, tmp[l] = __builtin_popcount(a[l]))
+    case OP_CLZ:
+        _UNARY(3, tmp[l] = a[l] == 0 ? 32 : __builtin_clz(a[l]))
+    case OP_CTZ:
+        _UNARY(3, tmp[l] = a[l] == 0 ? 32 : __builtin_ctz(a[l]))
+    case OP_BSWAP:
+        _UNARY(3, tmp[l] = __builtin_bswap32(a[l]))
+    case OP_ROL:
+        _BINARY(tmp[l] = (a[l] << (b[l] & 31)) | (a[l] >> ((32 - b[l]) & 31)))
+    case OP_ROR:
+        _BINARY(tmp[l] = (a[l] >> (b[l] & 31)) | (a[l] << ((32 - b[l]) & 31)))
+    case OP_ROLIB:
+        _IMMEDIATE(4, tmp[l] = (a[l] << (imm & 31)) | (a[l] >> ((32 - imm) & 31)))
+    case OP_RORIB:
+        _IMMEDIATE(4, tmp[l] = (a[l] >> (imm & 31)) | (a[l] << ((32 - imm) & 31)))
+    case OP_MIN:
+        _BINARY(tmp[l] = a[l] < b[l] ? a[l] : b[l])
+    case OP_MAX:
+        _BINARY(tmp[l] = a[l] > b[l] ? a[l] : b[l])
+    case OP_IMIN:
+        _BINARY(tmp[l] = _INT(a)[l] < _INT(b)[l] ? a[l] : b[l])
+    case OP_IMAX:
+        _BINARY(tmp[l] = _INT(a)[l] > _INT(b)[l] ? a[l] : b[l])
+    case OP_FMA:
+    {
+        _OPERANDS(5)
+        _DST(code[1])
+        _SRC(code[2])
+        _SRC(code[3])
+        _SRC(code[4])
+        uint32_t *dst = _ROW(code[1]);
+        const uint32_t *a = _ROW(code[2]);
+        const uint32_t *b = _ROW(code[3]);
+        const uint32_t *c = _ROW(code[4]);
+        _LANES _FLOAT(tmp)[l] = fmaf(_FLOAT(a)[l], _FLOAT(b)[l], _FLOAT(c)[l]);
+        _BLEND(dst)
+        next = ip + 5;
+        break;
+    }
+    case OP_FSQRT:
+        _UNARY(3, _FLOAT(tmp)[l] = sqrtf(_FLOAT(a)[l]))
+    case OP_FABS:
+        _UNARY(3, tmp[l] = a[l] & 0x7FFFFFFF)
+    case OP_FNEG:
+        _UNARY(3, tmp[l] = a[l] ^ 0x80000000)
+    case OP_FMIN:
+        _BINARY(_FLOAT(tmp)[l] = floatMin(_FLOAT(a)[l], _FLOAT(b)[l]))
+    case OP_FMAX:
+        _BINARY(_FLOAT(tmp)[l] = floatMax(_FLOAT(a)[l], _FLOAT(b)[l]))
+    case OP_FFLOOR:
+        _UNARY(3, _FLOAT(tmp)[l] = floorf(_FLOAT(a)[l]))
+    case OP_FCEIL:
+        _UNARY(3, _FLOAT(tmp)[l] = ceilf(_FLOAT(a)[l]))
+    case OP_FROUND:
+        _UNARY(3, _FLOAT(tmp)[l] = floatRound(_FLOAT(a)[l]))
+    case OP_JMP:
+    {
+        _OPERANDS(3)
+        next = code[1] | code[2] << 8;
+        break;
+    }
+    case OP_JZ:
+    case OP_JNZ:
+    {
+        _OPERANDS(4)
+        _SRC(code[1])
+        const uint32_t *a = _ROW(code[1]);
+        const uint32_t addr = code[2] | code[3] << 8;
+        const bool zero = code[0] == OP_JZ;
+        _LANES tmp[l] = ((a[l] == 0) == zero) ? addr : ip + 4;
+        _BLEND(ipRow)
+        return true;
+    }
+    case OP_JE:
+        _BRANCH(a[l] == b[l])
+    case OP_JNE:
+        _BRANCH(a[l] != b[l])
+    case OP_JA:
+        _BRANCH(a[l] > b[l])
+    case OP_JG:
+        _BRANCH(_INT(a)[l] > _INT(b)[l])
+    case OP_JAE:
+        _BRANCH(a[l] >= b[l])
+    case OP_JGE:
+        _BRANCH(_INT(a)[l] >= _INT(b)[l])
+    case OP_JB:
+        _BRANCH(a[l] < b[l])
+    case OP_JL:
+        _BRANCH(_INT(a)[l] < _INT(b)[l])
+    case OP_JBE:
+        _BRANCH(a[l] <= b[l])
+    case OP_JLE:
+        _BRANCH(_INT(a)[l] <= _INT(b)[l])
+    case OP_JFE:
+        _BRANCH(_FLOAT(a)[l] == _FLOAT(b)[l])
+    case OP_JFNE:
+        _BRANCH(_FLOAT(a)[l] != _FLOAT(b)[l])
+    case OP_JFG:
+        _BRANCH(_FLOAT(a)[l] > _FLOAT(b)[l])
+    case OP_JFGE:
+        _BRANCH(_FLOAT(a)[l] >= _FLOAT(b)[l])
+    case OP_JFL:
+        _BRANCH(_FLOAT(a)[l] < _FLOAT(b)[l])
+    case OP_JFLE:
+        _BRANCH(_FLOAT(a)[l] <= _FLOAT(b)[l])
+    case OP_JEI:
+        _BRANCH_IMM(a[l] == imm)
+    case OP_JNEI:
+        _BRANCH_IMM(a[l] != imm)
+    case OP_JAI:
+        _BRANCH_IMM(a[l] > imm)
+    case OP_JGI:
+        _BRANCH_IMM(_INT(a)[l] > (int32_t)imm)
+    case OP_JAEI:
+        _BRANCH_IMM(a[l] >= imm)
+    case OP_JGEI:
+        _BRANCH_IMM(_INT(a)[l] >= (int32_t)imm)
+    case OP_JBI:
+        _BRANCH_IMM(a[l] < imm)
+    case OP_JLI:
+        _BRANCH_IMM(_INT(a)[l] < (int32_t)imm)
+    case OP_JBEI:
+        _BRANCH_IMM(a[l] <= imm)
+    case OP_JLEI:
+        _BRANCH_IMM(_INT(a)[l] <= (int32_t)imm)
+    case OP_DJNZ:
+        _DJNZ(4, code[2] | code[3] << 8)
+    case OP_DJNZ_S:
+        _DJNZ(3, ip + (int8_t)code[2])
+    case OP_JMP_S:
+    {
+        _OPERANDS(2)
+        next = ip + (int8_t)code[1];
+        break;
+    }
+    case OP_JZ_S:
+    case OP_JNZ_S:
+    {
+        _OPERANDS(3)
+        _SRC(code[1])
+        const uint32_t *a = _ROW(code[1]);
+        const uint32_t addr = ip + (int8_t)code[2];
+        const bool zero = code[0] == OP_JZ_S;
+        _LANES tmp[l] = ((a[l] == 0) == zero) ? addr : ip + 3;
+        _BLEND(ipRow)
+        return true;
+    }
+    default:
+        return false;
+    }
+
+    _LANES tmp[l] = next;
+    _BLEND(ipRow)
+    return true;
+}
+
+void VMBatch::stepScalar()
+{
+    uint32_t registers[REGISTER_COUNT];
+
+    for (uint32_t l = 0; l < this->_lanes; l++)
+    {
+        if (!this->_mask[l])
+            continue;
+
+        for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+            registers[r] = _ROW(r)[l];
+        const ExecResult result = this->_scalar->step(this->memory(l), registers);
+        for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+            _ROW(r)[l] = registers[r];
+
+        if (result != ExecResult::VM_PAUSED)
+        {
+            this->_running[l] = false;
+            this->_results[l] = result;
+        }
+    }
+}
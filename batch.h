@@ -0,0 +1,54 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "vm.h"
+
+class LaneVM;
+
+// Runs one program over many independent register sets in lockstep.
+// Registers are kept as structure-of-arrays (register k of every lane is
+// contiguous), so lanes sharing an IP execute an instruction as a single
+// vectorizable loop. Diverged lanes are masked: the lanes at the lowest IP run
+// while the others wait for them to reconverge. Instructions are decoded from
+// the program image shared by all lanes, so programs must not modify their own
+// code.
+class VMBatch
+{
+  public:
+    VMBatch(uint8_t *program, uint16_t progLen, uint32_t lanes, uint16_t stackSize = 256);
+    ~VMBatch();
+
+    void run(uint32_t maxInstr = 0);
+    void reset();
+    void onInterrupt(bool (*callback)(uint8_t));
+
+    uint32_t laneCount();
+    ExecResult result(uint32_t lane);
+    uint32_t instrCount(uint32_t lane);
+    uint8_t *memory(uint32_t lane, uint16_t addr = 0);
+
+    uint32_t *lanes(Register reg);
+    uint32_t getRegister(uint32_t lane, Register reg);
+    void setRegister(uint32_t lane, Register reg, uint32_t val);
+
+  protected:
+    bool step(uint32_t ip);
+    void stepScalar();
+
+    uint8_t *_code;
+    uint8_t *_memory;
+    uint32_t *_registers; // REGISTER_COUNT rows of _stride lanes
+    uint32_t *_mask;      // ~0 for lanes taking part in the current step
+    uint32_t *_tmp;       // scratch row for masked writes
+    uint32_t *_counts;
+    ExecResult *_results;
+    bool *_running;
+    LaneVM *_scalar;
+    const uint32_t _lanes;
+    const uint32_t _stride;
+    const uint16_t _memSize;
+    const uint16_t _stackSize;
+    const uint16_t _progLen;
+};
+
+#endif // __BATCH_H__
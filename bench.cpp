@@ -0,0 +1,547 @@
+#include "vm.h"
+#include "checksum.h"
+#include "opprofile.h"
+#include "perfcounters.h"
+#include "program.h"
+
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+// Interpreter benchmarks: per-opcode loops and small bytecode programs. Every
+// benchmark is run once instrumented to count its instructions and check its
+// result, then timed uninstrumented, and run once more under the host's
+// hardware counters when perf_event_open provides them. Results go to stdout
+// and, one line per benchmark, to bench_output.txt for comparing runs.
+
+#define IMM16(v) (uint8_t)(v), (uint8_t)((v) >> 8)
+#define IMM32(v) (uint8_t)(v), (uint8_t)((v) >> 8), (uint8_t)((v) >> 16), (uint8_t)((v) >> 24)
+
+#define MICRO_LOOPS 1000000
+// programs keep their data here, inside the memory the VM allocates for the stack
+#define DATA 0x1000
+#define STACK_SIZE 0xE000
+
+static uint8_t addLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_ADD, R1, R1, R2, // 6
+    OP_ADD, R2, R2, R3,
+    OP_ADD, R3, R3, R4,
+    OP_ADD, R4, R4, R1,
+    OP_DEC, R0,
+    OP_JNZ, R0, IMM16(6),
+    OP_HALT};
+
+// the same adds with immediates instead of registers, and the counter decremented by subib
+static uint8_t addImmLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_ADDIB, R1, R1, 1, // 6
+    OP_ADDIB, R2, R2, 2,
+    OP_ADDIB, R3, R3, 3,
+    OP_ADDI, R4, R4, IMM32(100000),
+    OP_SUBIB, R0, R0, 1,
+    OP_JNZ, R0, IMM16(6),
+    OP_HALT};
+
+// the add loop on 64-bit register pairs
+static uint8_t addQwordLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_ADDQ, R2, R2, T0, // 6
+    OP_ADDQ, T0, T0, T2,
+    OP_ADDQ, T2, T2, T4,
+    OP_ADDQ, T4, T4, R2,
+    OP_DEC, R0,
+    OP_JNZ, R0, IMM16(6),
+    OP_HALT};
+
+static uint8_t loadLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_LCONSW, R2, IMM16(DATA),
+    OP_LOAD_P, R1, R2, // 10
+    OP_LOAD_P, R3, R2,
+    OP_LOAD_P, R4, R2,
+    OP_LOAD_P, R5, R2,
+    OP_DEC, R0,
+    OP_JNZ, R0, IMM16(10),
+    OP_HALT};
+
+static uint8_t pushPopLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_PUSH, R1, // 6
+    OP_PUSH, R2,
+    OP_POP, R2,
+    OP_POP, R1,
+    OP_DEC, R0,
+    OP_JNZ, R0, IMM16(6),
+    OP_HALT};
+
+static uint8_t callLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_CALL, IMM16(16), // 6
+    OP_DEC, R0,
+    OP_JNZ, R0, IMM16(6),
+    OP_HALT,
+    OP_RET}; // 16
+
+static uint8_t branchLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_DEC, R0, // 6
+    OP_JNZ, R0, IMM16(6),
+    OP_HALT};
+
+// the jnz loop with the decrement fused into the branch, half the dispatches
+static uint8_t djnzLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_DJNZ_S, R0, 0, // 6
+    OP_HALT};
+
+// sum of min(x, 2^31) over an LCG sequence in R1, taken half the time at random:
+// with a branch around a mov, with a conditional move, and with min
+#define CLAMP_LIMIT 0x80000000U
+static uint8_t clampBranchLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_LCONS, R4, IMM32(CLAMP_LIMIT),
+    OP_MULI, R1, R1, IMM32(1103515245), // 12
+    OP_ADDI, R1, R1, IMM32(12345),
+    OP_MOV, R2, R1,
+    OP_JB, R2, R4, IMM16(37),
+    OP_MOV, R2, R4,
+    OP_ADD, R3, R3, R2, // 37
+    OP_DJNZ_S, R0, (uint8_t)-29,
+    OP_HALT};
+
+static uint8_t clampCmovLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_LCONS, R4, IMM32(CLAMP_LIMIT),
+    OP_MULI, R1, R1, IMM32(1103515245), // 12
+    OP_ADDI, R1, R1, IMM32(12345),
+    OP_MOV, R2, R4,
+    OP_CMOV, R2, R1, COND_B, R1, R4,
+    OP_ADD, R3, R3, R2,
+    OP_DJNZ_S, R0, (uint8_t)-27,
+    OP_HALT};
+
+static uint8_t clampMinLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_LCONS, R4, IMM32(CLAMP_LIMIT),
+    OP_MULI, R1, R1, IMM32(1103515245), // 12
+    OP_ADDI, R1, R1, IMM32(12345),
+    OP_MIN, R2, R1, R4,
+    OP_ADD, R3, R3, R2,
+    OP_DJNZ_S, R0, (uint8_t)-22,
+    OP_HALT};
+
+// four-way dispatch on the top bits of an LCG sequence, through a jump table and
+// through a chain of compares; each handler adds its case number plus one to R3
+static uint8_t switchLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_MULI, R1, R1, IMM32(1103515245), // 6
+    OP_ADDI, R1, R1, IMM32(12345),
+    OP_SHRIB, R2, R1, 30,
+    OP_SWITCH, R2, IMM16(4), IMM16(63),
+    IMM16(38), IMM16(45), IMM16(52), IMM16(59),
+    OP_ADDIB, R3, R3, 1, // 38
+    OP_JMP, IMM16(63),
+    OP_ADDIB, R3, R3, 2, // 45
+    OP_JMP, IMM16(63),
+    OP_ADDIB, R3, R3, 3, // 52
+    OP_JMP, IMM16(63),
+    OP_ADDIB, R3, R3, 4, // 59
+    OP_DJNZ, R0, IMM16(6), // 63
+    OP_HALT};
+
+static uint8_t compareChainLoop[] = {
+    OP_LCONS, R0, IMM32(MICRO_LOOPS),
+    OP_MULI, R1, R1, IMM32(1103515245), // 6
+    OP_ADDI, R1, R1, IMM32(12345),
+    OP_SHRIB, R2, R1, 30,
+    OP_JEI, R2, IMM32(0), IMM16(55),
+    OP_JEI, R2, IMM32(1), IMM16(62),
+    OP_JEI, R2, IMM32(2), IMM16(69),
+    OP_ADDIB, R3, R3, 4,
+    OP_JMP, IMM16(73),
+    OP_ADDIB, R3, R3, 1, // 55
+    OP_JMP, IMM16(73),
+    OP_ADDIB, R3, R3, 2, // 62
+    OP_JMP, IMM16(73),
+    OP_ADDIB, R3, R3, 3, // 69
+    OP_DJNZ, R0, IMM16(6), // 73
+    OP_HALT};
+
+// fib(n): n in R0, result in R1
+static uint8_t fibProgram[] = {
+    OP_LCONSB, R0, 25,
+    OP_LCONSB, R3, 2,
+    OP_CALL, IMM16(10),
+    OP_HALT,
+    OP_JB, R0, R3, IMM16(44), // 10
+    OP_PUSH, RA,
+    OP_PUSH, R0,
+    OP_DEC, R0,
+    OP_CALL, IMM16(10),
+    OP_POP, R0,
+    OP_PUSH, R1,
+    OP_DEC, R0,
+    OP_DEC, R0,
+    OP_CALL, IMM16(10),
+    OP_POP, R2,
+    OP_ADD, R1, R1, R2,
+    OP_POP, RA,
+    OP_RET,
+    OP_MOV, R1, R0, // 44
+    OP_RET};
+
+// fib with framed calls, RA is no longer saved by hand
+static uint8_t fibFramedProgram[] = {
+    OP_LCONSB, R0, 25,
+    OP_CALLF, IMM16(7),
+    OP_HALT,
+    OP_JBI, R0, IMM32(2), IMM16(42), // 7
+    OP_PUSH, R0,
+    OP_SUBIB, R0, R0, 1,
+    OP_CALLF, IMM16(7),
+    OP_POP, R0,
+    OP_PUSH, R1,
+    OP_SUBIB, R0, R0, 2,
+    OP_CALLF, IMM16(7),
+    OP_POP, R2,
+    OP_ADD, R1, R1, R2,
+    OP_RETF,
+    OP_MOV, R1, R0, // 42
+    OP_RETF};
+
+// the same 4096 bytes checksummed by one crc32c per pass, and hashed by an FNV-1a byte loop
+#define CHECKSUM_BYTES 4096
+#define CHECKSUM_PASSES 256
+
+static uint8_t crc32cLoop[] = {
+    OP_LCONSW, R0, IMM16(CHECKSUM_PASSES),
+    OP_LCONSW, R2, IMM16(DATA),
+    OP_LCONSW, R3, IMM16(CHECKSUM_BYTES),
+    OP_CRC32C, R1, R2, R3, // 12
+    OP_DJNZ_S, R0, (uint8_t)-4,
+    OP_HALT};
+
+static uint8_t fnv1aLoop[] = {
+    OP_LCONSW, R0, IMM16(CHECKSUM_PASSES),
+    OP_LCONS, R1, IMM32(2166136261U),
+    OP_LCONSW, R2, IMM16(DATA), // 10
+    OP_LCONSW, R4, IMM16(CHECKSUM_BYTES),
+    OP_LOADB_PI, R5, R2, // 18
+    OP_XOR, R1, R1, R5,
+    OP_MULI, R1, R1, IMM32(16777619),
+    OP_DJNZ_S, R4, (uint8_t)-14,
+    OP_DJNZ_S, R0, (uint8_t)-25,
+    OP_HALT};
+
+// primes below R1, counted in R5, one flag byte per number at DATA
+static uint8_t sieveProgram[] = {
+    OP_LCONSW, R1, IMM16(50000),
+    OP_LCONSB, R4, 1,
+    OP_LCONSB, R0, 2,
+    OP_LCONSB, R5, 0,
+    OP_JAE, R0, R1, IMM16(67), // 13
+    OP_LCONSW, R2, IMM16(DATA),
+    OP_ADD, R2, R2, R0,
+    OP_LOADB_P, T0, R2,
+    OP_JNZ, T0, IMM16(62),
+    OP_INC, R5,
+    OP_ADD, R3, R0, R0,
+    OP_JAE, R3, R1, IMM16(62), // 39
+    OP_LCONSW, R2, IMM16(DATA),
+    OP_ADD, R2, R2, R3,
+    OP_STORB_P, R2, R4,
+    OP_ADD, R3, R3, R0,
+    OP_JMP, IMM16(39),
+    OP_INC, R0, // 62
+    OP_JMP, IMM16(13),
+    OP_HALT}; // 67
+
+// fills R0 words at DATA in descending order, then bubble sorts them
+static uint8_t sortProgram[] = {
+    OP_LCONSW, R0, IMM16(300),
+    OP_LCONSB, T0, 4,
+    OP_LCONSW, R2, IMM16(DATA),
+    OP_MOV, T1, R0,
+    OP_STOR_P, R2, T1, // 14
+    OP_ADD, R2, R2, T0,
+    OP_DEC, T1,
+    OP_JNZ, T1, IMM16(14),
+    OP_MOV, R5, R2,
+    OP_LCONSW, R2, IMM16(DATA), // 30
+    OP_SUB, R5, R5, T0,
+    OP_LCONSW, T2, IMM16(DATA),
+    OP_JBE, R5, T2, IMM16(79),
+    OP_JAE, R2, R5, IMM16(30), // 47
+    OP_LOAD_P, R3, R2,
+    OP_ADD, T3, R2, T0,
+    OP_LOAD_P, R4, T3,
+    OP_JBE, R3, R4, IMM16(73),
+    OP_STOR_P, R2, R4,
+    OP_STOR_P, T3, R3,
+    OP_MOV, R2, T3, // 73
+    OP_JMP, IMM16(47),
+    OP_HALT}; // 79
+
+// the same sort with displacement and post-increment addressing instead of address arithmetic
+static uint8_t sortDispProgram[] = {
+    OP_LCONSW, R0, IMM16(300),
+    OP_LCONSW, R2, IMM16(DATA),
+    OP_MOV, T1, R0,
+    OP_STOR_PI, R2, T1, // 11
+    OP_DJNZ_S, T1, (uint8_t)-3,
+    OP_MOV, R5, R2,
+    OP_LCONSW, R2, IMM16(DATA), // 20
+    OP_SUBIB, R5, R5, 4,
+    OP_JBEI, R5, IMM32(DATA), IMM16(69),
+    OP_JAE, R2, R5, IMM16(20), // 36
+    OP_LOAD_P, R3, R2,
+    OP_LOAD_D, R4, R2, IMM16(4),
+    OP_JBE, R3, R4, IMM16(62),
+    OP_STOR_P, R2, R4,
+    OP_STOR_D, R2, IMM16(4), R3,
+    OP_ADDIB, R2, R2, 4, // 62
+    OP_JMP, IMM16(36),
+    OP_HALT}; // 69
+
+// C = A * B for 16x16 floats, A[k] = k and B[k] = 2 at DATA, DATA + 0x400, DATA + 0x800
+static uint8_t matmulProgram[] = {
+    OP_LCONSB, T0, 4,
+    OP_LCONSW, R1, IMM16(256),
+    OP_LCONSB, R0, 0,
+    OP_LCONSW, R2, IMM16(DATA),
+    OP_LCONSW, R3, IMM16(DATA + 0x400),
+    OP_LCONS, T1, IMM32(0x40000000),
+    OP_I2F, T2, R0, // 24
+    OP_STOR_P, R2, T2,
+    OP_STOR_P, R3, T1,
+    OP_ADD, R2, R2, T0,
+    OP_ADD, R3, R3, T0,
+    OP_INC, R0,
+    OP_JB, R0, R1, IMM16(24),
+    OP_LCONSB, T5, 16,
+    OP_LCONSB, T6, 64,
+    OP_LCONSW, T7, IMM16(DATA + 0x800),
+    OP_LCONSW, T8, IMM16(DATA),
+    OP_LCONSB, R0, 0,
+    OP_LCONSB, R1, 0, // 65
+    OP_LCONSW, T9, IMM16(DATA + 0x400),
+    OP_LCONSB, T1, 0, // 72
+    OP_MOV, R3, T8,
+    OP_MOV, R4, T9,
+    OP_LCONSB, R2, 16,
+    OP_LOAD_P, T2, R3, // 84
+    OP_LOAD_P, T3, R4,
+    OP_FMUL, T2, T2, T3,
+    OP_FADD, T1, T1, T2,
+    OP_ADD, R3, R3, T0,
+    OP_ADD, R4, R4, T6,
+    OP_DEC, R2,
+    OP_JNZ, R2, IMM16(84),
+    OP_STOR_P, T7, T1,
+    OP_ADD, T7, T7, T0,
+    OP_ADD, T9, T9, T0,
+    OP_INC, R1,
+    OP_JB, R1, T5, IMM16(72),
+    OP_ADD, T8, T8, T6,
+    OP_INC, R0,
+    OP_JB, R0, T5, IMM16(65),
+    OP_HALT};
+
+static uint8_t printProgram[] = {
+    OP_LCONSW, R0, IMM16(1000),
+    OP_PRINTS, IMM16(16), // 4
+    OP_PRINTLN,
+    OP_DEC, R0,
+    OP_JNZ, R0, IMM16(4),
+    OP_HALT,
+    OP_NOP,
+    'h', 'e', 'l', 'l', 'o', ',', ' ', 'm', 'i', 'c', 'r', 'o', 'B', 'y', 't', 'e', 'V', 'M', '\0'}; // 16
+
+static float floatAt(VM &vm, uint16_t addr)
+{
+    float value;
+    memcpy(&value, vm.memory(addr), sizeof(value));
+    return value;
+}
+
+static bool checkLoop(VM &vm) { return vm.getRegister(R0) == 0; }
+static bool checkFib(VM &vm) { return vm.getRegister(R1) == 75025; }
+static bool checkClamp(VM &vm)
+{
+    uint32_t x = 0, sum = 0;
+    for (uint32_t i = 0; i < MICRO_LOOPS; i++)
+    {
+        x = x * 1103515245 + 12345;
+        sum += x < CLAMP_LIMIT ? x : CLAMP_LIMIT;
+    }
+    return vm.getRegister(R3) == sum;
+}
+static bool checkDispatch(VM &vm)
+{
+    uint32_t x = 0, sum = 0;
+    for (uint32_t i = 0; i < MICRO_LOOPS; i++)
+    {
+        x = x * 1103515245 + 12345;
+        sum += (x >> 30) + 1;
+    }
+    return vm.getRegister(R3) == sum;
+}
+static bool checkCrc32c(VM &vm)
+{
+    uint32_t crc = 0;
+    for (uint32_t i = 0; i < CHECKSUM_PASSES; i++)
+        crc = crc32c(crc, vm.memory(DATA), CHECKSUM_BYTES);
+    return vm.getRegister(R1) == crc;
+}
+static bool checkFnv1a(VM &vm)
+{
+    const uint8_t *data = vm.memory(DATA);
+    uint32_t hash = 2166136261U;
+    for (uint32_t i = 0; i < CHECKSUM_PASSES; i++)
+        for (uint32_t j = 0; j < CHECKSUM_BYTES; j++)
+            hash = (hash ^ data[j]) * 16777619;
+    return vm.getRegister(R1) == hash;
+}
+static bool checkSieve(VM &vm) { return vm.getRegister(R5) == 5133; }
+static bool checkSort(VM &vm) { return *(uint32_t *)vm.memory(DATA) == 1 && *(uint32_t *)vm.memory(DATA + 299 * 4) == 300; }
+static bool checkMatmul(VM &vm) { return floatAt(vm, DATA + 0x800) == 240.0f && floatAt(vm, DATA + 0x800 + 64) == 752.0f; }
+
+struct Benchmark
+{
+    const char *name;
+    uint8_t *program;
+    uint16_t progLen;
+    bool (*check)(VM &vm);
+};
+
+static const Benchmark BENCHMARKS[] = {
+    {"add", addLoop, sizeof(addLoop), checkLoop},
+    {"addi", addImmLoop, sizeof(addImmLoop), checkLoop},
+    {"addq", addQwordLoop, sizeof(addQwordLoop), checkLoop},
+    {"load_p", loadLoop, sizeof(loadLoop), checkLoop},
+    {"push_pop", pushPopLoop, sizeof(pushPopLoop), checkLoop},
+    {"call_ret", callLoop, sizeof(callLoop), checkLoop},
+    {"jnz", branchLoop, sizeof(branchLoop), checkLoop},
+    {"djnz", djnzLoop, sizeof(djnzLoop), checkLoop},
+    {"clamp_branch", clampBranchLoop, sizeof(clampBranchLoop), checkClamp},
+    {"clamp_cmov", clampCmovLoop, sizeof(clampCmovLoop), checkClamp},
+    {"clamp_min", clampMinLoop, sizeof(clampMinLoop), checkClamp},
+    {"switch", switchLoop, sizeof(switchLoop), checkDispatch},
+    {"compare_chain", compareChainLoop, sizeof(compareChainLoop), checkDispatch},
+    {"crc32c", crc32cLoop, sizeof(crc32cLoop), checkCrc32c},
+    {"fnv1a_bytes", fnv1aLoop, sizeof(fnv1aLoop), checkFnv1a},
+    {"fib", fibProgram, sizeof(fibProgram), checkFib},
+    {"fib_framed", fibFramedProgram, sizeof(fibFramedProgram), checkFib},
+    {"sieve", sieveProgram, sizeof(sieveProgram), checkSieve},
+    {"bubble_sort", sortProgram, sizeof(sortProgram), checkSort},
+    {"bubble_sort_d", sortDispProgram, sizeof(sortDispProgram), checkSort},
+    {"matmul_f", matmulProgram, sizeof(matmulProgram), checkMatmul},
+    {"prints", printProgram, sizeof(printProgram), checkLoop},
+};
+
+static uint64_t nowNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    // usage: vmbench [name_filter] [repetitions]
+    const char *filter = argc > 1 ? argv[1] : "";
+    const int reps = argc > 2 ? atoi(argv[2]) : 10;
+    if (reps < 1)
+    {
+        printf("Usage: %s [name_filter] [repetitions]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *sink = fopen("/dev/null", "w");
+    FILE *out = fopen("bench_output.txt", "w");
+    if (sink == nullptr || out == nullptr)
+    {
+        perror("vmbench");
+        return 1;
+    }
+    fprintf(out, "name\tinstructions\tmean_ns\tstdev_ns\tmin_ns\tns_per_op\tminstr_per_sec\tipc\thost_per_op\tbranch_miss_pct\n");
+    printf("%-12s %12s %12s %8s %9s %12s\n", "benchmark", "instructions", "mean ms", "stdev %", "ns/op", "Minstr/s");
+
+    // host counters are reported as "-" when there is no PMU to read them from
+    PerfCounters perf;
+    const bool hostIpc = perf.available(PERF_CYCLES) && perf.available(PERF_INSTRUCTIONS);
+    const bool hostBranches = perf.available(PERF_BRANCHES) && perf.available(PERF_BRANCH_MISSES);
+
+    int failures = 0;
+    for (const Benchmark &bench : BENCHMARKS)
+    {
+        if (strstr(bench.name, filter) == nullptr)
+            continue;
+
+        VM vm(bench.program, bench.progLen, STACK_SIZE);
+        vm.setOutput(sink);
+
+        // the calibration run counts instructions, the profile includes the halt
+        OpcodeProfile profile;
+        vm.attachProfile(&profile);
+        const ExecResult result = vm.run();
+        vm.attachProfile(nullptr);
+        const uint64_t instructions = profile.total();
+        if (result != ExecResult::VM_FINISHED || !bench.check(vm))
+        {
+            printf("%-12s FAILED (result %d)\n", bench.name, result);
+            failures++;
+            continue;
+        }
+
+        std::vector<double> times;
+        for (int r = -1; r < reps; r++)
+        {
+            vm.reset();
+            const uint64_t begin = nowNs();
+            vm.run();
+            const uint64_t elapsed = nowNs() - begin;
+            // the first run only warms up the caches
+            if (r >= 0)
+                times.push_back(elapsed);
+        }
+
+        double mean = 0, variance = 0, best = times[0];
+        for (double t : times)
+        {
+            mean += t / times.size();
+            best = t < best ? t : best;
+        }
+        for (double t : times)
+            variance += (t - mean) * (t - mean) / times.size();
+        const double stdev = sqrt(variance);
+        const double nsPerOp = mean / instructions;
+
+        vm.reset();
+        const uint32_t hash = hashProgram(bench.program, bench.progLen);
+        perf.run(&vm, hash);
+        const PerfStats &host = *perf.stats(&vm, hash);
+        char ipc[16] = "-", hostPerOp[16] = "-", branchMisses[16] = "-";
+        if (hostIpc)
+        {
+            snprintf(ipc, sizeof(ipc), "%.3f", host.ipc());
+            snprintf(hostPerOp, sizeof(hostPerOp), "%.2f", host.hostPerRetired());
+        }
+        if (hostBranches && host.values[PERF_BRANCHES] != 0)
+            snprintf(branchMisses, sizeof(branchMisses), "%.3f",
+                     100.0 * host.values[PERF_BRANCH_MISSES] / host.values[PERF_BRANCHES]);
+
+        printf("%-12s %12llu %12.3f %8.2f %9.3f %12.1f", bench.name, (unsigned long long)instructions, mean / 1e6,
+               100.0 * stdev / mean, nsPerOp, 1e3 / nsPerOp);
+        if (hostIpc || hostBranches)
+            printf("   ipc %s, host instr/op %s, branch misses %s%%", ipc, hostPerOp, branchMisses);
+        printf("\n");
+        fprintf(out, "%s\t%llu\t%.0f\t%.0f\t%.0f\t%.4f\t%.2f\t%s\t%s\t%s\n", bench.name, (unsigned long long)instructions,
+                mean, stdev, best, nsPerOp, 1e3 / nsPerOp, ipc, hostPerOp, branchMisses);
+    }
+
+    fclose(out);
+    fclose(sink);
+    return failures == 0 ? 0 : 1;
+}
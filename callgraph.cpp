@@ -0,0 +1,175 @@
+#include "callgraph.h"
+
+#include <set>
+
+CallGraphProfiler::CallGraphProfiler()
+{
+    this->reset();
+}
+
+void CallGraphProfiler::reset()
+{
+    this->_functions.clear();
+    this->_index.clear();
+    this->_edges.clear();
+    this->_edgeIndex.clear();
+    this->_stack.clear();
+    this->_instructions = 0;
+    this->_cycles = 0;
+
+    const Frame root = {this->lookup(0), 0, 0, 0};
+    this->_functions[root.function].calls = 1;
+    this->_functions[root.function].active = 1;
+    this->_stack.push_back(root);
+}
+
+uint32_t CallGraphProfiler::lookup(uint16_t entry)
+{
+    std::map<uint16_t, uint32_t>::iterator it = this->_index.find(entry);
+    if (it != this->_index.end())
+        return it->second;
+
+    CallGraphFunction function;
+    memset(&function, 0, sizeof(function));
+    function.entry = entry;
+    this->_functions.push_back(function);
+    this->_index[entry] = this->_functions.size() - 1;
+    return this->_functions.size() - 1;
+}
+
+void CallGraphProfiler::enter(uint16_t site, uint16_t target)
+{
+    const uint32_t caller = this->_stack.back().function;
+    const uint32_t callee = this->lookup(target);
+
+    const std::tuple<uint32_t, uint16_t, uint32_t> key(caller, site, callee);
+    std::map<std::tuple<uint32_t, uint16_t, uint32_t>, uint32_t>::iterator it = this->_edgeIndex.find(key);
+    if (it == this->_edgeIndex.end())
+    {
+        const CallGraphEdge edge = {caller, site, callee, 0, 0, 0};
+        this->_edges.push_back(edge);
+        it = this->_edgeIndex.insert(std::make_pair(key, (uint32_t)this->_edges.size() - 1)).first;
+    }
+
+    this->_edges[it->second].calls++;
+    this->_functions[callee].calls++;
+    this->_functions[callee].active++;
+    const Frame frame = {callee, it->second, this->_instructions, this->_cycles};
+    this->_stack.push_back(frame);
+}
+
+void CallGraphProfiler::leave()
+{
+    // a return without a matching call, e.g. through a RA set by hand
+    if (this->_stack.size() == 1)
+        return;
+
+    const Frame frame = this->_stack.back();
+    this->_stack.pop_back();
+
+    const uint64_t instructions = this->_instructions - frame.instructions;
+    const uint64_t cycles = this->_cycles - frame.cycles;
+    CallGraphEdge &edge = this->_edges[frame.edge];
+    edge.inclusiveInstructions += instructions;
+    edge.inclusiveCycles += cycles;
+
+    CallGraphFunction &function = this->_functions[frame.function];
+    if (--function.active == 0)
+    {
+        function.inclusiveInstructions += instructions;
+        function.inclusiveCycles += cycles;
+    }
+}
+
+void CallGraphProfiler::tail(uint16_t site, uint16_t target)
+{
+    // the callee takes the place of the frame on top, as if its caller had
+    // called it from the same site; from the entry it is an ordinary call
+    if (this->_stack.size() > 1)
+    {
+        site = this->_edges[this->_stack.back().edge].site;
+        this->leave();
+    }
+    this->enter(site, target);
+}
+
+void CallGraphProfiler::unwind()
+{
+    while (this->_stack.size() > 1)
+        this->leave();
+
+    CallGraphFunction &root = this->_functions[this->_stack.back().function];
+    root.inclusiveInstructions = this->_instructions;
+    root.inclusiveCycles = this->_cycles;
+}
+
+bool CallGraphProfiler::loadLabels(const char *path)
+{
+    return this->_labels.load(path);
+}
+
+void CallGraphProfiler::addLabel(uint16_t addr, const char *name)
+{
+    this->_labels.add(addr, name);
+}
+
+const CallGraphFunction *CallGraphProfiler::function(uint16_t entry)
+{
+    std::map<uint16_t, uint32_t>::iterator it = this->_index.find(entry);
+    return it == this->_index.end() ? nullptr : &this->_functions[it->second];
+}
+
+uint64_t CallGraphProfiler::edgeCalls(uint16_t caller, uint16_t callee)
+{
+    uint64_t calls = 0;
+    for (const CallGraphEdge &edge : this->_edges)
+        if (this->_functions[edge.caller].entry == caller && this->_functions[edge.callee].entry == callee)
+            calls += edge.calls;
+    return calls;
+}
+
+uint64_t CallGraphProfiler::instructions()
+{
+    return this->_instructions;
+}
+
+uint64_t CallGraphProfiler::cycles()
+{
+    return this->_cycles;
+}
+
+void CallGraphProfiler::writeCallgrind(FILE *out)
+{
+    this->unwind();
+
+    fprintf(out, "# callgrind format\n");
+    fprintf(out, "version: 1\ncreator: microByteVM\npositions: instr\nevents: Instructions Cycles\n");
+    fprintf(out, "summary: %llu %llu\n\nfl=(1) bytecode\n", (unsigned long long)this->_instructions,
+            (unsigned long long)this->_cycles);
+
+    // names are compressed: spelled out on first use, referenced by id afterwards
+    std::set<uint32_t> named;
+    auto name = [&](uint32_t function) {
+        if (named.insert(function).second)
+            return "(" + std::to_string(function + 1) + ") " + this->_labels.symbol(this->_functions[function].entry, true);
+        return "(" + std::to_string(function + 1) + ")";
+    };
+
+    for (uint32_t f = 0; f < this->_functions.size(); f++)
+    {
+        const CallGraphFunction &function = this->_functions[f];
+        fprintf(out, "\nfn=%s\n", name(f).c_str());
+        fprintf(out, "0x%04x %llu %llu\n", function.entry, (unsigned long long)function.selfInstructions,
+                (unsigned long long)function.selfCycles);
+
+        for (const CallGraphEdge &edge : this->_edges)
+        {
+            if (edge.caller != f)
+                continue;
+            fprintf(out, "cfn=%s\n", name(edge.callee).c_str());
+            fprintf(out, "calls=%llu 0x%04x\n", (unsigned long long)edge.calls, this->_functions[edge.callee].entry);
+            fprintf(out, "0x%04x %llu %llu\n", edge.site, (unsigned long long)edge.inclusiveInstructions,
+                    (unsigned long long)edge.inclusiveCycles);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef __CALLGRAPH_H__
+#define __CALLGRAPH_H__
+
+#include "vm.h"
+#include "labels.h"
+#include "opcodes.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+struct CallGraphFunction
+{
+    uint16_t entry;
+    uint64_t calls;
+    uint64_t selfInstructions;
+    uint64_t selfCycles;
+    // recursive activations are only counted once, by the outermost one
+    uint64_t inclusiveInstructions;
+    uint64_t inclusiveCycles;
+    uint32_t active; // activations currently on the shadow stack
+};
+
+struct CallGraphEdge
+{
+    uint32_t caller;
+    uint16_t site; // address of the call instruction
+    uint32_t callee;
+    uint64_t calls;
+    uint64_t inclusiveInstructions;
+    uint64_t inclusiveCycles;
+};
+
+// Call-graph profiler. A shadow stack follows the VM's calls and returns, so
+// every retired instruction and its cycles are charged to the function on top
+// and, once the call returns, to every caller to callee edge below it.
+// Functions are identified by entry address, address 0 being the program
+// entry, and named through an optional label map. The result is written in
+// callgrind format for KCachegrind, QCachegrind or callgrind_annotate.
+class CallGraphProfiler
+{
+  public:
+    CallGraphProfiler();
+
+    inline void retire(uint16_t ip, uint8_t flags, uint16_t next, uint64_t cycles)
+    {
+        CallGraphFunction &current = this->_functions[this->_stack.back().function];
+        current.selfInstructions++;
+        current.selfCycles += cycles;
+        this->_instructions++;
+        this->_cycles += cycles;
+
+        if (flags & OPF_CALL)
+            this->enter(ip, next);
+        else if (flags & OPF_RETURN)
+            this->leave();
+        else if (flags & OPF_TAILCALL)
+            this->tail(ip, next);
+    }
+
+    void reset();
+    // closes the frames still open, e.g. after a HALT inside a call; run
+    // this before reading the inclusive costs of an unfinished run
+    void unwind();
+
+    bool loadLabels(const char *path);
+    void addLabel(uint16_t addr, const char *name);
+
+    // nullptr for functions that were never called
+    const CallGraphFunction *function(uint16_t entry);
+    uint64_t edgeCalls(uint16_t caller, uint16_t callee);
+    uint64_t instructions();
+    uint64_t cycles();
+
+    // unwinds, then writes every function and call edge
+    void writeCallgrind(FILE *out);
+
+  protected:
+    struct Frame
+    {
+        uint32_t function;
+        uint32_t edge;
+        uint64_t instructions; // totals when the frame was entered
+        uint64_t cycles;
+    };
+
+    uint32_t lookup(uint16_t entry);
+    void enter(uint16_t site, uint16_t target);
+    void leave();
+    void tail(uint16_t site, uint16_t target);
+
+    std::vector<CallGraphFunction> _functions;
+    std::map<uint16_t, uint32_t> _index; // entry address to function
+    std::vector<CallGraphEdge> _edges;
+    std::map<std::tuple<uint32_t, uint16_t, uint32_t>, uint32_t> _edgeIndex;
+    std::vector<Frame> _stack; // the bottom frame is the program entry and never leaves
+    uint64_t _instructions = 0;
+    uint64_t _cycles = 0;
+    LabelMap _labels;
+};
+
+#endif // __CALLGRAPH_H__
@@ -0,0 +1,114 @@
+#include "checksum.h"
+
+#include <string.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+uint32_t crc32c(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+#if defined(__SSE4_2__)
+    uint64_t crc64 = crc;
+    for (; len >= 8; len -= 8, data += 8)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, data, sizeof(chunk));
+        crc64 = _mm_crc32_u64(crc64, chunk);
+    }
+    crc = (uint32_t)crc64;
+    for (; len > 0; len--)
+        crc = _mm_crc32_u8(crc, *data++);
+#else
+    for (; len > 0; len--)
+    {
+        crc ^= *data++;
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0x82F63B78U & -(crc & 1));
+    }
+#endif
+    return ~crc;
+}
+
+uint32_t adler32(uint32_t adler, const uint8_t *data, size_t len)
+{
+    // the largest run of bytes whose sums cannot overflow before the modulo
+    const size_t NMAX = 5552;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (len > 0)
+    {
+        const size_t run = len < NMAX ? len : NMAX;
+        len -= run;
+        for (size_t i = 0; i < run; i++)
+        {
+            a += data[i];
+            b += a;
+        }
+        data += run;
+        a %= 65521;
+        b %= 65521;
+    }
+    return b << 16 | a;
+}
+
+uint32_t fletcher32(uint32_t sums, const uint8_t *data, size_t len)
+{
+    // the largest run of words whose sums cannot overflow before the modulo
+    const size_t WMAX = 359;
+    uint32_t a = sums & 0xFFFF;
+    uint32_t b = sums >> 16;
+    while (len > 0)
+    {
+        const size_t run = len < 2 * WMAX ? len : 2 * WMAX;
+        len -= run;
+        size_t i = 0;
+        for (; i + 1 < run; i += 2)
+        {
+            a += data[i] | data[i + 1] << 8;
+            b += a;
+        }
+        if (i < run)
+        {
+            a += data[i];
+            b += a;
+        }
+        data += run;
+        a %= 65535;
+        b %= 65535;
+    }
+    return b << 16 | a;
+}
+
+uint64_t hash64(uint64_t seed, const uint8_t *data, size_t len)
+{
+    const uint64_t m = 0xC6A4A7935BD1E995ULL;
+    const int r = 47;
+    uint64_t h = seed ^ (len * m);
+
+    for (; len >= 8; len -= 8, data += 8)
+    {
+        uint64_t k;
+        memcpy(&k, data, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    if (len > 0)
+    {
+        uint64_t tail = 0;
+        for (size_t i = 0; i < len; i++)
+            tail |= (uint64_t)data[i] << (8 * i);
+        h ^= tail;
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
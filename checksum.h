@@ -0,0 +1,22 @@
+#ifndef __CHECKSUM_H__
+#define __CHECKSUM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Checksums and hashes over byte ranges. Each takes the value of the
+// previous range, so a long input can be processed in chunks.
+
+// CRC32C (Castagnoli), using the SSE4.2 crc32 instruction when available;
+// start from 0
+uint32_t crc32c(uint32_t crc, const uint8_t *data, size_t len);
+// Adler-32 as in zlib; start from 1
+uint32_t adler32(uint32_t adler, const uint8_t *data, size_t len);
+// Fletcher-32 over little-endian 16-bit words, an odd last byte padded with
+// zero; start from 0, and only chunk at even lengths
+uint32_t fletcher32(uint32_t sums, const uint8_t *data, size_t len);
+// MurmurHash64A, eight bytes per multiply; not cryptographic, and chaining
+// chunks through the seed gives a different value than hashing them at once
+uint64_t hash64(uint64_t seed, const uint8_t *data, size_t len);
+
+#endif // __CHECKSUM_H__
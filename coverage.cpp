@@ -0,0 +1,120 @@
+#include "coverage.h"
+#include "opcodes.h"
+
+#include <algorithm>
+
+struct CoverageFileHeader
+{
+    uint32_t magic;
+    uint32_t hash;
+    uint32_t blocks;
+};
+
+BlockCoverage::BlockCoverage(std::shared_ptr<const Program> program)
+    : _program(program), _leaders(program->leaders.data()), _slots(program->length(), 0)
+{
+    for (uint32_t ip = 0; ip < program->length(); ip++)
+        if (program->isLeader(ip))
+        {
+            this->_starts.push_back(ip);
+            this->_slots[ip] = this->_starts.size();
+        }
+    this->_counts.assign(this->_starts.size() + 1, 0);
+}
+
+void BlockCoverage::reset()
+{
+    std::fill(this->_counts.begin(), this->_counts.end(), 0);
+}
+
+bool BlockCoverage::merge(const BlockCoverage &other)
+{
+    if (other._program->hash != this->_program->hash || other._counts.size() != this->_counts.size())
+        return false;
+
+    for (size_t slot = 1; slot < this->_counts.size(); slot++)
+    {
+        const uint64_t sum = (uint64_t)this->_counts[slot] + other._counts[slot];
+        this->_counts[slot] = sum < UINT32_MAX ? sum : UINT32_MAX;
+    }
+    return true;
+}
+
+const Program &BlockCoverage::program()
+{
+    return *this->_program;
+}
+
+uint32_t BlockCoverage::blockCount()
+{
+    return this->_starts.size();
+}
+
+uint16_t BlockCoverage::blockStart(uint32_t block)
+{
+    return this->_starts[block];
+}
+
+uint32_t BlockCoverage::count(uint32_t block)
+{
+    return this->_counts[block + 1];
+}
+
+uint32_t BlockCoverage::covered()
+{
+    return this->_counts.size() - 1 - std::count(this->_counts.begin() + 1, this->_counts.end(), 0);
+}
+
+bool BlockCoverage::save(FILE *out)
+{
+    CoverageFileHeader header = {COVERAGE_MAGIC, this->_program->hash, this->blockCount()};
+    return fwrite(&header, sizeof(header), 1, out) == 1 &&
+           fwrite(&this->_counts[1], sizeof(uint32_t), header.blocks, out) == header.blocks;
+}
+
+bool BlockCoverage::load(FILE *in)
+{
+    CoverageFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != COVERAGE_MAGIC ||
+        header.hash != this->_program->hash || header.blocks != this->blockCount())
+        return false;
+
+    BlockCoverage saved(this->_program);
+    if (fread(&saved._counts[1], sizeof(uint32_t), header.blocks, in) != header.blocks)
+        return false;
+    return this->merge(saved);
+}
+
+void BlockCoverage::writeReport(FILE *out, uint32_t top)
+{
+    std::vector<uint32_t> order(this->blockCount());
+    for (uint32_t b = 0; b < order.size(); b++)
+        order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return this->_counts[a + 1] > this->_counts[b + 1];
+    });
+
+    uint64_t total = 0;
+    for (size_t slot = 1; slot < this->_counts.size(); slot++)
+        total += this->_counts[slot];
+
+    const Program &program = *this->_program;
+    fprintf(out, "%u of %u blocks covered, %llu block entries\n", this->covered(), this->blockCount(),
+            (unsigned long long)total);
+    fprintf(out, "%-6s %-12s %-8s %-13s %s\n", "rank", "entries", "share", "block", "first instruction");
+
+    char text[64];
+    for (uint32_t rank = 0; rank < order.size() && (top == 0 || rank < top); rank++)
+    {
+        const uint32_t block = order[rank];
+        const uint32_t count = this->_counts[block + 1];
+        if (count == 0)
+            break;
+
+        const uint32_t start = this->_starts[block];
+        const uint32_t end = block + 1 < this->_starts.size() ? this->_starts[block + 1] : program.length();
+        disassemble(program.code.data(), program.length(), start, text, sizeof(text));
+        fprintf(out, "%-6u %-12u %6.2f%%  0x%04x-0x%04x %s\n", rank + 1, count, 100.0 * count / total, start,
+                end - 1, text);
+    }
+}
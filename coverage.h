@@ -0,0 +1,56 @@
+#ifndef __COVERAGE_H__
+#define __COVERAGE_H__
+
+#include "vm.h"
+#include "program.h"
+
+#include <memory>
+#include <vector>
+
+#define COVERAGE_MAGIC 0x5643424D // "MBCV"
+
+// Basic-block coverage of a program. Blocks are the leaders found by the
+// Program analysis (entry, jump and call targets, branch fall-throughs); the
+// VM bumps a saturating counter whenever execution reaches one, so a block
+// costs one increment per entry rather than one per instruction. Blocks only
+// reached through JR are not known statically and are not counted.
+class BlockCoverage
+{
+  public:
+    BlockCoverage(std::shared_ptr<const Program> program);
+
+    inline void enter(uint32_t ip)
+    {
+        // called for every instruction, so most calls leave at the leader bitmap
+        if (ip >= this->_slots.size() || ((this->_leaders[ip >> 3] >> (ip & 7)) & 1) == 0)
+            return;
+        uint32_t &count = this->_counts[this->_slots[ip]];
+        count += count != UINT32_MAX;
+    }
+
+    void reset();
+    // adds the counts of other, which must cover the same program
+    bool merge(const BlockCoverage &other);
+
+    const Program &program();
+    uint32_t blockCount();
+    uint16_t blockStart(uint32_t block);
+    uint32_t count(uint32_t block);
+    uint32_t covered();
+
+    // counts accumulate across processes by saving after a run and loading,
+    // which merges, before the next one
+    bool save(FILE *out);
+    bool load(FILE *in);
+    // blocks ranked by entry count, disassembled from their first instruction
+    void writeReport(FILE *out, uint32_t top = 0);
+
+  protected:
+    std::shared_ptr<const Program> _program;
+    const uint8_t *_leaders;       // the program's leader bitmap
+    std::vector<uint16_t> _starts; // block start address, by block number
+    std::vector<uint16_t> _slots;  // address to counter slot, by leader address
+    std::vector<uint32_t> _counts; // slot 0 is unused, block b counts in slot b + 1
+};
+
+#endif // __COVERAGE_H__
@@ -0,0 +1,107 @@
+#include "heatmap.h"
+
+#include <math.h>
+
+MemoryHeatmap::MemoryHeatmap(uint16_t progLen, uint16_t stackSize, uint32_t window)
+    : _progLen(progLen), _memSize(progLen + stackSize), _window(window > 0 ? window : 1)
+{
+    this->reset();
+}
+
+void MemoryHeatmap::reset()
+{
+    const uint32_t lines = (this->_memSize + HEATMAP_LINE - 1) / HEATMAP_LINE;
+    this->_reads.assign(lines, 0);
+    this->_writes.assign(lines, 0);
+    this->_stamp.assign(lines, 0);
+    this->_workingSet.clear();
+    this->_epoch = 1;
+    this->_windowInstructions = 0;
+    this->_windowLines = 0;
+    this->_lowestSp = this->_memSize;
+}
+
+void MemoryHeatmap::closeWindow()
+{
+    this->_workingSet.push_back(this->_windowLines);
+    this->_windowInstructions = 0;
+    this->_windowLines = 0;
+    this->_epoch++;
+}
+
+uint32_t MemoryHeatmap::lineCount()
+{
+    return this->_reads.size();
+}
+
+uint64_t MemoryHeatmap::reads(uint32_t line)
+{
+    return this->_reads[line];
+}
+
+uint64_t MemoryHeatmap::writes(uint32_t line)
+{
+    return this->_writes[line];
+}
+
+const std::vector<uint32_t> &MemoryHeatmap::workingSet()
+{
+    return this->_workingSet;
+}
+
+uint32_t MemoryHeatmap::stackHighWater()
+{
+    return this->_memSize - this->_lowestSp;
+}
+
+void MemoryHeatmap::writeMap(FILE *out, const char *title, const std::vector<uint64_t> &counts)
+{
+    static const char SHADES[] = " .:-=+*#%@";
+    const int levels = sizeof(SHADES) - 2;
+
+    uint64_t max = 0;
+    for (uint64_t count : counts)
+        max = count > max ? count : max;
+
+    fprintf(out, "%s (log scale, '@' = %llu accesses per line)\n", title, (unsigned long long)max);
+    for (uint32_t row = 0; row < counts.size(); row += 64)
+    {
+        fprintf(out, "0x%04x |", row * HEATMAP_LINE);
+        for (uint32_t line = row; line < row + 64 && line < counts.size(); line++)
+        {
+            int shade = 0;
+            if (counts[line] > 0)
+                shade = max == 1 ? levels : 1 + (int)((levels - 1) * log((double)counts[line]) / log((double)max));
+            fputc(SHADES[shade], out);
+        }
+        fprintf(out, "|\n");
+    }
+}
+
+void MemoryHeatmap::writeHeatmap(FILE *out)
+{
+    fprintf(out, "memory 0x0000-0x%04x, program below 0x%04x, %d bytes per character\n", this->_memSize - 1,
+            this->_progLen, HEATMAP_LINE);
+    this->writeMap(out, "reads", this->_reads);
+    this->writeMap(out, "writes", this->_writes);
+    fprintf(out, "stack high-water mark: %u of %u bytes\n", this->stackHighWater(), this->_memSize - this->_progLen);
+}
+
+void MemoryHeatmap::writeCsv(FILE *out)
+{
+    fprintf(out, "line,address,reads,writes\n");
+    for (uint32_t line = 0; line < this->_reads.size(); line++)
+        if (this->_reads[line] != 0 || this->_writes[line] != 0)
+            fprintf(out, "%u,0x%04x,%llu,%llu\n", line, line * HEATMAP_LINE, (unsigned long long)this->_reads[line],
+                    (unsigned long long)this->_writes[line]);
+}
+
+void MemoryHeatmap::writeWorkingSet(FILE *out)
+{
+    fprintf(out, "window,instructions,lines,bytes\n");
+    for (uint32_t w = 0; w < this->_workingSet.size(); w++)
+        fprintf(out, "%u,%u,%u,%u\n", w, this->_window, this->_workingSet[w], this->_workingSet[w] * HEATMAP_LINE);
+    if (this->_windowInstructions > 0)
+        fprintf(out, "%u,%u,%u,%u\n", (uint32_t)this->_workingSet.size(), this->_windowInstructions, this->_windowLines,
+                this->_windowLines * HEATMAP_LINE);
+}
@@ -0,0 +1,87 @@
+#ifndef __HEATMAP_H__
+#define __HEATMAP_H__
+
+#include "vm.h"
+
+#include <vector>
+
+#define HEATMAP_LINE 64
+
+// Memory access profile of a VM: read and write counts per 64-byte line of
+// its memory from the load, store, memcpy and stack opcodes, the number of
+// distinct lines touched per window of retired instructions (the working set
+// over time) and the deepest the stack went.
+class MemoryHeatmap
+{
+  public:
+    // progLen and stackSize as given to the VM
+    MemoryHeatmap(uint16_t progLen, uint16_t stackSize = 256, uint32_t window = 1000);
+
+    inline void read(uint32_t addr, uint32_t len)
+    {
+        this->touch(this->_reads, addr, len);
+    }
+
+    inline void write(uint32_t addr, uint32_t len)
+    {
+        this->touch(this->_writes, addr, len);
+    }
+
+    inline void retire(uint32_t sp)
+    {
+        if (sp < this->_lowestSp)
+            this->_lowestSp = sp;
+        if (++this->_windowInstructions == this->_window)
+            this->closeWindow();
+    }
+
+    void reset();
+
+    uint32_t lineCount();
+    uint64_t reads(uint32_t line);
+    uint64_t writes(uint32_t line);
+    // lines touched in each completed window
+    const std::vector<uint32_t> &workingSet();
+    // deepest stack use in bytes, the smallest stackSize the runs fit in
+    uint32_t stackHighWater();
+
+    // one character per line, 64 lines (4 KB) per row, reads and writes apart
+    void writeHeatmap(FILE *out);
+    void writeCsv(FILE *out);
+    // window number, lines and bytes touched, including the unfinished window
+    void writeWorkingSet(FILE *out);
+
+  protected:
+    inline void touch(std::vector<uint64_t> &counts, uint32_t addr, uint32_t len)
+    {
+        if (len == 0)
+            return;
+        const uint32_t last = (addr + len - 1) / HEATMAP_LINE;
+        for (uint32_t line = addr / HEATMAP_LINE; line <= last && line < counts.size(); line++)
+        {
+            counts[line]++;
+            if (this->_stamp[line] != this->_epoch)
+            {
+                this->_stamp[line] = this->_epoch;
+                this->_windowLines++;
+            }
+        }
+    }
+
+    void closeWindow();
+    void writeMap(FILE *out, const char *title, const std::vector<uint64_t> &counts);
+
+    const uint32_t _progLen;
+    const uint32_t _memSize;
+    const uint32_t _window;
+    std::vector<uint64_t> _reads;
+    std::vector<uint64_t> _writes;
+    std::vector<uint32_t> _stamp; // window in which each line was last touched
+    std::vector<uint32_t> _workingSet;
+    uint32_t _epoch;
+    uint32_t _windowInstructions;
+    uint32_t _windowLines;
+    uint32_t _lowestSp;
+};
+
+#endif // __HEATMAP_H__
@@ -0,0 +1,50 @@
+#include "labels.h"
+
+bool LabelMap::load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr)
+        return false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+        char *end;
+        const unsigned long addr = strtoul(line, &end, 0);
+        if (end == line)
+            continue;
+        while (*end == ' ' || *end == '\t' || *end == ':')
+            end++;
+        end[strcspn(end, "\r\n")] = '\0';
+        if (*end != '\0')
+            this->add(addr, end);
+    }
+    fclose(f);
+    return true;
+}
+
+void LabelMap::add(uint16_t addr, const char *name)
+{
+    this->_labels[addr] = name;
+}
+
+std::string LabelMap::symbol(uint16_t addr, bool exact) const
+{
+    std::map<uint16_t, std::string>::const_iterator it = this->_labels.upper_bound(addr);
+    if (it != this->_labels.begin())
+    {
+        --it;
+        if (it->first == addr)
+            return it->second;
+        if (!exact)
+        {
+            char offset[16];
+            snprintf(offset, sizeof(offset), "+0x%x", addr - it->first);
+            return it->second + offset;
+        }
+    }
+
+    char hex[8];
+    snprintf(hex, sizeof(hex), "0x%04x", addr);
+    return hex;
+}
@@ -0,0 +1,24 @@
+#ifndef __LABELS_H__
+#define __LABELS_H__
+
+#include "vm.h"
+
+#include <map>
+#include <string>
+
+// Address to name map used by the profilers to symbolize code addresses.
+// Files hold one "<address> <name>" per line, the address in C notation.
+class LabelMap
+{
+  public:
+    bool load(const char *path);
+    void add(uint16_t addr, const char *name);
+    // exact lookups fall back to the hex address, others to the nearest
+    // label before addr plus an offset
+    std::string symbol(uint16_t addr, bool exact) const;
+
+  protected:
+    std::map<uint16_t, std::string> _labels;
+};
+
+#endif // __LABELS_H__
@@ -0,0 +1,146 @@
+#include "vm.h"
+#include "protocol.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Load generator for vmserver: opens several connections, sends the same
+// program over and over and reports requests/sec and latency percentiles.
+
+static uint8_t defaultProgram[] = {
+    OP_LCONSB, R0, 0,
+    OP_LCONSB, R1, 100,
+    OP_PRINT, R0, 1,
+    OP_INC, R0,
+    OP_JNE, R0, R1, 6, 0,
+    OP_HALT};
+
+static uint64_t nowNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool request(int fd, const std::vector<uint8_t> &program, ResultFrame &result)
+{
+    RequestHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = VM_PROTOCOL_MAGIC;
+    header.progLen = program.size();
+    header.stackSize = 256;
+    if (!writeFull(fd, &header, sizeof(header)) || !writeFull(fd, program.data(), program.size()))
+        return false;
+
+    std::vector<uint8_t> payload;
+    while (true)
+    {
+        FrameHeader frame;
+        if (!readFull(fd, &frame, sizeof(frame)))
+            return false;
+        payload.resize(frame.length);
+        if (!readFull(fd, payload.data(), frame.length))
+            return false;
+        if (frame.type == FRAME_ERROR)
+            return false;
+        if (frame.type == FRAME_RESULT)
+        {
+            memcpy(&result, payload.data(), std::min(sizeof(result), payload.size()));
+            return true;
+        }
+    }
+}
+
+static void client(const char *path, const std::vector<uint8_t> &program, uint32_t count,
+                   std::vector<uint64_t> &latencies, uint32_t &errors)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        errors += count;
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ResultFrame result;
+        const uint64_t start = nowNs();
+        if (!request(fd, program, result) || result.result != ExecResult::VM_FINISHED)
+        {
+            errors++;
+            continue;
+        }
+        latencies.push_back(nowNs() - start);
+    }
+    close(fd);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s socket_path [requests] [connections] [bin_file]\n", argv[0]);
+        return 1;
+    }
+    const uint32_t requests = argc > 2 ? atoi(argv[2]) : 10000;
+    const uint32_t connections = argc > 3 ? std::max(1, atoi(argv[3])) : 4;
+
+    std::vector<uint8_t> program(defaultProgram, defaultProgram + sizeof(defaultProgram));
+    if (argc > 4)
+    {
+        FILE *f = fopen(argv[4], "rb");
+        if (f == nullptr)
+        {
+            perror(argv[4]);
+            return 1;
+        }
+        fseek(f, 0, SEEK_END);
+        program.resize(ftell(f));
+        rewind(f);
+        if (fread(program.data(), 1, program.size(), f) != program.size())
+            program.clear();
+        fclose(f);
+    }
+
+    std::vector<std::vector<uint64_t>> latencies(connections);
+    std::vector<uint32_t> errors(connections, 0);
+    std::vector<std::thread> clients;
+
+    const uint64_t start = nowNs();
+    for (uint32_t c = 0; c < connections; c++)
+    {
+        const uint32_t count = requests / connections + (c < requests % connections ? 1 : 0);
+        clients.push_back(std::thread(client, argv[1], std::cref(program), count,
+                                      std::ref(latencies[c]), std::ref(errors[c])));
+    }
+    for (size_t c = 0; c < clients.size(); c++)
+        clients[c].join();
+    const double elapsed = (nowNs() - start) / 1e9;
+
+    std::vector<uint64_t> all;
+    uint32_t failed = 0;
+    for (uint32_t c = 0; c < connections; c++)
+    {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        failed += errors[c];
+    }
+    std::sort(all.begin(), all.end());
+
+    printf("requests: %zu ok, %u failed in %.3f s\n", all.size(), failed, elapsed);
+    printf("throughput: %.0f requests/sec\n", all.size() / elapsed);
+    if (!all.empty())
+        printf("latency: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+               all[all.size() / 2] / 1e3, all[(all.size() * 99) / 100] / 1e3, all.back() / 1e3);
+    return failed != 0;
+}
@@ -1,4 +1,16 @@
 #include "vm.h"
+#include "batch.h"
+#include "scheduler.h"
+#include "program.h"
+#include "opprofile.h"
+#include "sampler.h"
+#include "trace.h"
+#include "coverage.h"
+#include "perfcounters.h"
+#include "callgraph.h"
+#include "heatmap.h"
+#include "vmstats.h"
+#include "replay.h"
 #include "teste.cpp"
 
 int run_binary(int argc, char *argv[])
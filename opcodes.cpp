@@ -0,0 +1,343 @@
+#include "opcodes.h"
+
+const OpInfo OP_INFO[] = {
+    // system:
+    {"nop", "", OPF_NONE},
+    {"halt", "", OPF_NOFALL},
+    {"int", "b", OPF_NONE},
+    // constants:
+    {"lcons", "ri", OPF_NONE},
+    {"lconsw", "rw", OPF_NONE},
+    {"lconsb", "rb", OPF_NONE},
+    // register operations:
+    {"mov", "rr", OPF_NONE},
+    // stack:
+    {"push", "r", OPF_NONE},
+    {"pop", "r", OPF_NONE},
+    {"pop2", "rr", OPF_NONE},
+    {"dup", "", OPF_NONE},
+    // functions
+    {"call", "j", OPF_BRANCH | OPF_CALL},
+    {"ret", "", OPF_NOFALL | OPF_RETURN | OPF_DYNAMIC},
+    // memory:
+    {"stor", "ar", OPF_NONE},
+    {"stor_p", "rr", OPF_NONE},
+    {"storw", "ar", OPF_NONE},
+    {"storw_p", "rr", OPF_NONE},
+    {"storb", "ar", OPF_NONE},
+    {"storb_p", "rr", OPF_NONE},
+    {"load", "ra", OPF_NONE},
+    {"load_p", "rr", OPF_NONE},
+    {"loadw", "ra", OPF_NONE},
+    {"loadw_p", "rr", OPF_NONE},
+    {"loadb", "ra", OPF_NONE},
+    {"loadb_p", "rr", OPF_NONE},
+    {"memcpy", "aaw", OPF_NONE},
+    {"memcpy_p", "rrr", OPF_NONE},
+    // arithmetic:
+    {"inc", "r", OPF_NONE},
+    {"incf", "r", OPF_NONE},
+    {"dec", "r", OPF_NONE},
+    {"decf", "r", OPF_NONE},
+    {"add", "rrr", OPF_NONE},
+    {"addf", "rrr", OPF_NONE},
+    {"sub", "rrr", OPF_NONE},
+    {"subf", "rrr", OPF_NONE},
+    {"mul", "rrr", OPF_NONE},
+    {"imul", "rrr", OPF_NONE},
+    {"mulf", "rrr", OPF_NONE},
+    {"div", "rrr", OPF_NONE},
+    {"idiv", "rrr", OPF_NONE},
+    {"divf", "rrr", OPF_NONE},
+    {"shl", "rrr", OPF_NONE},
+    {"shr", "rrr", OPF_NONE},
+    {"ishr", "rrr", OPF_NONE},
+    {"mod", "rrr", OPF_NONE},
+    {"imod", "rrr", OPF_NONE},
+    {"and", "rrr", OPF_NONE},
+    {"or", "rrr", OPF_NONE},
+    {"xor", "rrr", OPF_NONE},
+    {"not", "rr", OPF_NONE},
+    // conversions:
+    {"u2i", "r", OPF_NONE},
+    {"i2u", "r", OPF_NONE},
+    {"i2f", "rr", OPF_NONE},
+    {"f2i", "rr", OPF_NONE},
+    // branching:
+    {"jmp", "j", OPF_NOFALL | OPF_BRANCH},
+    {"jr", "r", OPF_NOFALL | OPF_DYNAMIC},
+    {"jz", "rj", OPF_BRANCH},
+    {"jnz", "rj", OPF_BRANCH},
+    {"je", "rrj", OPF_BRANCH},
+    {"jne", "rrj", OPF_BRANCH},
+    {"ja", "rrj", OPF_BRANCH},
+    {"jg", "rrj", OPF_BRANCH},
+    {"jae", "rrj", OPF_BRANCH},
+    {"jge", "rrj", OPF_BRANCH},
+    {"jb", "rrj", OPF_BRANCH},
+    {"jl", "rrj", OPF_BRANCH},
+    {"jbe", "rrj", OPF_BRANCH},
+    {"jle", "rrj", OPF_BRANCH},
+    // strings:
+    {"print", "rb", OPF_NONE},
+    {"printi", "rb", OPF_NONE},
+    {"printf", "rb", OPF_NONE},
+    {"printc", "r", OPF_NONE},
+    {"prints", "a", OPF_NONE},
+    {"println", "", OPF_NONE},
+    {"read", "r", OPF_NONE},
+    {"readi", "r", OPF_NONE},
+    {"readf", "r", OPF_NONE},
+    {"readc", "r", OPF_NONE},
+    {"reads", "aw", OPF_NONE},
+    // arithmetic with an immediate:
+    {"addi", "rri", OPF_NONE},
+    {"addib", "rrb", OPF_NONE},
+    {"subi", "rri", OPF_NONE},
+    {"subib", "rrb", OPF_NONE},
+    {"muli", "rri", OPF_NONE},
+    {"mulib", "rrb", OPF_NONE},
+    {"divi", "rri", OPF_NONE},
+    {"divib", "rrb", OPF_NONE},
+    {"idivi", "rri", OPF_NONE},
+    {"modi", "rri", OPF_NONE},
+    {"modib", "rrb", OPF_NONE},
+    {"imodi", "rri", OPF_NONE},
+    {"shlib", "rrb", OPF_NONE},
+    {"shrib", "rrb", OPF_NONE},
+    {"ishrib", "rrb", OPF_NONE},
+    {"andi", "rri", OPF_NONE},
+    {"andib", "rrb", OPF_NONE},
+    {"ori", "rri", OPF_NONE},
+    {"orib", "rrb", OPF_NONE},
+    {"xori", "rri", OPF_NONE},
+    {"xorib", "rrb", OPF_NONE},
+    {"addfi", "rri", OPF_NONE},
+    {"subfi", "rri", OPF_NONE},
+    {"mulfi", "rri", OPF_NONE},
+    {"divfi", "rri", OPF_NONE},
+    // branching on an immediate:
+    {"jei", "rij", OPF_BRANCH},
+    {"jnei", "rij", OPF_BRANCH},
+    {"jai", "rij", OPF_BRANCH},
+    {"jgi", "rij", OPF_BRANCH},
+    {"jaei", "rij", OPF_BRANCH},
+    {"jgei", "rij", OPF_BRANCH},
+    {"jbi", "rij", OPF_BRANCH},
+    {"jli", "rij", OPF_BRANCH},
+    {"jbei", "rij", OPF_BRANCH},
+    {"jlei", "rij", OPF_BRANCH},
+    {"djnz", "rj", OPF_BRANCH},
+    // relative branching:
+    {"jmp_s", "o", OPF_NOFALL | OPF_BRANCH},
+    {"jz_s", "ro", OPF_BRANCH},
+    {"jnz_s", "ro", OPF_BRANCH},
+    {"djnz_s", "ro", OPF_BRANCH},
+    // stack frames:
+    {"callf", "j", OPF_BRANCH | OPF_CALL},
+    {"retf", "", OPF_NOFALL | OPF_RETURN | OPF_DYNAMIC},
+    {"enter", "w", OPF_NONE},
+    {"leave", "", OPF_NONE},
+    {"tailcall", "j", OPF_NOFALL | OPF_BRANCH | OPF_TAILCALL},
+    // addressing modes:
+    {"load_d", "rrd", OPF_NONE},
+    {"loadw_d", "rrd", OPF_NONE},
+    {"loadb_d", "rrd", OPF_NONE},
+    {"stor_d", "rdr", OPF_NONE},
+    {"storw_d", "rdr", OPF_NONE},
+    {"storb_d", "rdr", OPF_NONE},
+    {"load_x", "rrrb", OPF_NONE},
+    {"loadw_x", "rrrb", OPF_NONE},
+    {"loadb_x", "rrrb", OPF_NONE},
+    {"stor_x", "rrbr", OPF_NONE},
+    {"storw_x", "rrbr", OPF_NONE},
+    {"storb_x", "rrbr", OPF_NONE},
+    {"load_pi", "rr", OPF_NONE},
+    {"loadw_pi", "rr", OPF_NONE},
+    {"loadb_pi", "rr", OPF_NONE},
+    {"stor_pi", "rr", OPF_NONE},
+    {"storw_pi", "rr", OPF_NONE},
+    {"storb_pi", "rr", OPF_NONE},
+    {"memcpy_d", "rdrdr", OPF_NONE},
+    {"memcpy_x", "rrrbr", OPF_NONE},
+    {"memcpy_pi", "rrr", OPF_NONE},
+    // 64-bit integers and doubles:
+    {"movq", "rr", OPF_NONE},
+    {"lconsq", "rii", OPF_NONE},
+    {"loadq", "ra", OPF_NONE},
+    {"loadq_d", "rrd", OPF_NONE},
+    {"storq", "ar", OPF_NONE},
+    {"storq_d", "rdr", OPF_NONE},
+    {"addq", "rrr", OPF_NONE},
+    {"subq", "rrr", OPF_NONE},
+    {"mulq", "rrr", OPF_NONE},
+    {"divq", "rrr", OPF_NONE},
+    {"idivq", "rrr", OPF_NONE},
+    {"modq", "rrr", OPF_NONE},
+    {"imodq", "rrr", OPF_NONE},
+    {"andq", "rrr", OPF_NONE},
+    {"orq", "rrr", OPF_NONE},
+    {"xorq", "rrr", OPF_NONE},
+    {"shlq", "rrr", OPF_NONE},
+    {"shrq", "rrr", OPF_NONE},
+    {"ishrq", "rrr", OPF_NONE},
+    {"cmpq", "rrr", OPF_NONE},
+    {"ucmpq", "rrr", OPF_NONE},
+    {"dadd", "rrr", OPF_NONE},
+    {"dsub", "rrr", OPF_NONE},
+    {"dmul", "rrr", OPF_NONE},
+    {"ddiv", "rrr", OPF_NONE},
+    {"dcmp", "rrr", OPF_NONE},
+    {"sexq", "rr", OPF_NONE},
+    {"zexq", "rr", OPF_NONE},
+    {"i2d", "rr", OPF_NONE},
+    {"d2i", "rr", OPF_NONE},
+    {"f2d", "rr", OPF_NONE},
+    {"d2f", "rr", OPF_NONE},
+    {"q2d", "rr", OPF_NONE},
+    {"d2q", "rr", OPF_NONE},
+    {"q2f", "rr", OPF_NONE},
+    {"f2q", "rr", OPF_NONE},
+    {"printq", "rb", OPF_NONE},
+    {"printd", "rb", OPF_NONE},
+    // bit manipulation:
+    {"popcnt", "rr", OPF_NONE},
+    {"clz", "rr", OPF_NONE},
+    {"ctz", "rr", OPF_NONE},
+    {"bswap", "rr", OPF_NONE},
+    {"rol", "rrr", OPF_NONE},
+    {"ror", "rrr", OPF_NONE},
+    {"rolib", "rrb", OPF_NONE},
+    {"rorib", "rrb", OPF_NONE},
+    {"bext", "rrbb", OPF_NONE},
+    {"bins", "rrbb", OPF_NONE},
+    // conditional selection:
+    {"cmov", "rrcrr", OPF_NONE},
+    {"cmovi", "rrcri", OPF_NONE},
+    {"select", "rrrcrr", OPF_NONE},
+    {"selecti", "rrrcri", OPF_NONE},
+    {"min", "rrr", OPF_NONE},
+    {"max", "rrr", OPF_NONE},
+    {"imin", "rrr", OPF_NONE},
+    {"imax", "rrr", OPF_NONE},
+    // multiway dispatch:
+    {"switch", "rwj", OPF_NOFALL | OPF_BRANCH | OPF_TABLE},
+    // checksums:
+    {"crc32c", "rrr", OPF_NONE},
+    {"hash64", "rrr", OPF_NONE},
+    {"adler32", "rrr", OPF_NONE},
+    {"fletcher32", "rrr", OPF_NONE},
+    // float math:
+    {"fma", "rrrr", OPF_NONE},
+    {"fsqrt", "rr", OPF_NONE},
+    {"fabs", "rr", OPF_NONE},
+    {"fneg", "rr", OPF_NONE},
+    {"fmin", "rrr", OPF_NONE},
+    {"fmax", "rrr", OPF_NONE},
+    {"ffloor", "rr", OPF_NONE},
+    {"fceil", "rr", OPF_NONE},
+    {"fround", "rr", OPF_NONE},
+    {"jfe", "rrj", OPF_BRANCH},
+    {"jfne", "rrj", OPF_BRANCH},
+    {"jfg", "rrj", OPF_BRANCH},
+    {"jfge", "rrj", OPF_BRANCH},
+    {"jfl", "rrj", OPF_BRANCH},
+    {"jfle", "rrj", OPF_BRANCH},
+};
+
+static_assert(sizeof(OP_INFO) / sizeof(OP_INFO[0]) == INSTRUCTION_COUNT, "OP_INFO must describe every instruction");
+
+static const char *REGISTER_NAMES[] = {
+    "r0", "r1", "r2", "r3", "r4", "r5",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7", "t8", "t9",
+    "ip", "bp", "sp", "ra"};
+
+static_assert(sizeof(REGISTER_NAMES) / sizeof(REGISTER_NAMES[0]) == REGISTER_COUNT, "REGISTER_NAMES must name every register");
+
+static const char *CONDITION_NAMES[] = {
+    "e", "ne", "a", "g", "ae", "ge", "b", "l", "be", "le",
+    "fe", "fne", "fg", "fge", "fl", "fle"};
+
+static_assert(sizeof(CONDITION_NAMES) / sizeof(CONDITION_NAMES[0]) == CONDITION_COUNT, "CONDITION_NAMES must name every condition");
+
+uint8_t operandSize(char kind)
+{
+    switch (kind)
+    {
+    case 'r':
+    case 'b':
+    case 'c':
+    case 'o':
+        return 1;
+    case 'w':
+    case 'd':
+    case 'a':
+    case 'j':
+        return 2;
+    case 'i':
+        return 4;
+    }
+    return 0;
+}
+
+uint8_t instructionLength(uint8_t op)
+{
+    if (op >= INSTRUCTION_COUNT)
+        return 0;
+
+    uint8_t len = 1;
+    for (const char *kind = OP_INFO[op].operands; *kind != '\0'; kind++)
+        len += operandSize(*kind);
+    return len;
+}
+
+const char *registerName(uint8_t reg)
+{
+    return reg < REGISTER_COUNT ? REGISTER_NAMES[reg] : "r?";
+}
+
+uint8_t disassemble(const uint8_t *program, uint32_t progLen, uint32_t ip, char *out, size_t outLen)
+{
+    const uint8_t len = ip < progLen ? instructionLength(program[ip]) : 0;
+    if (len == 0 || ip + len > progLen)
+    {
+        snprintf(out, outLen, ".byte 0x%02x", ip < progLen ? program[ip] : 0);
+        return 0;
+    }
+
+    const OpInfo &info = OP_INFO[program[ip]];
+    int used = snprintf(out, outLen, "%s", info.name);
+    uint32_t pos = ip + 1;
+    for (const char *kind = info.operands; *kind != '\0' && used >= 0 && (size_t)used < outLen; kind++)
+    {
+        const char *sep = kind == info.operands ? " " : ", ";
+        uint32_t value = 0;
+        for (uint8_t b = 0; b < operandSize(*kind); b++)
+            value |= (uint32_t)program[pos + b] << (8 * b);
+        switch (*kind)
+        {
+        case 'r':
+            used += snprintf(out + used, outLen - used, "%s%s", sep, registerName(value));
+            break;
+        case 'c':
+            used += snprintf(out + used, outLen - used, "%s%s", sep, value < CONDITION_COUNT ? CONDITION_NAMES[value] : "c?");
+            break;
+        case 'a':
+        case 'j':
+            used += snprintf(out + used, outLen - used, "%s0x%04x", sep, value);
+            break;
+        case 'o':
+            // shown as the address it jumps to
+            used += snprintf(out + used, outLen - used, "%s0x%04x", sep, (uint16_t)(ip + (int8_t)value));
+            break;
+        case 'd':
+            used += snprintf(out + used, outLen - used, "%s%d", sep, (int16_t)value);
+            break;
+        default:
+            used += snprintf(out + used, outLen - used, "%s%u", sep, value);
+            break;
+        }
+        pos += operandSize(*kind);
+    }
+    return len;
+}
@@ -0,0 +1,46 @@
+#ifndef __OPCODES_H__
+#define __OPCODES_H__
+
+#include "vm.h"
+
+// Operand kinds, one character per operand in OpInfo::operands:
+//   'r' register (1 byte)
+//   'b' immediate byte (1 byte)
+//   'c' condition code, see Condition (1 byte)
+//   'w' immediate word (2 bytes)
+//   'd' displacement added to a base register (2 bytes, signed)
+//   'i' immediate int (4 bytes)
+//   'a' memory address (2 bytes)
+//   'j' jump or call target (2 bytes)
+//   'o' jump offset from the address of the instruction (1 signed byte)
+
+enum OpFlags : uint8_t
+{
+    OPF_NONE = 0,
+    OPF_NOFALL = 1 << 0,  // execution never continues at the next instruction
+    OPF_BRANCH = 1 << 1,  // may transfer control to its 'j' or 'o' operand
+    OPF_CALL = 1 << 2,    // calls its 'j' operand and later returns to the next instruction
+    OPF_RETURN = 1 << 3,  // returns from a call
+    OPF_DYNAMIC = 1 << 4, // transfers control to an address only known at run time
+    OPF_TAILCALL = 1 << 5, // replaces the current call with a call to its 'j' operand
+    OPF_TABLE = 1 << 6,    // followed by a table of as many 2-byte targets as its 'w' operand
+};
+
+struct OpInfo
+{
+    const char *name;     // assembler mnemonic
+    const char *operands; // operand kinds, see above
+    uint8_t flags;        // OpFlags
+};
+
+extern const OpInfo OP_INFO[INSTRUCTION_COUNT];
+
+uint8_t operandSize(char kind);
+// length of the instruction including the opcode byte, 0 for unknown opcodes
+uint8_t instructionLength(uint8_t op);
+const char *registerName(uint8_t reg);
+// writes the instruction at ip as "mnemonic operand, ..." into out and returns
+// its length, or 0 when the opcode is unknown or runs past the end of program
+uint8_t disassemble(const uint8_t *program, uint32_t progLen, uint32_t ip, char *out, size_t outLen);
+
+#endif // __OPCODES_H__
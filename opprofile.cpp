@@ -0,0 +1,93 @@
+#include "opprofile.h"
+#include "opcodes.h"
+
+OpcodeProfile::OpcodeProfile()
+{
+    this->reset();
+}
+
+void OpcodeProfile::reset()
+{
+    memset(this->_counts, 0, sizeof(this->_counts));
+    memset(this->_cycles, 0, sizeof(this->_cycles));
+    memset(this->_histogram, 0, sizeof(this->_histogram));
+}
+
+void OpcodeProfile::merge(const OpcodeProfile &other)
+{
+    for (uint32_t op = 0; op < INSTRUCTION_COUNT; op++)
+    {
+        this->_counts[op] += other._counts[op];
+        this->_cycles[op] += other._cycles[op];
+        for (uint32_t b = 0; b < OPPROFILE_BUCKETS; b++)
+            this->_histogram[op][b] += other._histogram[op][b];
+    }
+}
+
+uint64_t OpcodeProfile::count(Instruction op)
+{
+    return this->_counts[op];
+}
+
+uint64_t OpcodeProfile::cycles(Instruction op)
+{
+    return this->_cycles[op];
+}
+
+uint64_t OpcodeProfile::histogram(Instruction op, uint8_t bucket)
+{
+    return this->_histogram[op][bucket];
+}
+
+uint64_t OpcodeProfile::total()
+{
+    uint64_t sum = 0;
+    for (uint32_t op = 0; op < INSTRUCTION_COUNT; op++)
+        sum += this->_counts[op];
+    return sum;
+}
+
+void OpcodeProfile::writeJson(FILE *out)
+{
+    bool first = true;
+
+    fprintf(out, "{\"instructions\": [");
+    for (uint32_t op = 0; op < INSTRUCTION_COUNT; op++)
+    {
+        if (this->_counts[op] == 0)
+            continue;
+
+        // trailing empty buckets are left out
+        uint32_t buckets = OPPROFILE_BUCKETS;
+        while (buckets > 0 && this->_histogram[op][buckets - 1] == 0)
+            buckets--;
+
+        fprintf(out, "%s\n  {\"op\": \"%s\", \"count\": %llu, \"cycles\": %llu, \"histogram\": [",
+                first ? "" : ",", OP_INFO[op].name, (unsigned long long)this->_counts[op],
+                (unsigned long long)this->_cycles[op]);
+        for (uint32_t b = 0; b < buckets; b++)
+            fprintf(out, "%s%llu", b == 0 ? "" : ", ", (unsigned long long)this->_histogram[op][b]);
+        fprintf(out, "]}");
+        first = false;
+    }
+    fprintf(out, "\n]}\n");
+}
+
+void OpcodeProfile::writeCsv(FILE *out)
+{
+    fprintf(out, "op,count,cycles,cycles_per_op");
+    for (uint32_t b = 0; b < OPPROFILE_BUCKETS; b++)
+        fprintf(out, ",lt_%llu", 1ULL << b);
+    fprintf(out, "\n");
+
+    for (uint32_t op = 0; op < INSTRUCTION_COUNT; op++)
+    {
+        if (this->_counts[op] == 0)
+            continue;
+        fprintf(out, "%s,%llu,%llu,%.2f", OP_INFO[op].name, (unsigned long long)this->_counts[op],
+                (unsigned long long)this->_cycles[op], (double)this->_cycles[op] / this->_counts[op]);
+        for (uint32_t b = 0; b < OPPROFILE_BUCKETS; b++)
+            fprintf(out, ",%llu", (unsigned long long)this->_histogram[op][b]);
+        fprintf(out, "\n");
+    }
+}
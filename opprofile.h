@@ -0,0 +1,61 @@
+#ifndef __OPPROFILE_H__
+#define __OPPROFILE_H__
+
+#include "vm.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#define OPPROFILE_BUCKETS 32
+
+// cheapest monotonic counter available: the TSC on x86, nanoseconds elsewhere
+static inline uint64_t cycleCounter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+// Retired count, total cycles and a log2 cycle histogram per instruction.
+// The instruction a run ends on is counted too: a halt, a faulting instruction,
+// or an interrupt that finishes the run or leaves it pending.
+// Bucket b holds the executions that took [2^(b-1), 2^b) cycles, bucket 0 the
+// ones that took none; the last bucket also collects everything above it.
+class OpcodeProfile
+{
+  public:
+    OpcodeProfile();
+
+    inline void record(uint8_t op, uint64_t cycles)
+    {
+        const uint32_t bucket = cycles == 0 ? 0 : 64 - __builtin_clzll(cycles);
+        this->_counts[op]++;
+        this->_cycles[op] += cycles;
+        this->_histogram[op][bucket < OPPROFILE_BUCKETS ? bucket : OPPROFILE_BUCKETS - 1]++;
+    }
+
+    void reset();
+    void merge(const OpcodeProfile &other);
+
+    uint64_t count(Instruction op);
+    uint64_t cycles(Instruction op);
+    uint64_t histogram(Instruction op, uint8_t bucket);
+    uint64_t total();
+
+    void writeJson(FILE *out);
+    void writeCsv(FILE *out);
+
+  protected:
+    uint64_t _counts[INSTRUCTION_COUNT];
+    uint64_t _cycles[INSTRUCTION_COUNT];
+    uint64_t _histogram[INSTRUCTION_COUNT][OPPROFILE_BUCKETS];
+};
+
+#endif // __OPPROFILE_H__
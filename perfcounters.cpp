@@ -0,0 +1,166 @@
+#include "perfcounters.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const char *EVENT_NAMES[] = {"cycles", "instructions", "branches", "branch_misses", "itlb_misses", "task_clock_ns"};
+
+static_assert(sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]) == PERF_EVENT_COUNT, "EVENT_NAMES must name every event");
+
+static int openEvent(PerfEvent event, int leader)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    // members follow the leader, which enables and disables the whole group
+    attr.disabled = leader < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (event)
+    {
+    case PERF_CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_BRANCHES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_INSTRUCTIONS;
+        break;
+    case PERF_BRANCH_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    case PERF_ITLB_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_ITLB | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+        break;
+    default:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_TASK_CLOCK;
+        break;
+    }
+
+    // this thread, any CPU
+    return syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+double PerfStats::ipc() const
+{
+    return this->values[PERF_CYCLES] == 0 ? 0 : (double)this->values[PERF_INSTRUCTIONS] / this->values[PERF_CYCLES];
+}
+
+double PerfStats::hostPerRetired() const
+{
+    return this->retired == 0 ? 0 : (double)this->values[PERF_INSTRUCTIONS] / this->retired;
+}
+
+PerfCounters::PerfCounters()
+{
+    for (uint8_t e = 0; e < PERF_EVENT_COUNT; e++)
+    {
+        this->_fds[e] = openEvent((PerfEvent)e, this->_leader);
+        if (this->_fds[e] < 0)
+            continue;
+        if (this->_leader < 0)
+            this->_leader = this->_fds[e];
+        this->_slots[e] = this->_open++;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (uint8_t e = 0; e < PERF_EVENT_COUNT; e++)
+        if (this->_fds[e] >= 0)
+            close(this->_fds[e]);
+}
+
+bool PerfCounters::available()
+{
+    for (uint8_t e = 0; e < PERF_EVENT_COUNT; e++)
+        if (this->_fds[e] >= 0)
+            return true;
+    return false;
+}
+
+bool PerfCounters::available(PerfEvent event)
+{
+    return this->_fds[event] >= 0;
+}
+
+ExecResult PerfCounters::run(VM *vm, uint32_t programHash, uint32_t maxInstr)
+{
+    PerfStats &stats = this->_stats[Key(vm, programHash)];
+    const uint64_t retired = vm->retired();
+
+    if (this->_leader >= 0)
+    {
+        ioctl(this->_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(this->_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    const ExecResult result = vm->run(maxInstr);
+
+    // event count, time enabled, time running, then one value per event
+    uint64_t group[3 + PERF_EVENT_COUNT];
+    const ssize_t groupLen = (3 + this->_open) * sizeof(uint64_t);
+    if (this->_leader >= 0)
+        ioctl(this->_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (this->_leader >= 0 && read(this->_leader, group, sizeof(group)) == groupLen)
+    {
+        // the group is scheduled as a unit: scale up when the PMU was multiplexed
+        const double scale = group[2] != 0 && group[2] < group[1] ? (double)group[1] / group[2] : 1.0;
+        for (uint8_t e = 0; e < PERF_EVENT_COUNT; e++)
+            if (this->_fds[e] >= 0)
+                stats.values[e] += (uint64_t)(group[3 + this->_slots[e]] * scale);
+    }
+    stats.retired += vm->retired() - retired;
+    stats.runs++;
+    return result;
+}
+
+const PerfStats *PerfCounters::stats(VM *vm, uint32_t programHash)
+{
+    std::map<Key, PerfStats>::iterator it = this->_stats.find(Key(vm, programHash));
+    return it == this->_stats.end() ? nullptr : &it->second;
+}
+
+void PerfCounters::reset()
+{
+    this->_stats.clear();
+}
+
+void PerfCounters::writeReport(FILE *out)
+{
+    fprintf(out, "vm,program,runs,retired");
+    for (uint8_t e = 0; e < PERF_EVENT_COUNT; e++)
+        if (this->_fds[e] >= 0)
+            fprintf(out, ",%s", EVENT_NAMES[e]);
+    if (this->available(PERF_CYCLES) && this->available(PERF_INSTRUCTIONS))
+        fprintf(out, ",ipc,host_per_retired");
+    if (this->available(PERF_BRANCHES) && this->available(PERF_BRANCH_MISSES))
+        fprintf(out, ",branch_miss_rate");
+    fprintf(out, "\n");
+
+    for (std::map<Key, PerfStats>::iterator it = this->_stats.begin(); it != this->_stats.end(); ++it)
+    {
+        const PerfStats &stats = it->second;
+        fprintf(out, "%p,%08x,%llu,%llu", (void *)it->first.first, it->first.second, (unsigned long long)stats.runs,
+                (unsigned long long)stats.retired);
+        for (uint8_t e = 0; e < PERF_EVENT_COUNT; e++)
+            if (this->_fds[e] >= 0)
+                fprintf(out, ",%llu", (unsigned long long)stats.values[e]);
+        if (this->available(PERF_CYCLES) && this->available(PERF_INSTRUCTIONS))
+            fprintf(out, ",%.3f,%.2f", stats.ipc(), stats.hostPerRetired());
+        if (this->available(PERF_BRANCHES) && this->available(PERF_BRANCH_MISSES))
+            fprintf(out, ",%.4f", stats.values[PERF_BRANCHES] == 0 ? 0 : (double)stats.values[PERF_BRANCH_MISSES] / stats.values[PERF_BRANCHES]);
+        fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef __PERFCOUNTERS_H__
+#define __PERFCOUNTERS_H__
+
+#include "vm.h"
+
+#include <map>
+#include <utility>
+
+enum PerfEvent : uint8_t
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCHES,
+    PERF_BRANCH_MISSES,
+    PERF_ITLB_MISSES,
+    PERF_TASK_CLOCK, // software, nanoseconds on the CPU: available without a PMU
+    PERF_EVENT_COUNT
+};
+
+// Host counters accumulated over the runs of one VM on one program
+struct PerfStats
+{
+    uint64_t runs;
+    uint64_t retired;                   // VM instructions retired
+    uint64_t values[PERF_EVENT_COUNT];  // host events, scaled when multiplexed
+
+    double ipc() const;
+    // host instructions spent per retired VM instruction
+    double hostPerRetired() const;
+};
+
+// Hardware counters opened with perf_event_open for the calling thread, user
+// space only, and enabled around VM::run. The events form one group led by
+// cycles (or the first event that opens), so the kernel schedules them onto
+// the PMU together and one read returns counts over the same interval; ratios
+// such as IPC stay consistent when counters are multiplexed. Counts are
+// attributed to the VM
+// instance and a program hash (Program::hash or hashProgram()), so dispatch
+// strategies can be compared on the same workload. Events the kernel or the
+// CPU does not provide are left out; when none can be opened run() still
+// runs the VM and only the retired count is kept. An instance must only be
+// used from the thread that created it.
+class PerfCounters
+{
+  public:
+    PerfCounters();
+    ~PerfCounters();
+
+    bool available();
+    bool available(PerfEvent event);
+
+    ExecResult run(VM *vm, uint32_t programHash, uint32_t maxInstr = 0);
+
+    const PerfStats *stats(VM *vm, uint32_t programHash);
+    void reset();
+    void writeReport(FILE *out);
+
+  protected:
+    typedef std::pair<VM *, uint32_t> Key;
+
+    int _fds[PERF_EVENT_COUNT];
+    int _leader = -1;
+    uint8_t _slots[PERF_EVENT_COUNT]; // position of each open event in a group read
+    uint8_t _open = 0;
+    std::map<Key, PerfStats> _stats;
+};
+
+#endif // __PERFCOUNTERS_H__
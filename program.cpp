@@ -0,0 +1,233 @@
+#include "program.h"
+#include "opcodes.h"
+#include "checksum.h"
+
+#define _BIT_SET(bits, i) bits[(i) >> 3] |= 1 << ((i)&7)
+#define _BIT_TEST(bits, i) ((bits[(i) >> 3] >> ((i)&7)) & 1)
+
+Program::Program(const uint8_t *program, uint16_t progLen)
+    : code(program, program + progLen), hash(hashProgram(program, progLen)), verified(true),
+      starts(progLen / 8 + 1, 0), leaders(progLen / 8 + 1, 0)
+{
+    // bytes holding operands, a jump landing on one of them is not verifiable
+    std::vector<uint8_t> operands(progLen / 8 + 1, 0);
+    std::vector<uint32_t> work(1, 0);
+
+    _BIT_SET(this->leaders, 0);
+    while (!work.empty())
+    {
+        const uint32_t ip = work.back();
+        work.pop_back();
+
+        if (ip >= progLen)
+        {
+            this->verified = false;
+            continue;
+        }
+        if (_BIT_TEST(this->starts, ip))
+            continue;
+        if (_BIT_TEST(operands, ip))
+            this->verified = false;
+
+        const uint8_t op = program[ip];
+        const uint8_t len = instructionLength(op);
+        if (len == 0 || ip + len > progLen)
+        {
+            this->verified = false;
+            continue;
+        }
+
+        _BIT_SET(this->starts, ip);
+        for (uint32_t b = ip + 1; b < ip + len; b++)
+        {
+            if (_BIT_TEST(this->starts, b))
+                this->verified = false;
+            _BIT_SET(operands, b);
+        }
+
+        uint32_t pos = ip + 1;
+        uint32_t entries = 0;
+        for (const char *kind = OP_INFO[op].operands; *kind != '\0'; kind++)
+        {
+            if (*kind == 'w')
+                entries = program[pos] | program[pos + 1] << 8;
+            if (*kind == 'r' && program[pos] >= REGISTER_COUNT)
+                this->verified = false;
+            if (*kind == 'c' && program[pos] >= CONDITION_COUNT)
+                this->verified = false;
+            if (*kind == 'j' || *kind == 'o')
+            {
+                const uint32_t target = *kind == 'j' ? program[pos] | program[pos + 1] << 8
+                                                     : ip + (int8_t)program[pos];
+                if (target < progLen)
+                    _BIT_SET(this->leaders, target);
+                work.push_back(target);
+            }
+            pos += operandSize(*kind);
+        }
+
+        const uint8_t flags = OP_INFO[op].flags;
+        if (flags & OPF_TABLE)
+        {
+            // the table is part of the instruction, and every entry a target
+            if (ip + len + 2 * entries > progLen)
+            {
+                this->verified = false;
+                continue;
+            }
+            for (uint32_t b = ip + len; b < ip + len + 2 * entries; b++)
+            {
+                if (_BIT_TEST(this->starts, b))
+                    this->verified = false;
+                _BIT_SET(operands, b);
+            }
+            for (uint32_t e = 0; e < entries; e++)
+            {
+                const uint32_t entry = ip + len + 2 * e;
+                const uint32_t target = program[entry] | program[entry + 1] << 8;
+                if (target < progLen)
+                    _BIT_SET(this->leaders, target);
+                work.push_back(target);
+            }
+        }
+        if (flags & OPF_NOFALL)
+            continue;
+        if ((flags & (OPF_BRANCH | OPF_CALL)) && ip + len < progLen)
+            _BIT_SET(this->leaders, ip + len);
+        work.push_back(ip + len);
+    }
+}
+
+uint16_t Program::length() const
+{
+    return this->code.size();
+}
+
+bool Program::isStart(uint32_t ip) const
+{
+    return ip < this->code.size() && _BIT_TEST(this->starts, ip);
+}
+
+bool Program::isLeader(uint32_t ip) const
+{
+    return ip < this->code.size() && _BIT_TEST(this->leaders, ip);
+}
+
+size_t Program::footprint() const
+{
+    return sizeof(Program) + this->code.capacity() + this->starts.capacity() + this->leaders.capacity();
+}
+
+uint32_t hashProgram(const uint8_t *program, size_t len)
+{
+    return crc32c(0, program, len);
+}
+
+ProgramCache &ProgramCache::instance()
+{
+    static ProgramCache cache;
+    return cache;
+}
+
+ProgramCache::ProgramCache(size_t budget)
+    : _budget(budget)
+{
+}
+
+std::shared_ptr<const Program> ProgramCache::load(const uint8_t *program, uint16_t progLen, bool *hit)
+{
+    const uint32_t hash = hashProgram(program, progLen);
+    std::shared_ptr<const Program> built;
+
+    // analyze outside the lock, then check again in case another thread won the race
+    for (int pass = 0; pass < 2; pass++)
+    {
+        {
+            std::lock_guard<std::mutex> guard(this->_lock);
+            auto range = this->_index.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                const Program &cached = **it->second;
+                if (cached.length() != progLen || memcmp(cached.code.data(), program, progLen) != 0)
+                    continue;
+                this->_lru.splice(this->_lru.begin(), this->_lru, it->second);
+                if (pass == 0)
+                    this->_hits++;
+                if (hit != nullptr)
+                    *hit = pass == 0;
+                return this->_lru.front();
+            }
+
+            if (built)
+            {
+                this->_lru.push_front(built);
+                this->_index.insert(std::make_pair(hash, this->_lru.begin()));
+                this->_footprint += built->footprint();
+                this->evict();
+                if (hit != nullptr)
+                    *hit = false;
+                return built;
+            }
+            this->_misses++;
+        }
+        built = std::make_shared<const Program>(program, progLen);
+    }
+    return built;
+}
+
+void ProgramCache::evict()
+{
+    // the newest entry stays even when it alone is over budget
+    while (this->_footprint > this->_budget && this->_lru.size() > 1)
+    {
+        const Program &victim = *this->_lru.back();
+        auto range = this->_index.equal_range(victim.hash);
+        for (auto it = range.first; it != range.second; ++it)
+            if (&**it->second == &victim)
+            {
+                this->_index.erase(it);
+                break;
+            }
+        this->_footprint -= victim.footprint();
+        this->_lru.pop_back();
+    }
+}
+
+void ProgramCache::setBudget(size_t budget)
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_budget = budget;
+    this->evict();
+}
+
+void ProgramCache::clear()
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_index.clear();
+    this->_lru.clear();
+    this->_footprint = 0;
+}
+
+size_t ProgramCache::count()
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    return this->_lru.size();
+}
+
+size_t ProgramCache::footprint()
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    return this->_footprint;
+}
+
+uint64_t ProgramCache::hits()
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    return this->_hits;
+}
+
+uint64_t ProgramCache::misses()
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    return this->_misses;
+}
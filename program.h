@@ -0,0 +1,69 @@
+#ifndef __PROGRAM_H__
+#define __PROGRAM_H__
+
+#include "vm.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Load-time products of a program. A Program is built once, then only read,
+// so the same instance can be shared by any number of VMs and threads.
+struct Program
+{
+    std::vector<uint8_t> code;
+    uint32_t hash;
+    // every instruction reachable from address 0 decodes, names valid
+    // registers and stays inside the program, and no static jump or call
+    // target falls outside it or in the middle of another instruction
+    bool verified;
+    std::vector<uint8_t> starts;  // bitmap of reachable instruction starts
+    std::vector<uint8_t> leaders; // bitmap of basic block leaders (entry, jump and call targets, fall-throughs of branches)
+
+    Program(const uint8_t *program, uint16_t progLen);
+
+    uint16_t length() const;
+    bool isStart(uint32_t ip) const;
+    bool isLeader(uint32_t ip) const;
+    size_t footprint() const;
+};
+
+// CRC32C of a byte range, using the SSE4.2 crc32 instruction when available
+uint32_t hashProgram(const uint8_t *program, size_t len);
+
+// Process-wide cache of Programs keyed by content hash. Entries are reference
+// counted, so evicting the least recently used ones to stay under the memory
+// budget never frees a Program that is still in use.
+class ProgramCache
+{
+  public:
+    static ProgramCache &instance();
+
+    ProgramCache(size_t budget = 64 << 20);
+
+    std::shared_ptr<const Program> load(const uint8_t *program, uint16_t progLen, bool *hit = nullptr);
+    void setBudget(size_t budget);
+    void clear();
+
+    size_t count();
+    size_t footprint();
+    uint64_t hits();
+    uint64_t misses();
+
+  protected:
+    typedef std::list<std::shared_ptr<const Program>> LruList;
+
+    void evict();
+
+    std::mutex _lock;
+    LruList _lru; // most recently used first
+    std::unordered_multimap<uint32_t, LruList::iterator> _index;
+    size_t _budget;
+    size_t _footprint = 0;
+    uint64_t _hits = 0;
+    uint64_t _misses = 0;
+};
+
+#endif // __PROGRAM_H__
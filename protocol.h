@@ -0,0 +1,91 @@
+#ifndef __PROTOCOL_H__
+#define __PROTOCOL_H__
+
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Wire format of the VM execution server (little-endian, native layout).
+//
+// A client sends a RequestHeader followed by progLen program bytes and
+// inputLen bytes that the program reads through its READ* instructions. The
+// server answers with a sequence of frames: any number of FRAME_OUTPUT frames
+// carrying what the program printed, then exactly one FRAME_RESULT (or
+// FRAME_ERROR for a malformed request). Several requests may be sent on the
+// same connection, one after the other. Every run is bounded in time: a
+// program still running when its time limit passes ends with VM_DEADLINE.
+
+#define VM_PROTOCOL_MAGIC 0x4D56424DU // "MBVM"
+#define VM_PROTOCOL_MAX_INPUT (16U << 20)
+
+struct RequestHeader
+{
+    uint32_t magic;
+    uint32_t progLen;
+    uint32_t inputLen;
+    uint32_t maxInstr;    // 0 runs until the program halts or the time limit passes
+    uint16_t stackSize;
+    uint16_t timeLimitMs; // 0 uses the server's limit, which also caps larger values
+};
+
+enum FrameType : uint8_t
+{
+    FRAME_OUTPUT, // program output chunk
+    FRAME_RESULT, // a ResultFrame, ends the response
+    FRAME_ERROR,  // an error message, ends the response
+};
+
+struct FrameHeader
+{
+    uint8_t type;
+    uint8_t reserved[3];
+    uint32_t length;
+};
+
+struct ResultFrame
+{
+    uint8_t result; // ExecResult
+    uint8_t cached; // 1 if the program was already loaded by a previous request
+    uint16_t reserved;
+    uint32_t ip;
+};
+
+static inline bool readFull(int fd, void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0)
+    {
+        const ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static inline bool writeFull(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    while (len > 0)
+    {
+        const ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static inline bool writeFrame(int fd, FrameType type, const void *data, uint32_t len)
+{
+    FrameHeader header = {type, {0, 0, 0}, len};
+    return writeFull(fd, &header, sizeof(header)) && writeFull(fd, data, len);
+}
+
+#endif // __PROTOCOL_H__
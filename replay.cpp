@@ -0,0 +1,316 @@
+#include "replay.h"
+
+struct ReplayFileHeader
+{
+    uint32_t magic;
+    uint16_t progLen;
+    uint16_t stackSize;
+    uint32_t registers[REGISTER_COUNT];
+    int32_t regSig;
+    uint8_t flagSig;
+    uint32_t count;
+    uint64_t eventsLen;
+};
+
+// memory runs closer than this are stored as one, which is cheaper than a new run header
+#define REPLAY_MIN_GAP 4
+
+ReplayLog::ReplayLog()
+{
+    this->clear();
+}
+
+void ReplayLog::clear()
+{
+    memset(this->_registers, 0, sizeof(this->_registers));
+    memset(this->_shadowRegisters, 0, sizeof(this->_shadowRegisters));
+    this->_progLen = 0;
+    this->_stackSize = 0;
+    this->_flagSig = false;
+    this->_regSig = 0;
+    this->_memory.clear();
+    this->_events.clear();
+    this->_shadow.clear();
+    this->_count = 0;
+    this->_cursor = 0;
+}
+
+uint32_t ReplayLog::events()
+{
+    return this->_count;
+}
+
+size_t ReplayLog::size()
+{
+    return this->_events.size();
+}
+
+bool ReplayLog::finished()
+{
+    return this->_cursor == this->_events.size();
+}
+
+uint16_t ReplayLog::programLength()
+{
+    return this->_progLen;
+}
+
+uint16_t ReplayLog::stackSize()
+{
+    return this->_stackSize;
+}
+
+uint8_t *ReplayLog::memory()
+{
+    return this->_memory.data();
+}
+
+void ReplayLog::_put(uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        this->_events.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    this->_events.push_back((uint8_t)value);
+}
+
+bool ReplayLog::_get(uint32_t *value)
+{
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        if (this->_cursor >= this->_events.size())
+            return false;
+        const uint8_t byte = this->_events[this->_cursor++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReplayLog::begin(const uint32_t *registers, bool flagSig, int regSig, const uint8_t *memory, uint16_t progLen,
+                      uint16_t stackSize)
+{
+    this->clear();
+    this->_progLen = progLen;
+    this->_stackSize = stackSize;
+    memcpy(this->_registers, registers, sizeof(this->_registers));
+    this->_flagSig = flagSig;
+    this->_regSig = regSig;
+    this->_memory.assign(memory, memory + progLen + stackSize);
+}
+
+void ReplayLog::value(uint32_t value, uint32_t consumed)
+{
+    this->_events.push_back(REPLAY_VALUE);
+    this->_put(value);
+    this->_put(consumed);
+    this->_count++;
+}
+
+void ReplayLog::string(const char *text, uint32_t len)
+{
+    this->_events.push_back(REPLAY_STRING);
+    this->_put(len);
+    this->_events.insert(this->_events.end(), text, text + len);
+    this->_count++;
+}
+
+void ReplayLog::snapshot(const uint32_t *registers, const uint8_t *memory)
+{
+    memcpy(this->_shadowRegisters, registers, sizeof(this->_shadowRegisters));
+    this->_shadow.assign(memory, memory + this->_memory.size());
+}
+
+void ReplayLog::interrupt(uint8_t code, InterruptResult result)
+{
+    this->_events.push_back(REPLAY_INTERRUPT);
+    this->_events.push_back(code);
+    this->_events.push_back(result);
+    this->_count++;
+}
+
+void ReplayLog::state(const uint32_t *registers, const uint8_t *memory)
+{
+    this->_events.push_back(REPLAY_STATE);
+
+    // a mask of the changed registers, then their values
+    uint32_t changed = 0;
+    for (uint32_t r = 0; r < REGISTER_COUNT; r++)
+        if (r != IP && registers[r] != this->_shadowRegisters[r])
+            changed |= 1U << r;
+    this->_put(changed);
+    for (uint32_t r = 0; r < REGISTER_COUNT; r++)
+        if (changed & (1U << r))
+            this->_put(registers[r]);
+
+    // the runs of changed bytes as (gap since the previous run, length, bytes)
+    std::vector<std::pair<uint32_t, uint32_t>> runs;
+    const uint32_t memSize = this->_shadow.size();
+    for (uint32_t addr = 0; addr < memSize; addr++)
+    {
+        if (memory[addr] == this->_shadow[addr])
+            continue;
+        if (!runs.empty() && addr - (runs.back().first + runs.back().second) < REPLAY_MIN_GAP)
+            runs.back().second = addr + 1 - runs.back().first;
+        else
+            runs.push_back(std::make_pair(addr, 1U));
+    }
+    this->_put(runs.size());
+    uint32_t end = 0;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        this->_put(runs[i].first - end);
+        this->_put(runs[i].second);
+        this->_events.insert(this->_events.end(), memory + runs[i].first, memory + runs[i].first + runs[i].second);
+        end = runs[i].first + runs[i].second;
+    }
+    this->_count++;
+}
+
+void ReplayLog::unhandled(uint8_t code)
+{
+    this->_events.push_back(REPLAY_UNHANDLED);
+    this->_events.push_back(code);
+    this->_count++;
+}
+
+bool ReplayLog::restore(uint32_t *registers, bool *flagSig, int *regSig, uint8_t *memory, uint16_t progLen,
+                        uint16_t stackSize)
+{
+    if (progLen != this->_progLen || stackSize != this->_stackSize)
+        return false;
+
+    memcpy(registers, this->_registers, sizeof(this->_registers));
+    *flagSig = this->_flagSig;
+    *regSig = this->_regSig;
+    memcpy(memory, this->_memory.data(), this->_memory.size());
+    this->_cursor = 0;
+    return true;
+}
+
+bool ReplayLog::nextValue(uint32_t *value, uint32_t *consumed)
+{
+    if (this->_cursor >= this->_events.size() || this->_events[this->_cursor] != REPLAY_VALUE)
+        return false;
+    this->_cursor++;
+    return this->_get(value) && this->_get(consumed);
+}
+
+bool ReplayLog::nextString(char *dest, uint32_t maxLen, uint32_t *len)
+{
+    if (this->_cursor >= this->_events.size() || this->_events[this->_cursor] != REPLAY_STRING)
+        return false;
+    this->_cursor++;
+    if (!this->_get(len) || *len >= maxLen || this->_events.size() - this->_cursor < *len)
+        return false;
+
+    memcpy(dest, &this->_events[this->_cursor], *len);
+    dest[*len] = '\0';
+    this->_cursor += *len;
+    return true;
+}
+
+bool ReplayLog::nextInterrupt(uint8_t code, InterruptResult *result)
+{
+    if (this->_events.size() - this->_cursor < 3 || this->_events[this->_cursor] != REPLAY_INTERRUPT ||
+        this->_events[this->_cursor + 1] != code)
+        return false;
+    *result = (InterruptResult)this->_events[this->_cursor + 2];
+    this->_cursor += 3;
+    return true;
+}
+
+bool ReplayLog::nextState(uint32_t *registers, uint8_t *memory)
+{
+    if (this->_cursor >= this->_events.size() || this->_events[this->_cursor] != REPLAY_STATE)
+        return false;
+    this->_cursor++;
+
+    uint32_t changed;
+    if (!this->_get(&changed))
+        return false;
+    for (uint32_t r = 0; r < REGISTER_COUNT; r++)
+        if ((changed & (1U << r)) && !this->_get(&registers[r]))
+            return false;
+
+    uint32_t runs;
+    if (!this->_get(&runs))
+        return false;
+    uint32_t end = 0;
+    for (uint32_t i = 0; i < runs; i++)
+    {
+        uint32_t gap, len;
+        if (!this->_get(&gap) || !this->_get(&len) || (uint64_t)end + gap + len > this->_memory.size() ||
+            this->_events.size() - this->_cursor < len)
+            return false;
+        memcpy(&memory[end + gap], &this->_events[this->_cursor], len);
+        this->_cursor += len;
+        end += gap + len;
+    }
+    return true;
+}
+
+bool ReplayLog::nextUnhandled(uint8_t code)
+{
+    if (this->_events.size() - this->_cursor < 2 || this->_events[this->_cursor] != REPLAY_UNHANDLED ||
+        this->_events[this->_cursor + 1] != code)
+        return false;
+    this->_cursor += 2;
+    return true;
+}
+
+bool ReplayLog::save(FILE *out)
+{
+    ReplayFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = REPLAY_MAGIC;
+    header.progLen = this->_progLen;
+    header.stackSize = this->_stackSize;
+    memcpy(header.registers, this->_registers, sizeof(header.registers));
+    header.regSig = this->_regSig;
+    header.flagSig = this->_flagSig;
+    header.count = this->_count;
+    header.eventsLen = this->_events.size();
+    return fwrite(&header, sizeof(header), 1, out) == 1 &&
+           fwrite(this->_memory.data(), 1, this->_memory.size(), out) == this->_memory.size() &&
+           fwrite(this->_events.data(), 1, this->_events.size(), out) == this->_events.size();
+}
+
+bool ReplayLog::load(FILE *in)
+{
+    ReplayFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != REPLAY_MAGIC)
+        return false;
+
+    // the lengths in the header are only trusted once the file is known to hold that much
+    const long start = ftell(in);
+    if (start < 0 || fseek(in, 0, SEEK_END) != 0)
+        return false;
+    const long end = ftell(in);
+    if (end < start || fseek(in, start, SEEK_SET) != 0 ||
+        (uint64_t)header.progLen + header.stackSize + header.eventsLen > (uint64_t)(end - start))
+        return false;
+
+    this->clear();
+    this->_progLen = header.progLen;
+    this->_stackSize = header.stackSize;
+    memcpy(this->_registers, header.registers, sizeof(this->_registers));
+    this->_regSig = header.regSig;
+    this->_flagSig = header.flagSig != 0;
+    this->_count = header.count;
+    this->_memory.resize((uint32_t)header.progLen + header.stackSize);
+    this->_events.resize(header.eventsLen);
+    if (fread(this->_memory.data(), 1, this->_memory.size(), in) != this->_memory.size() ||
+        fread(this->_events.data(), 1, this->_events.size(), in) != this->_events.size())
+    {
+        this->clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include "vm.h"
+
+#include <vector>
+
+#define REPLAY_MAGIC 0x4C52424D // "MBRL"
+
+enum ReplayEvent : uint8_t
+{
+    REPLAY_VALUE,     // READ, READI, READF or READC: register value and characters consumed
+    REPLAY_STRING,    // READS: the bytes stored
+    REPLAY_INTERRUPT, // interrupt code and the handler's InterruptResult
+    REPLAY_STATE,     // registers and memory the host changed while handling an interrupt
+    REPLAY_UNHANDLED, // interrupt code raised with no handler registered, which ended the run
+};
+
+// Every nondeterministic input of a VM from the moment recording starts: its
+// registers and memory at that point, the data each read opcode consumed, and
+// what the interrupt handlers returned and changed in the VM. Replaying the
+// log from the same starting state re-executes the run exactly, with no
+// input stream and no handlers, so it can be repeated offline under any
+// profiler. Values are LEB128 varints and memory changes are stored as
+// differing runs, which keeps the log compact.
+//
+// Recording snapshots memory before every interrupt handler to find what it
+// changed, so it costs a copy of the VM memory per interrupt. Host changes
+// made between runs, and changes to IP, are not recorded. A pending async
+// interrupt is completed at once on replay, with the state it was resumed in.
+class ReplayLog
+{
+  public:
+    ReplayLog();
+
+    void clear();
+    uint32_t events();
+    // bytes of recorded events, the starting state left out
+    size_t size();
+    // replay consumed every event
+    bool finished();
+
+    // starting state, for building a VM to replay into
+    uint16_t programLength();
+    uint16_t stackSize();
+    uint8_t *memory();
+
+    // recording, called by the VM
+    void begin(const uint32_t *registers, bool flagSig, int regSig, const uint8_t *memory, uint16_t progLen,
+               uint16_t stackSize);
+    void value(uint32_t value, uint32_t consumed);
+    void string(const char *text, uint32_t len);
+    // snapshot() before the handler runs, state() once it completed
+    void snapshot(const uint32_t *registers, const uint8_t *memory);
+    void interrupt(uint8_t code, InterruptResult result);
+    void state(const uint32_t *registers, const uint8_t *memory);
+    void unhandled(uint8_t code);
+
+    // replaying, called by the VM: false when the run diverged from the log
+    bool restore(uint32_t *registers, bool *flagSig, int *regSig, uint8_t *memory, uint16_t progLen,
+                 uint16_t stackSize);
+    bool nextValue(uint32_t *value, uint32_t *consumed);
+    bool nextString(char *dest, uint32_t maxLen, uint32_t *len);
+    bool nextInterrupt(uint8_t code, InterruptResult *result);
+    bool nextState(uint32_t *registers, uint8_t *memory);
+    bool nextUnhandled(uint8_t code);
+
+    bool save(FILE *out);
+    bool load(FILE *in);
+
+  protected:
+    void _put(uint32_t value);
+    bool _get(uint32_t *value);
+
+    uint16_t _progLen = 0;
+    uint16_t _stackSize = 0;
+    uint32_t _registers[REGISTER_COUNT];
+    bool _flagSig = false;
+    int _regSig = 0;
+    std::vector<uint8_t> _memory;
+    std::vector<uint8_t> _events;
+    uint32_t _count = 0;
+    size_t _cursor = 0;
+    // state before the interrupt being recorded
+    uint32_t _shadowRegisters[REGISTER_COUNT];
+    std::vector<uint8_t> _shadow;
+};
+
+#endif // __REPLAY_H__
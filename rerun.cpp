@@ -0,0 +1,52 @@
+#include "vm.h"
+#include "replay.h"
+#include "vmstats.h"
+
+// Re-executes a run recorded with VM::recordTo from its replay log, with no
+// input and no interrupt handlers, e.g. under perf or valgrind. Program
+// output goes to output_file, /dev/null by default.
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        printf("Usage: %s log_file [output_file]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (f == nullptr)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    ReplayLog log;
+    const bool loaded = log.load(f);
+    fclose(f);
+    if (!loaded)
+    {
+        fprintf(stderr, "%s: not a replay log\n", argv[1]);
+        return 1;
+    }
+
+    FILE *out = fopen(argc > 2 ? argv[2] : "/dev/null", "w");
+    if (out == nullptr)
+    {
+        perror(argc > 2 ? argv[2] : "/dev/null");
+        return 1;
+    }
+
+    VM vm(log.memory(), log.programLength(), log.stackSize());
+    vm.setOutput(out);
+    vm.replayFrom(&log);
+
+    const uint64_t start = VM::clock();
+    const ExecResult result = vm.run();
+    const uint64_t elapsed = VM::clock() - start;
+    fclose(out);
+
+    printf("%s after %llu instructions in %.3f ms, %u events%s\n", resultName(result),
+           (unsigned long long)vm.retired(), elapsed / 1e6, log.events(),
+           log.finished() ? "" : ", some left unread");
+    return result == ExecResult::VM_ERR_REPLAY_DIVERGED ? 2 : 0;
+}
@@ -0,0 +1,128 @@
+#include "sampler.h"
+
+#include <signal.h>
+#include <sys/time.h>
+
+static std::atomic<SamplingProfiler *> activeSampler(nullptr);
+
+SamplingProfiler::SamplingProfiler(uint32_t capacity)
+    : _samples(new Sample[capacity]), _capacity(capacity)
+{
+}
+
+SamplingProfiler::~SamplingProfiler()
+{
+    this->stop();
+    delete[] this->_samples;
+}
+
+bool SamplingProfiler::start(VM *vm, uint32_t intervalUs)
+{
+    SamplingProfiler *expected = nullptr;
+    if (!activeSampler.compare_exchange_strong(expected, this))
+        return false;
+
+    this->_vm = vm;
+    this->_depth = 0;
+    vm->attachSampler(this);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SamplingProfiler::onSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+
+    itimerval timer;
+    timer.it_interval.tv_sec = intervalUs / 1000000;
+    timer.it_interval.tv_usec = intervalUs % 1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    return true;
+}
+
+void SamplingProfiler::stop()
+{
+    if (activeSampler.load() != this)
+        return;
+
+    itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    signal(SIGPROF, SIG_IGN);
+
+    this->_vm->attachSampler(nullptr);
+    activeSampler.store(nullptr);
+}
+
+void SamplingProfiler::onSignal(int)
+{
+    SamplingProfiler *sampler = activeSampler.load();
+    if (sampler != nullptr)
+        sampler->sample();
+}
+
+void SamplingProfiler::sample()
+{
+    // runs in signal context: no allocation, no locks
+    const uint32_t index = this->_count;
+    if (index >= this->_capacity)
+    {
+        this->_dropped = this->_dropped + 1;
+        return;
+    }
+
+    Sample &sample = this->_samples[index];
+    const uint32_t depth = this->_depth;
+    std::atomic_signal_fence(std::memory_order_acquire);
+    sample.ip = this->_vm->getRegister(IP);
+    sample.depth = depth < SAMPLER_MAX_DEPTH ? depth : SAMPLER_MAX_DEPTH;
+    memcpy(sample.frames, this->_frames, sample.depth * sizeof(uint16_t));
+    this->_count = index + 1;
+}
+
+bool SamplingProfiler::loadLabels(const char *path)
+{
+    return this->_labels.load(path);
+}
+
+void SamplingProfiler::addLabel(uint16_t addr, const char *name)
+{
+    this->_labels.add(addr, name);
+}
+
+uint32_t SamplingProfiler::sampleCount()
+{
+    return this->_count;
+}
+
+uint32_t SamplingProfiler::dropped()
+{
+    return this->_dropped;
+}
+
+void SamplingProfiler::writeFolded(FILE *out)
+{
+    std::map<std::string, uint64_t> stacks;
+
+    for (uint32_t i = 0; i < this->_count; i++)
+    {
+        const Sample &sample = this->_samples[i];
+        std::string stack = this->_labels.symbol(0, true);
+        std::string top = stack;
+        for (uint16_t d = 0; d < sample.depth; d++)
+        {
+            top = this->_labels.symbol(sample.frames[d], true);
+            stack += ";" + top;
+        }
+
+        // the leaf is the IP, unless it is the entry of the function on top
+        const std::string leaf = this->_labels.symbol(sample.ip, false);
+        if (leaf != top)
+            stack += ";" + leaf;
+        stacks[stack]++;
+    }
+
+    for (std::map<std::string, uint64_t>::iterator it = stacks.begin(); it != stacks.end(); ++it)
+        fprintf(out, "%s %llu\n", it->first.c_str(), (unsigned long long)it->second);
+}
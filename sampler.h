@@ -0,0 +1,73 @@
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+#include "vm.h"
+#include "labels.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+
+#define SAMPLER_MAX_DEPTH 64
+
+// Statistical profiler: a SIGPROF timer samples the IP of the attached VM
+// together with a shadow call stack the VM maintains on CALL/RET. Samples are
+// aggregated into folded stacks ("main;f;g 42") for flamegraph tools, with
+// addresses symbolized through an optional label map. Only one sampler can
+// be running at a time, and it should profile a VM running on the thread
+// that consumes the CPU time.
+class SamplingProfiler
+{
+  public:
+    SamplingProfiler(uint32_t capacity = 1 << 16);
+    ~SamplingProfiler();
+
+    bool start(VM *vm, uint32_t intervalUs = 1000);
+    void stop();
+    void sample();
+
+    // shadow call stack, maintained by the VM
+    inline void push(uint16_t target)
+    {
+        const uint32_t depth = this->_depth;
+        if (depth < SAMPLER_MAX_DEPTH)
+            this->_frames[depth] = target;
+        std::atomic_signal_fence(std::memory_order_release);
+        this->_depth = depth + 1;
+    }
+
+    inline void pop()
+    {
+        if (this->_depth > 0)
+            this->_depth = this->_depth - 1;
+    }
+
+    // see LabelMap for the file format
+    bool loadLabels(const char *path);
+    void addLabel(uint16_t addr, const char *name);
+
+    uint32_t sampleCount();
+    uint32_t dropped();
+    void writeFolded(FILE *out);
+
+  protected:
+    struct Sample
+    {
+        uint16_t ip;
+        uint16_t depth;
+        uint16_t frames[SAMPLER_MAX_DEPTH];
+    };
+
+    static void onSignal(int);
+
+    VM *_vm = nullptr;
+    Sample *_samples;
+    const uint32_t _capacity;
+    volatile uint32_t _count = 0;
+    volatile uint32_t _dropped = 0;
+    uint16_t _frames[SAMPLER_MAX_DEPTH];
+    volatile uint32_t _depth = 0;
+    LabelMap _labels;
+};
+
+#endif // __SAMPLER_H__
@@ -0,0 +1,180 @@
+#include "scheduler.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+#define _POLL_EVENTS 64
+#define _POLL_TIMEOUT_MS 10
+
+VMScheduler::VMScheduler(void (*onReady)(VM *, uint32_t), void (*onDone)(VM *, ExecResult), uint32_t slice)
+    : _onReady(onReady), _onDone(onDone), _slice(slice), _epoll(epoll_create1(EPOLL_CLOEXEC)), _stop(false)
+{
+}
+
+VMScheduler::~VMScheduler()
+{
+    close(this->_epoll);
+}
+
+void VMScheduler::submit(VM *vm)
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_live++;
+    this->_ready.push_back(vm);
+    this->_wake.notify_one();
+}
+
+void VMScheduler::run(unsigned threads, unsigned fileThreads)
+{
+    std::vector<std::thread> workers;
+    std::vector<std::thread> filers;
+
+    this->_stop = false;
+    std::thread poller(&VMScheduler::poller, this);
+    for (unsigned i = 0; i < (fileThreads > 0 ? fileThreads : 1); i++)
+        filers.push_back(std::thread(&VMScheduler::filer, this));
+    for (unsigned i = 0; i < threads; i++)
+        workers.push_back(std::thread(&VMScheduler::worker, this));
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    {
+        std::lock_guard<std::mutex> guard(this->_lock);
+        this->_stop = true;
+    }
+    this->_fileWake.notify_all();
+    poller.join();
+    for (size_t i = 0; i < filers.size(); i++)
+        filers[i].join();
+}
+
+void VMScheduler::worker()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(this->_lock);
+        this->_wake.wait(lock, [this] { return !this->_ready.empty() || this->_live == 0; });
+        if (this->_ready.empty())
+            return;
+        VM *vm = this->_ready.front();
+        this->_ready.pop_front();
+        lock.unlock();
+
+        const ExecResult result = vm->run(this->_slice);
+        if (result == ExecResult::VM_PAUSED)
+        {
+            lock.lock();
+            this->_ready.push_back(vm);
+            this->_wake.notify_one();
+        }
+        else if (result == ExecResult::VM_WAITING)
+            this->park(vm);
+        else
+            this->finish(vm, result);
+    }
+}
+
+void VMScheduler::finish(VM *vm, ExecResult result)
+{
+    this->_onDone(vm, result);
+    std::lock_guard<std::mutex> guard(this->_lock);
+    if (--this->_live == 0)
+        this->_wake.notify_all();
+}
+
+void VMScheduler::park(VM *vm)
+{
+    const int fd = (int)vm->pendingToken();
+    {
+        std::lock_guard<std::mutex> guard(this->_lock);
+        std::deque<VM *> &waiters = this->_waiters[fd];
+        waiters.push_back(vm);
+        // the descriptor is already watched for an earlier VM
+        if (waiters.size() > 1)
+            return;
+
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.fd = fd;
+        if (epoll_ctl(this->_epoll, EPOLL_CTL_ADD, fd, &ev) == 0)
+            return;
+        this->_waiters.erase(fd);
+
+        // regular files are always ready and cannot be added to epoll
+        if (errno == EPERM)
+        {
+            this->_files.push_back(vm);
+            this->_fileWake.notify_one();
+            return;
+        }
+    }
+    // e.g. a closed descriptor
+    this->finish(vm, ExecResult::VM_ERR_WAIT_FAILED);
+}
+
+void VMScheduler::poller()
+{
+    epoll_event events[_POLL_EVENTS];
+
+    while (!this->_stop)
+    {
+        const int count = epoll_wait(this->_epoll, events, _POLL_EVENTS, _POLL_TIMEOUT_MS);
+        for (int i = 0; i < count; i++)
+        {
+            const int fd = events[i].data.fd;
+            std::unique_lock<std::mutex> lock(this->_lock);
+            VM *vm = this->_waiters[fd].front();
+            lock.unlock();
+
+            // stays at the front while it is completed, so VMs parking on fd
+            // meanwhile queue behind it instead of adding fd again
+            this->complete(vm);
+
+            lock.lock();
+            std::deque<VM *> &waiters = this->_waiters[fd];
+            waiters.pop_front();
+            if (waiters.empty())
+            {
+                epoll_ctl(this->_epoll, EPOLL_CTL_DEL, fd, nullptr);
+                this->_waiters.erase(fd);
+            }
+            else
+            {
+                // re-arm for the next VM in line, now that the data is consumed
+                epoll_event ev;
+                ev.events = EPOLLIN | EPOLLONESHOT;
+                ev.data.fd = fd;
+                epoll_ctl(this->_epoll, EPOLL_CTL_MOD, fd, &ev);
+            }
+        }
+    }
+}
+
+void VMScheduler::filer()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(this->_lock);
+        this->_fileWake.wait(lock, [this] { return !this->_files.empty() || this->_stop; });
+        if (this->_files.empty())
+            return;
+        VM *vm = this->_files.front();
+        this->_files.pop_front();
+        lock.unlock();
+
+        this->complete(vm);
+    }
+}
+
+void VMScheduler::complete(VM *vm)
+{
+    const uint32_t token = vm->pendingToken();
+    this->_onReady(vm, token);
+    vm->resume(token);
+
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_ready.push_back(vm);
+    this->_wake.notify_one();
+}
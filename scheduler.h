@@ -0,0 +1,56 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include "vm.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#define SCHEDULER_FILE_THREADS 8
+
+// Multiplexes many VMs over a few worker threads. Each VM runs for at most
+// `slice` instructions at a time. A VM that returns VM_WAITING is parked on
+// epoll using its pending token as a file descriptor; once the descriptor is
+// readable onReady completes the request (e.g. reads the data into the VM's
+// registers or memory) and the VM is resumed on the next free worker. VMs
+// parked on the same descriptor queue behind each other and are completed one
+// per readiness event, in the order they parked.
+// Descriptors epoll cannot watch (regular files) are always ready; they are
+// completed on a pool of file threads, so blocking reads there overlap and do
+// not hold up the workers. Any other failure to watch the descriptor finishes
+// the VM with VM_ERR_WAIT_FAILED.
+class VMScheduler
+{
+  public:
+    VMScheduler(void (*onReady)(VM *, uint32_t), void (*onDone)(VM *, ExecResult), uint32_t slice = 100000);
+    ~VMScheduler();
+
+    void submit(VM *vm);
+    void run(unsigned threads = 1, unsigned fileThreads = SCHEDULER_FILE_THREADS);
+
+  protected:
+    void worker();
+    void poller();
+    void filer();
+    void park(VM *vm);
+    void complete(VM *vm);
+    void finish(VM *vm, ExecResult result);
+
+    void (*_onReady)(VM *, uint32_t);
+    void (*_onDone)(VM *, ExecResult);
+    const uint32_t _slice;
+    int _epoll;
+    uint32_t _live = 0; // submitted VMs that have not finished yet
+    std::atomic<bool> _stop;
+    std::mutex _lock;
+    std::condition_variable _wake;
+    std::condition_variable _fileWake;
+    std::deque<VM *> _ready;
+    std::deque<VM *> _files; // parked on regular files, for the file threads
+    std::map<int, std::deque<VM *>> _waiters; // parked on each watched descriptor
+};
+
+#endif // __SCHEDULER_H__
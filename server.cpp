@@ -0,0 +1,229 @@
+#include "vm.h"
+#include "protocol.h"
+#include "program.h"
+
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Long-running execution server: accepts (program, input, limits) requests on a
+// Unix socket and runs them on pooled VMs across worker threads. Programs go
+// through the process-wide ProgramCache, so only the first request for a
+// program pays for loading and analyzing it, and idle VMs are pooled by memory
+// layout so a request reuses one instead of allocating a new VM.
+//
+// Workers serve single requests, not whole connections: an epoll loop watches
+// every client and queues a connection only once its next request arrives, so
+// idle keep-alive clients do not hold a worker.
+
+#define _OUTPUT_BUFFER 4096
+#define _MAX_IDLE_VMS 64
+#define _MAX_RUN_MS 10000
+#define _IO_TIMEOUT_MS 1000
+#define _POLL_EVENTS 64
+
+static std::mutex poolLock;
+static std::map<std::pair<uint16_t, uint16_t>, std::vector<VM *>> idle; // by (progLen, stackSize)
+
+static std::mutex queueLock;
+static std::condition_variable queueWake;
+static std::deque<int> connections; // with a request ready to read
+static int poller;
+
+static VM *acquireVM(const Program &program, uint16_t stackSize)
+{
+    {
+        std::lock_guard<std::mutex> guard(poolLock);
+        std::vector<VM *> &pool = idle[std::make_pair(program.length(), stackSize)];
+        if (!pool.empty())
+        {
+            VM *vm = pool.back();
+            pool.pop_back();
+            memcpy(vm->memory(), program.code.data(), program.length());
+            vm->reset();
+            return vm;
+        }
+    }
+    return new VM((uint8_t *)program.code.data(), program.length(), stackSize);
+}
+
+static void releaseVM(const Program &program, uint16_t stackSize, VM *vm)
+{
+    vm->setInput(stdin);
+    vm->setOutput(stdout);
+    {
+        std::lock_guard<std::mutex> guard(poolLock);
+        std::vector<VM *> &pool = idle[std::make_pair(program.length(), stackSize)];
+        if (pool.size() < _MAX_IDLE_VMS)
+        {
+            pool.push_back(vm);
+            return;
+        }
+    }
+    delete vm;
+}
+
+static ssize_t writeOutput(void *cookie, const char *buf, size_t len)
+{
+    if (!writeFrame(*(int *)cookie, FRAME_OUTPUT, buf, len))
+        return -1;
+    return len;
+}
+
+static bool sendError(int fd, const char *message)
+{
+    writeFrame(fd, FRAME_ERROR, message, strlen(message));
+    return false;
+}
+
+static bool serveRequest(int fd)
+{
+    RequestHeader header;
+    if (!readFull(fd, &header, sizeof(header)))
+        return false;
+    if (header.magic != VM_PROTOCOL_MAGIC)
+        return sendError(fd, "bad magic");
+    // summed in 64 bits, a huge progLen must not wrap around into range
+    if (header.progLen == 0 || (uint64_t)header.progLen + header.stackSize > UINT16_MAX)
+        return sendError(fd, "program and stack do not fit in 64KiB");
+    if (header.inputLen > VM_PROTOCOL_MAX_INPUT)
+        return sendError(fd, "input too large");
+
+    std::vector<uint8_t> code(header.progLen);
+    std::vector<char> input(header.inputLen + 1);
+    if (!readFull(fd, code.data(), code.size()) || !readFull(fd, input.data(), header.inputLen))
+        return false;
+
+    bool cached;
+    std::shared_ptr<const Program> program = ProgramCache::instance().load(code.data(), code.size(), &cached);
+    VM *vm = acquireVM(*program, header.stackSize);
+
+    cookie_io_functions_t io = {nullptr, writeOutput, nullptr, nullptr};
+    FILE *out = fopencookie(&fd, "w", io);
+    FILE *in = fmemopen(input.data(), header.inputLen, "r");
+    if (out == nullptr || in == nullptr)
+    {
+        if (out != nullptr)
+            fclose(out);
+        if (in != nullptr)
+            fclose(in);
+        releaseVM(*program, header.stackSize, vm);
+        return sendError(fd, "cannot open program streams");
+    }
+    setvbuf(out, nullptr, _IOFBF, _OUTPUT_BUFFER);
+    vm->setOutput(out);
+    vm->setInput(in);
+
+    ResultFrame result;
+    memset(&result, 0, sizeof(result));
+    const uint32_t limitMs = header.timeLimitMs == 0 || header.timeLimitMs > _MAX_RUN_MS ? _MAX_RUN_MS
+                                                                                         : header.timeLimitMs;
+    result.result = vm->runFor(limitMs * 1000000ULL, header.maxInstr);
+    result.cached = cached;
+    result.ip = vm->getRegister(IP);
+
+    const bool sent = fclose(out) == 0;
+    fclose(in);
+    releaseVM(*program, header.stackSize, vm);
+    return sent && writeFrame(fd, FRAME_RESULT, &result, sizeof(result));
+}
+
+static void worker()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(queueLock);
+        queueWake.wait(lock, [] { return !connections.empty(); });
+        const int fd = connections.front();
+        connections.pop_front();
+        lock.unlock();
+
+        if (!serveRequest(fd))
+        {
+            epoll_ctl(poller, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            continue;
+        }
+        // watch for the connection's next request
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.fd = fd;
+        epoll_ctl(poller, EPOLL_CTL_MOD, fd, &ev);
+    }
+}
+
+static void acceptClient(int listener)
+{
+    const int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0)
+        return;
+
+    // a client that stalls in the middle of a request gives its worker back
+    timeval timeout = {_IO_TIMEOUT_MS / 1000, (_IO_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (epoll_ctl(poller, EPOLL_CTL_ADD, fd, &ev) != 0)
+        close(fd);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s socket_path [threads]\n", argv[0]);
+        return 1;
+    }
+    const unsigned threads = argc > 2 ? atoi(argv[2]) : std::thread::hardware_concurrency();
+
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, argv[1], sizeof(addr.sun_path) - 1);
+    unlink(argv[1]);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    poller = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = listener;
+    if (listener < 0 || bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 128) != 0 ||
+        poller < 0 || epoll_ctl(poller, EPOLL_CTL_ADD, listener, &ev) != 0)
+    {
+        perror("vmserver");
+        return 1;
+    }
+
+    for (unsigned i = 0; i < (threads ? threads : 1); i++)
+        std::thread(worker).detach();
+
+    epoll_event events[_POLL_EVENTS];
+    while (true)
+    {
+        const int count = epoll_wait(poller, events, _POLL_EVENTS, -1);
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.fd == listener)
+            {
+                acceptClient(listener);
+                continue;
+            }
+            std::lock_guard<std::mutex> guard(queueLock);
+            connections.push_back(events[i].data.fd);
+            queueWake.notify_one();
+        }
+    }
+}
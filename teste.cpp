@@ -1,5 +1,10 @@
 #include <assert.h>
+#include <fenv.h>
 #include <math.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
 
 #define _U32_GARBAGE 0xF1E2D3C4U
 #define _U16_GARBAGE 0xF1E2U
@@ -758,6 +763,7 @@ void TEST_CASE_OP_AND()
 
     printf("%s\n", "Test: 1 & 0;");
     {
+        vm.reset();
         vm.setRegister(R1, 1);
         vm.setRegister(R2, 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -766,6 +772,7 @@ void TEST_CASE_OP_AND()
 
     printf("%s\n", "Test: 1 & 1;");
     {
+        vm.reset();
         vm.setRegister(R1, 1);
         vm.setRegister(R2, 1);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -774,6 +781,7 @@ void TEST_CASE_OP_AND()
 
     printf("%s\n", "Test: 0xF1F1F1F1 & 0xEAD1;");
     {
+        vm.reset();
         vm.setRegister(R1, 0xF1F1F1F1);
         vm.setRegister(R2, 0xEAD1);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -798,6 +806,7 @@ void TEST_CASE_OP_OR()
 
     printf("%s\n", "Test: 1 | 0;");
     {
+        vm.reset();
         vm.setRegister(R1, 1);
         vm.setRegister(R2, 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -806,6 +815,7 @@ void TEST_CASE_OP_OR()
 
     printf("%s\n", "Test: 1 | 1;");
     {
+        vm.reset();
         vm.setRegister(R1, 1);
         vm.setRegister(R2, 1);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -814,6 +824,7 @@ void TEST_CASE_OP_OR()
 
     printf("%s\n", "Test: 0xF1F1F1F1 | 0xEAD1;");
     {
+        vm.reset();
         vm.setRegister(R1, 0xF1F1F1F1);
         vm.setRegister(R2, 0xEAD1);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -838,6 +849,7 @@ void TEST_CASE_OP_XOR()
 
     printf("%s\n", "Test: 1 ^ 0;");
     {
+        vm.reset();
         vm.setRegister(R1, 1);
         vm.setRegister(R2, 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -846,6 +858,7 @@ void TEST_CASE_OP_XOR()
 
     printf("%s\n", "Test: 1 ^ 1;");
     {
+        vm.reset();
         vm.setRegister(R1, 1);
         vm.setRegister(R2, 1);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -854,6 +867,7 @@ void TEST_CASE_OP_XOR()
 
     printf("%s\n", "Test: 0xF1F1F1F1 ^ 0xEAD1;");
     {
+        vm.reset();
         vm.setRegister(R1, 0xF1F1F1F1);
         vm.setRegister(R2, 0xEAD1);
         assert(vm.run() == ExecResult::VM_FINISHED);
@@ -877,6 +891,7 @@ void TEST_CASE_OP_NOT()
 
     printf("%s\n", "Test: !1;");
     {
+        vm.reset();
         vm.setRegister(R1, 1);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 0xFFFFFFFE);
@@ -884,1510 +899,5270 @@ void TEST_CASE_OP_NOT()
 
     printf("%s\n", "Test: !0xF1F1F1F1;");
     {
+        vm.reset();
         vm.setRegister(R1, 0xF1F1F1F1);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 0xE0E0E0E);
     }
 }
 
-void TEST_CASE_OP_JMP()
+void TEST_CASE_OP_ADDI()
 {
-    printf("%s\n", "Teste: Jump and set 1;");
+    uint8_t program[] = {
+        OP_ADDI, R0, R1, 0x79, 0x11, 0x0F, 0x00,
+        OP_ADDIB, R2, R1, 0xFF,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: 1123497651 + 987513, 1123497651 + 255;");
     {
-        uint8_t program[] = {
-            OP_JMP, 4, 0,
-            OP_HALT,
-            OP_LCONSB, R0, 1,
-            OP_HALT};
-        VM vm(program, sizeof(program));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 1123497651);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 1124485164);
+        assert(vm.getRegister(R2) == 1123497906);
     }
-}
 
-void TEST_CASE_OP_JR()
-{
-    printf("%s\n", "Teste: Jump and set 1;");
+    printf("%s\n", "Test: UINT32_MAX + 987513, UINT32_MAX + 255;");
     {
-        uint8_t program[] = {
-            OP_JR, R1,
-            OP_HALT,
-            OP_LCONSB, R0, 1,
-            OP_HALT};
-        VM vm(program, sizeof(program));
-        vm.setRegister(R1, 3);
-        assert(vm.getRegister(R0) == 0);
+        vm.reset();
+        vm.setRegister(R1, UINT32_MAX);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 987512);
+        assert(vm.getRegister(R2) == 254);
     }
 }
 
-void TEST_CASE_OP_JZ()
+void TEST_CASE_OP_SUBI()
 {
     uint8_t program[] = {
-        OP_JZ, R1, 5, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
+        OP_SUBI, R0, R1, 0x79, 0x11, 0x0F, 0x00,
+        OP_SUBIB, R2, R1, 1,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: True;");
+    printf("%s\n", "Test: 1124485164 - 987513, 1124485164 - 1;");
     {
-        assert(vm.getRegister(R1) == 0);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 1124485164);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 1123497651);
+        assert(vm.getRegister(R2) == 1124485163);
     }
 
-    printf("%s\n", "Teste: False;");
+    printf("%s\n", "Test: 0 - 987513, 0 - 1;");
     {
         vm.reset();
-        vm.setRegister(R1, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert((int32_t)vm.getRegister(R0) == -987513);
+        assert(vm.getRegister(R2) == UINT32_MAX);
     }
 }
 
-void TEST_CASE_OP_JNZ()
+void TEST_CASE_OP_MULI()
 {
     uint8_t program[] = {
-        OP_JNZ, R1, 5, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
+        OP_MULI, R0, R1, 0xF9, 0xFF, 0xFF, 0xFF,
+        OP_MULIB, R2, R1, 10,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: True;");
+    printf("%s\n", "Test: 3 * -7, 3 * 10;");
     {
-        vm.setRegister(R1, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 3);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert((int32_t)vm.getRegister(R0) == -21);
+        assert(vm.getRegister(R2) == 30);
     }
 
-    printf("%s\n", "Teste: False;");
+    printf("%s\n", "Test: -4 * -7, -4 * 10;");
     {
         vm.reset();
-        assert(vm.getRegister(R1) == 0);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, (uint32_t)-4);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 28);
+        assert((int32_t)vm.getRegister(R2) == -40);
     }
 }
 
-void TEST_CASE_OP_JE()
+void TEST_CASE_OP_DIVI()
 {
     uint8_t program[] = {
-        OP_JE, R1, R2, 6, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
+        OP_DIVI, R0, R1, 0x10, 0x27, 0x00, 0x00,
+        OP_DIVIB, R2, R1, 10,
+        OP_IDIVI, R3, R1, 0xFE, 0xFF, 0xFF, 0xFF,
+        OP_MODI, R4, R1, 0x10, 0x27, 0x00, 0x00,
+        OP_MODIB, R5, R1, 10,
+        OP_IMODI, T0, R1, 3, 0, 0, 0,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: True;");
+    printf("%s\n", "Test: 123457 / 10000, / 10, / -2, % 10000, % 10, % 3;");
     {
-        vm.setRegister(R1, 123);
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 123457);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 12);
+        assert(vm.getRegister(R2) == 12345);
+        assert((int32_t)vm.getRegister(R3) == -61728);
+        assert(vm.getRegister(R4) == 3457);
+        assert(vm.getRegister(R5) == 7);
+        assert(vm.getRegister(T0) == 1);
     }
 
-    printf("%s\n", "Teste: False;");
+    printf("%s\n", "Test: -7 signed and unsigned;");
     {
         vm.reset();
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R1) == 0);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, (uint32_t)-7);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 429496);
+        assert(vm.getRegister(R2) == 429496728);
+        assert(vm.getRegister(R3) == 3);
+        assert(vm.getRegister(R4) == 7289);
+        assert(vm.getRegister(R5) == 9);
+        assert((int32_t)vm.getRegister(T0) == -1);
     }
 }
 
-void TEST_CASE_OP_JNE()
+void TEST_CASE_OP_SHIFTI()
 {
     uint8_t program[] = {
-        OP_JNE, R1, R2, 6, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
+        OP_SHLIB, R0, R1, 4,
+        OP_SHRIB, R2, R1, 4,
+        OP_ISHRIB, R3, R1, 4,
+        OP_SHLIB, R4, R1, 0,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: False;");
-    {
-        vm.setRegister(R1, 123);
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R0) == 0);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
-    }
-
-    printf("%s\n", "Teste: True;");
+    printf("%s\n", "Test: 0xF0F0F0F1 shifted by 4;");
     {
-        vm.reset();
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R1) == 0);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0xF0F0F0F1);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 0x0F0F0F10);
+        assert(vm.getRegister(R2) == 0x0F0F0F0F);
+        assert(vm.getRegister(R3) == 0xFF0F0F0F);
+        assert(vm.getRegister(R4) == 0xF0F0F0F1);
     }
 }
 
-void TEST_CASE_OP_JA()
+void TEST_CASE_OP_LOGICI()
 {
     uint8_t program[] = {
-        OP_JA, R1, R2, 6, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
+        OP_ANDI, R0, R1, 0xFF, 0xFF, 0x00, 0x00,
+        OP_ANDIB, R2, R1, 0x0F,
+        OP_ORI, R3, R1, 0x00, 0x00, 0x01, 0x00,
+        OP_ORIB, R4, R1, 0x80,
+        OP_XORI, R5, R1, 0xFF, 0xFF, 0xFF, 0xFF,
+        OP_XORIB, T0, R1, 0x01,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: True;");
+    printf("%s\n", "Test: 0xF1F1F1F1 with masks;");
     {
-        vm.setRegister(R1, 123);
-        vm.setRegister(R2, 122);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0xF1F1F1F1);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 0xF1F1);
+        assert(vm.getRegister(R2) == 0x1);
+        assert(vm.getRegister(R3) == 0xF1F1F1F1);
+        assert(vm.getRegister(R4) == 0xF1F1F1F1);
+        assert(vm.getRegister(R5) == 0x0E0E0E0E);
+        assert(vm.getRegister(T0) == 0xF1F1F1F0);
     }
 
-    printf("%s\n", "Teste: False - equal;");
+    printf("%s\n", "Test: 0 with masks;");
     {
         vm.reset();
-        vm.setRegister(R1, 123);
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R2) == 0);
+        assert(vm.getRegister(R3) == 0x10000);
+        assert(vm.getRegister(R4) == 0x80);
+        assert(vm.getRegister(R5) == 0xFFFFFFFF);
+        assert(vm.getRegister(T0) == 1);
     }
+}
 
-    printf("%s\n", "Teste: False - below;");
+void TEST_CASE_OP_FLOATI()
+{
+    // 1.0f, 0.5f and 10.0f
+    uint8_t program[] = {
+        OP_FADDI, R0, R1, 0x00, 0x00, 0x80, 0x3F,
+        OP_FSUBI, R2, R1, 0x00, 0x00, 0x80, 0x3F,
+        OP_FMULI, R3, R1, 0x00, 0x00, 0x00, 0x3F,
+        OP_FDIVI, R4, R1, 0x00, 0x00, 0x20, 0x41,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: 357.34 + 1, - 1, * 0.5, / 10;");
+    {
+        float val = 357.34f;
+        vm.setRegister(R1, *((uint32_t *)&val));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint32_t actual = vm.getRegister(R0);
+        assert(_ALMOST_EQUAL(*((float *)&actual), 358.34f));
+        actual = vm.getRegister(R2);
+        assert(_ALMOST_EQUAL(*((float *)&actual), 356.34f));
+        actual = vm.getRegister(R3);
+        assert(_ALMOST_EQUAL(*((float *)&actual), 178.67f));
+        actual = vm.getRegister(R4);
+        assert(_ALMOST_EQUAL(*((float *)&actual), 35.734f));
+    }
+
+    printf("%s\n", "Test: -3 + 1, - 1, * 0.5, / 10;");
     {
+        float val = -3.0f;
         vm.reset();
-        vm.setRegister(R1, 122);
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, *((uint32_t *)&val));
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        uint32_t actual = vm.getRegister(R0);
+        assert(_ALMOST_EQUAL(*((float *)&actual), -2.0f));
+        actual = vm.getRegister(R2);
+        assert(_ALMOST_EQUAL(*((float *)&actual), -4.0f));
+        actual = vm.getRegister(R3);
+        assert(_ALMOST_EQUAL(*((float *)&actual), -1.5f));
+        actual = vm.getRegister(R4);
+        assert(_ALMOST_EQUAL(*((float *)&actual), -0.3f));
     }
 }
 
-void TEST_CASE_OP_JG()
+void TEST_CASE_OP_BIT_COUNTS()
 {
     uint8_t program[] = {
-        OP_JG, R1, R2, 6, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
+        OP_POPCNT, R0, R1,
+        OP_CLZ, R2, R1,
+        OP_CTZ, R3, R1,
+        OP_BSWAP, R4, R1,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: True - negative;");
+    printf("%s\n", "Test: 0;");
     {
-        int32_t val1 = -122;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R2) == 32);
+        assert(vm.getRegister(R3) == 32);
+        assert(vm.getRegister(R4) == 0);
     }
 
-    printf("%s\n", "Teste: True - neg/pos;");
+    printf("%s\n", "Test: 1;");
     {
         vm.reset();
-        int32_t val1 = 1;
-        int32_t val2 = -122;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 1);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R2) == 31);
+        assert(vm.getRegister(R3) == 0);
+        assert(vm.getRegister(R4) == 0x01000000U);
     }
 
-    printf("%s\n", "Teste: False - equal;");
+    printf("%s\n", "Test: 0x80000000;");
     {
         vm.reset();
-        int32_t val1 = -123;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0x80000000U);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R2) == 0);
+        assert(vm.getRegister(R3) == 31);
+        assert(vm.getRegister(R4) == 0x80);
     }
 
-    printf("%s\n", "Teste: False - below negative;");
+    printf("%s\n", "Test: 0x00F00000;");
     {
         vm.reset();
-        int32_t val1 = -124;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0x00F00000U);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 4);
+        assert(vm.getRegister(R2) == 8);
+        assert(vm.getRegister(R3) == 20);
     }
 
-    printf("%s\n", "Teste: False - below neg/pos;");
+    printf("%s\n", "Test: 0x80000001 and UINT32_MAX;");
     {
         vm.reset();
-        int32_t val1 = -124;
-        int32_t val2 = 1;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0x80000001U);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
-    }
-}
-
-void TEST_CASE_OP_JAE()
-{
-    uint8_t program[] = {
-        OP_JAE, R1, R2, 6, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
-        OP_HALT};
-    VM vm(program, sizeof(program));
+        assert(vm.getRegister(R0) == 2);
 
-    printf("%s\n", "Teste: True - above;");
-    {
-        vm.setRegister(R1, 123);
-        vm.setRegister(R2, 122);
-        assert(vm.getRegister(R0) == 0);
+        vm.reset();
+        vm.setRegister(R1, UINT32_MAX);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 32);
+        assert(vm.getRegister(R2) == 0);
+        assert(vm.getRegister(R3) == 0);
     }
 
-    printf("%s\n", "Teste: True - equal;");
+    printf("%s\n", "Test: Byte swap;");
     {
         vm.reset();
-        vm.setRegister(R1, 123);
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0x11223344U);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
-    }
+        assert(vm.getRegister(R4) == 0x44332211U);
 
-    printf("%s\n", "Teste: False - below;");
-    {
         vm.reset();
-        vm.setRegister(R1, 122);
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, _U32_GARBAGE);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R4) == 0xC4D3E2F1U);
     }
 }
 
-void TEST_CASE_OP_JGE()
+void TEST_CASE_OP_ROTATE()
 {
     uint8_t program[] = {
-        OP_JGE, R1, R2, 6, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
+        OP_ROL, R0, R1, R2,
+        OP_ROR, R3, R1, R2,
+        OP_ROLIB, R4, R1, 4,
+        OP_RORIB, R5, R1, 4,
+        OP_ROLIB, T0, R1, 36,
+        OP_RORIB, T1, R1, 255,
+        OP_ROLIB, T2, R1, 1,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: True - greater negative;");
+    printf("%s\n", "Test: 0x80000001 by 1 and 4;");
     {
-        int32_t val1 = -122;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0x80000001U);
+        vm.setRegister(R2, 1);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 0x00000003U);
+        assert(vm.getRegister(R3) == 0xC0000000U);
+        assert(vm.getRegister(R4) == 0x00000018U);
+        assert(vm.getRegister(R5) == 0x18000000U);
     }
 
-    printf("%s\n", "Teste: True - greater neg/pos;");
+    printf("%s\n", "Test: 0x12345678 by 8 and 4;");
     {
         vm.reset();
-        int32_t val1 = 1;
-        int32_t val2 = -122;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0x12345678U);
+        vm.setRegister(R2, 8);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 0x34567812U);
+        assert(vm.getRegister(R3) == 0x78123456U);
+        assert(vm.getRegister(R4) == 0x23456781U);
+        assert(vm.getRegister(R5) == 0x81234567U);
     }
 
-    printf("%s\n", "Teste: True - equal;");
+    printf("%s\n", "Test: Counts of 32 and above wrap;");
     {
         vm.reset();
-        int32_t val1 = -123;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, _U32_GARBAGE);
+        vm.setRegister(R2, 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
-    }
+        assert(vm.getRegister(R0) == _U32_GARBAGE);
+        assert(vm.getRegister(R3) == _U32_GARBAGE);
 
-    printf("%s\n", "Teste: False - below negative;");
-    {
         vm.reset();
-        int32_t val1 = -124;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, _U32_GARBAGE);
+        vm.setRegister(R2, 32);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
-    }
+        assert(vm.getRegister(R0) == _U32_GARBAGE);
 
-    printf("%s\n", "Teste: False - below neg/pos;");
-    {
         vm.reset();
-        int32_t val1 = -124;
-        int32_t val2 = 1;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 0x12345678U);
+        vm.setRegister(R2, 64);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R3) == 0x12345678U);
+        assert(vm.getRegister(T0) == 0x23456781U);
+        assert(vm.getRegister(T1) == vm.getRegister(T2));
     }
 }
 
-void TEST_CASE_OP_JB()
+void TEST_CASE_OP_BIT_FIELDS()
 {
-    uint8_t program[] = {
-        OP_JB, R1, R2, 6, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
-        OP_HALT};
-    VM vm(program, sizeof(program));
+    printf("%s\n", "Test: Extract;");
+    {
+        uint8_t program[] = {
+            OP_BEXT, R0, R1, 8, 12,
+            OP_BEXT, R2, R1, 28, 8,
+            OP_BEXT, R3, R1, 0, 32,
+            OP_BEXT, R4, R1, 32, 4,
+            OP_BEXT, R5, R1, 4, 0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, 0x12345678U);
+        vm.setRegister(R4, _U32_GARBAGE);
+        vm.setRegister(R5, _U32_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0x456);
+        assert(vm.getRegister(R2) == 0x1);
+        assert(vm.getRegister(R3) == 0x12345678U);
+        assert(vm.getRegister(R4) == 0);
+        assert(vm.getRegister(R5) == 0);
+    }
 
-    printf("%s\n", "Teste: False - above;");
+    printf("%s\n", "Test: Insert;");
     {
-        vm.setRegister(R1, 123);
-        vm.setRegister(R2, 122);
-        assert(vm.getRegister(R0) == 0);
+        uint8_t program[] = {
+            OP_BINS, R0, R1, 8, 12,
+            OP_BINS, R2, R1, 28, 8,
+            OP_BINS, R3, R1, 0, 32,
+            OP_BINS, R4, R1, 32, 4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, 0xABCDEF);
+        vm.setRegister(R0, 0x12345678U);
+        vm.setRegister(R2, 0x12345678U);
+        vm.setRegister(R4, _U32_GARBAGE);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 0x123DEF78U);
+        assert(vm.getRegister(R2) == 0xF2345678U);
+        assert(vm.getRegister(R3) == 0xABCDEF);
+        assert(vm.getRegister(R4) == _U32_GARBAGE);
     }
+}
 
-    printf("%s\n", "Teste: False - equal;");
+uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+void TEST_CASE_OP_CMOV()
+{
+    printf("%s\n", "Test: Integer conditions;");
     {
+        // each destination is set to r1 only if its condition holds for r2 and r3
+        uint8_t program[] = {
+            OP_CMOV, R0, R1, COND_E, R2, R3,
+            OP_CMOV, R4, R1, COND_NE, R2, R3,
+            OP_CMOV, R5, R1, COND_A, R2, R3,
+            OP_CMOV, T0, R1, COND_G, R2, R3,
+            OP_CMOV, T1, R1, COND_AE, R2, R3,
+            OP_CMOV, T2, R1, COND_GE, R2, R3,
+            OP_CMOV, T3, R1, COND_B, R2, R3,
+            OP_CMOV, T4, R1, COND_L, R2, R3,
+            OP_CMOV, T5, R1, COND_BE, R2, R3,
+            OP_CMOV, T6, R1, COND_LE, R2, R3,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, 5);
+        vm.setRegister(R3, 5);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1 && vm.getRegister(R4) == 0);
+        assert(vm.getRegister(R5) == 0 && vm.getRegister(T0) == 0);
+        assert(vm.getRegister(T1) == 1 && vm.getRegister(T2) == 1);
+        assert(vm.getRegister(T3) == 0 && vm.getRegister(T4) == 0);
+        assert(vm.getRegister(T5) == 1 && vm.getRegister(T6) == 1);
+
         vm.reset();
-        vm.setRegister(R1, 123);
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, 5);
+        vm.setRegister(R3, 6);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 0 && vm.getRegister(R4) == 1);
+        assert(vm.getRegister(R5) == 0 && vm.getRegister(T0) == 0);
+        assert(vm.getRegister(T1) == 0 && vm.getRegister(T2) == 0);
+        assert(vm.getRegister(T3) == 1 && vm.getRegister(T4) == 1);
+        assert(vm.getRegister(T5) == 1 && vm.getRegister(T6) == 1);
+
+        // unsigned and signed orders disagree
+        vm.reset();
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, UINT32_MAX);
+        vm.setRegister(R3, 1);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R5) == 1 && vm.getRegister(T0) == 0);
+        assert(vm.getRegister(T1) == 1 && vm.getRegister(T2) == 0);
+        assert(vm.getRegister(T3) == 0 && vm.getRegister(T4) == 1);
+        assert(vm.getRegister(T5) == 0 && vm.getRegister(T6) == 1);
+
+        vm.reset();
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, 1);
+        vm.setRegister(R3, UINT32_MAX);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R5) == 0 && vm.getRegister(T0) == 1);
+        assert(vm.getRegister(T1) == 0 && vm.getRegister(T2) == 1);
+        assert(vm.getRegister(T3) == 1 && vm.getRegister(T4) == 0);
+        assert(vm.getRegister(T5) == 1 && vm.getRegister(T6) == 0);
+
+        vm.reset();
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, (uint32_t)-3);
+        vm.setRegister(R3, 2);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T4) == 1 && vm.getRegister(T0) == 0);
     }
 
-    printf("%s\n", "Teste: True - below;");
+    printf("%s\n", "Test: Float conditions;");
     {
+        uint8_t program[] = {
+            OP_CMOV, R0, R1, COND_FE, R2, R3,
+            OP_CMOV, R4, R1, COND_FNE, R2, R3,
+            OP_CMOV, R5, R1, COND_FG, R2, R3,
+            OP_CMOV, T0, R1, COND_FGE, R2, R3,
+            OP_CMOV, T1, R1, COND_FL, R2, R3,
+            OP_CMOV, T2, R1, COND_FLE, R2, R3,
+            OP_CMOV, T3, R1, COND_E, R2, R3,
+            OP_CMOV, T4, R1, COND_B, R2, R3,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, floatBits(-2.5f));
+        vm.setRegister(R3, floatBits(1.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0 && vm.getRegister(R4) == 1);
+        assert(vm.getRegister(R5) == 0 && vm.getRegister(T0) == 0);
+        assert(vm.getRegister(T1) == 1 && vm.getRegister(T2) == 1);
+        assert(vm.getRegister(T4) == 0);
+
         vm.reset();
-        vm.setRegister(R1, 122);
-        vm.setRegister(R2, 123);
-        assert(vm.getRegister(R0) == 0);
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, floatBits(1.0f));
+        vm.setRegister(R3, floatBits(1.0f));
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 1 && vm.getRegister(T0) == 1);
+        assert(vm.getRegister(T1) == 0 && vm.getRegister(T2) == 1);
+
+        vm.reset();
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, floatBits(0.0f));
+        vm.setRegister(R3, floatBits(-0.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1 && vm.getRegister(T3) == 0);
+
+        vm.reset();
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, floatBits(INFINITY));
+        vm.setRegister(R3, floatBits(1e38f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R5) == 1);
+
+        vm.reset();
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, floatBits(-INFINITY));
+        vm.setRegister(R3, floatBits(-1e38f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T2) == 1);
+    }
+
+    printf("%s\n", "Test: Unordered floats;");
+    {
+        uint8_t program[] = {
+            OP_CMOV, R0, R1, COND_FE, R2, R3,
+            OP_CMOV, R4, R1, COND_FNE, R2, R3,
+            OP_CMOV, R5, R1, COND_FL, R2, R3,
+            OP_CMOV, T0, R1, COND_FGE, R2, R3,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, floatBits(NAN));
+        vm.setRegister(R3, floatBits(NAN));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0 && vm.getRegister(R4) == 1);
+        assert(vm.getRegister(R5) == 0 && vm.getRegister(T0) == 0);
+
+        vm.reset();
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, floatBits(NAN));
+        vm.setRegister(R3, floatBits(1.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R5) == 0 && vm.getRegister(T0) == 0);
+
+        vm.reset();
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, floatBits(1.0f));
+        vm.setRegister(R3, floatBits(NAN));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R5) == 0 && vm.getRegister(T0) == 0);
+    }
+
+    printf("%s\n", "Test: Immediate operand;");
+    {
+        uint8_t program[] = {
+            OP_CMOVI, R0, R1, COND_L, R2, 0x9C, 0xFF, 0xFF, 0xFF,
+            OP_CMOVI, R3, R1, COND_A, R2, 0x9C, 0xFF, 0xFF, 0xFF,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, 42);
+        vm.setRegister(R2, (uint32_t)-200);
+        vm.setRegister(R3, 7);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 42);
+        assert(vm.getRegister(R3) == 7);
+    }
+
+    printf("%s\n", "Test: Unknown condition codes;");
+    {
+        uint8_t program[] = {
+            OP_CMOV, R0, R1, CONDITION_COUNT, R2, R3,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_ERR_UNKNOWN_OPCODE);
+        Program analysis(program, sizeof(program));
+        assert(!analysis.verified);
+        char text[64];
+        assert(disassemble(program, sizeof(program), 0, text, sizeof(text)) == 6);
+        assert(strcmp(text, "cmov r0, r1, c?, r2, r3") == 0);
+        program[3] = COND_FGE;
+        assert(disassemble(program, sizeof(program), 0, text, sizeof(text)) == 6);
+        assert(strcmp(text, "cmov r0, r1, fge, r2, r3") == 0);
     }
 }
 
-void TEST_CASE_OP_JL()
+void TEST_CASE_OP_SELECT()
 {
-    uint8_t program[] = {
-        OP_JL, R1, R2, 6, 0,
-        OP_HALT,
-        OP_LCONSB, R0, 1,
-        OP_HALT};
-    VM vm(program, sizeof(program));
+    printf("%s\n", "Test: Register operands;");
+    {
+        uint8_t program[] = {
+            OP_SELECT, R0, R1, R2, COND_G, R3, R4,
+            OP_SELECT, R5, R1, R2, COND_A, R3, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, 10);
+        vm.setRegister(R2, 20);
+        vm.setRegister(R3, 1);
+        vm.setRegister(R4, (uint32_t)-1);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 10);
+        assert(vm.getRegister(R5) == 20);
+    }
 
-    printf("%s\n", "Teste: False - greater negative;");
+    printf("%s\n", "Test: Immediate operand;");
     {
-        int32_t val1 = -122;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        uint8_t program[] = {
+            OP_SELECTI, R0, R1, R2, COND_FL, R3, 0x00, 0x00, 0x80, 0x3F,
+            OP_SELECTI, R5, R1, R2, COND_E, R3, 0x00, 0x00, 0x80, 0x3F,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, 10);
+        vm.setRegister(R2, 20);
+        vm.setRegister(R3, floatBits(0.5f));
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 10);
+        assert(vm.getRegister(R5) == 20);
     }
 
-    printf("%s\n", "Teste: False - greater neg/pos;");
+    printf("%s\n", "Test: Destination among the sources;");
     {
-        vm.reset();
-        int32_t val1 = 1;
-        int32_t val2 = -122;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        uint8_t program[] = {
+            OP_SELECT, R1, R2, R1, COND_B, R1, R2,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, 3);
+        vm.setRegister(R2, 9);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R1) == 9);
     }
+}
 
-    printf("%s\n", "Teste: False - equal;");
+void TEST_CASE_OP_MIN_MAX()
+{
+    uint8_t program[] = {
+        OP_MIN, R0, R4, R5,
+        OP_MAX, R1, R4, R5,
+        OP_IMIN, R2, R4, R5,
+        OP_IMAX, R3, R4, R5,
+        OP_HALT};
+
+    printf("%s\n", "Test: Signed and unsigned order;");
     {
-        vm.reset();
-        int32_t val1 = -123;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
+        VM vm(program, sizeof(program));
+        vm.setRegister(R4, (uint32_t)-5);
+        vm.setRegister(R5, 3);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 3);
+        assert(vm.getRegister(R1) == (uint32_t)-5);
+        assert(vm.getRegister(R2) == (uint32_t)-5);
+        assert(vm.getRegister(R3) == 3);
     }
 
-    printf("%s\n", "Teste: True - below negative;");
+    printf("%s\n", "Test: Equal operands;");
     {
-        vm.reset();
-        int32_t val1 = -124;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
+        VM vm(program, sizeof(program));
+        vm.setRegister(R4, _U32_GARBAGE);
+        vm.setRegister(R5, _U32_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        for (uint8_t r = R0; r <= R3; r++)
+            assert(vm.getRegister((Register)r) == _U32_GARBAGE);
+    }
+}
+
+void TEST_CASE_OP_JMP()
+{
+    printf("%s\n", "Teste: Jump and set 1;");
+    {
+        uint8_t program[] = {
+            OP_JMP, 4, 0,
+            OP_HALT,
+            OP_LCONSB, R0, 1,
+            OP_HALT};
+        VM vm(program, sizeof(program));
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 1);
     }
+}
 
-    printf("%s\n", "Teste: True - below neg/pos;");
+void TEST_CASE_OP_JR()
+{
+    printf("%s\n", "Teste: Jump and set 1;");
     {
-        vm.reset();
-        int32_t val1 = -124;
-        int32_t val2 = 1;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
+        uint8_t program[] = {
+            OP_JR, R1,
+            OP_HALT,
+            OP_LCONSB, R0, 1,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, 3);
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 1);
     }
 }
 
-void TEST_CASE_OP_JBE()
+void TEST_CASE_OP_JZ()
 {
     uint8_t program[] = {
-        OP_JBE, R1, R2, 6, 0,
+        OP_JZ, R1, 5, 0,
         OP_HALT,
         OP_LCONSB, R0, 1,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: False - above;");
+    printf("%s\n", "Teste: True;");
+    {
+        assert(vm.getRegister(R1) == 0);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1);
+    }
+
+    printf("%s\n", "Teste: False;");
     {
+        vm.reset();
         vm.setRegister(R1, 123);
-        vm.setRegister(R2, 122);
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 0);
     }
+}
 
-    printf("%s\n", "Teste: True - equal;");
+void TEST_CASE_OP_JNZ()
+{
+    uint8_t program[] = {
+        OP_JNZ, R1, 5, 0,
+        OP_HALT,
+        OP_LCONSB, R0, 1,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Teste: True;");
     {
-        vm.reset();
         vm.setRegister(R1, 123);
-        vm.setRegister(R2, 123);
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 1);
     }
 
-    printf("%s\n", "Teste: True - below;");
+    printf("%s\n", "Teste: False;");
     {
         vm.reset();
-        vm.setRegister(R1, 122);
-        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R1) == 0);
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 0);
     }
 }
 
-void TEST_CASE_OP_JLE()
+void TEST_CASE_OP_JE()
 {
     uint8_t program[] = {
-        OP_JLE, R1, R2, 6, 0,
+        OP_JE, R1, R2, 6, 0,
         OP_HALT,
         OP_LCONSB, R0, 1,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: False - greater negative;");
+    printf("%s\n", "Teste: True;");
     {
-        int32_t val1 = -122;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 123);
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R0) == 1);
     }
 
-    printf("%s\n", "Teste: False - greater neg/pos;");
+    printf("%s\n", "Teste: False;");
     {
         vm.reset();
-        int32_t val1 = 1;
-        int32_t val2 = -122;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R1) == 0);
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 0);
     }
+}
 
-    printf("%s\n", "Teste: True - equal;");
-    {
-        vm.reset();
-        int32_t val1 = -123;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
-        assert(vm.getRegister(R0) == 0);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
-    }
+void TEST_CASE_OP_JNE()
+{
+    uint8_t program[] = {
+        OP_JNE, R1, R2, 6, 0,
+        OP_HALT,
+        OP_LCONSB, R0, 1,
+        OP_HALT};
+    VM vm(program, sizeof(program));
 
-    printf("%s\n", "Teste: True - below negative;");
+    printf("%s\n", "Teste: False;");
     {
-        vm.reset();
-        int32_t val1 = -124;
-        int32_t val2 = -123;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 123);
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1);
+        assert(vm.getRegister(R0) == 0);
     }
 
-    printf("%s\n", "Teste: True - below neg/pos;");
+    printf("%s\n", "Teste: True;");
     {
         vm.reset();
-        int32_t val1 = -124;
-        int32_t val2 = 1;
-        vm.setRegister(R1, *((uint32_t *)&val1));
-        vm.setRegister(R2, *((uint32_t *)&val2));
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R1) == 0);
         assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
         assert(vm.getRegister(R0) == 1);
     }
 }
 
-void TEST_CASE_OP_F2I()
+void TEST_CASE_OP_JA()
 {
     uint8_t program[] = {
-        OP_F2I, R0, R1,
+        OP_JA, R1, R2, 6, 0,
+        OP_HALT,
+        OP_LCONSB, R0, 1,
         OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Test: 1345.937;");
-    {
-        float val = 1345.937f;
-        int32_t expected = 1345;
-        vm.setRegister(R1, *((uint32_t *)&val));
-        assert(vm.run() == ExecResult::VM_FINISHED);
-
-        assert(vm.getRegister(R0) == *((uint32_t *)&expected));
-    }
-
-    printf("%s\n", "Test: -781345.719;");
+    printf("%s\n", "Teste: True;");
     {
-        float val = -781345.719;
-        int32_t expected = -781345;
-        vm.setRegister(R1, *((uint32_t *)&val));
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 122);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        
-        assert(vm.getRegister(R0) == *((uint32_t *)&expected));
+        assert(vm.getRegister(R0) == 1);
     }
-}
-
-void TEST_CASE_OP_I2F()
-{
-    uint8_t program[] = {
-        OP_I2F, R0, R1,
-        OP_HALT};
-    VM vm(program, sizeof(program));
 
-    printf("%s\n", "Test: 1345;");
+    printf("%s\n", "Teste: False - equal;");
     {
-        int32_t val = 1345;
-        float expected = 1345.0f;
-        vm.setRegister(R1, *((uint32_t *)&val));
+        vm.reset();
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-
-        assert(vm.getRegister(R0) == *((uint32_t *)&expected));
+        assert(vm.getRegister(R0) == 0);
     }
 
-    printf("%s\n", "Test: -781345;");
+    printf("%s\n", "Teste: False - below;");
     {
-        int32_t val = -781345;
-        float expected = -781345.0f;
-        vm.setRegister(R1, *((uint32_t *)&val));
+        vm.reset();
+        vm.setRegister(R1, 122);
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-
-        assert(vm.getRegister(R0) == *((uint32_t *)&expected));
+        assert(vm.getRegister(R0) == 0);
     }
 }
 
-void TEST_CASE_OP_STOR()
+void TEST_CASE_OP_JG()
 {
     uint8_t program[] = {
-        OP_STOR, 5, 0, R0,
+        OP_JG, R1, R2, 6, 0,
         OP_HALT,
-        0, 0, 0, 0, 0xFF};
+        OP_LCONSB, R0, 1,
+        OP_HALT};
     VM vm(program, sizeof(program));
-    uint32_t actual = 0;
 
-    printf("%s\n", "Test: Store value;");
+    printf("%s\n", "Teste: True - negative;");
     {
-        vm.setRegister(R0, _U32_GARBAGE);
+        int32_t val1 = -122;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[5], 4);
-
-        assert(memory[4] == OP_HALT);
-        assert(actual == _U32_GARBAGE);
-        assert(memory[9] == 0xFF);
+        assert(vm.getRegister(R0) == 1);
     }
 
-    printf("%s\n", "Test: Store zero;");
+    printf("%s\n", "Teste: True - neg/pos;");
     {
         vm.reset();
-        vm.setRegister(R0, 0);
+        int32_t val1 = 1;
+        int32_t val2 = -122;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[5], 4);
-
-        assert(memory[4] == OP_HALT);
-        assert(actual == 0);
-        assert(memory[9] == 0xFF);
+        assert(vm.getRegister(R0) == 1);
     }
-}
-
-void TEST_CASE_OP_STOR_P()
-{
-    uint8_t program[] = {
-        OP_STOR_P, R1, R0,
-        OP_HALT,
-        0, 0, 0, 0, 0xFF};
-    VM vm(program, sizeof(program));
-    uint32_t actual = 0;
 
-    printf("%s\n", "Test: Store value;");
+    printf("%s\n", "Teste: False - equal;");
     {
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, _U32_GARBAGE);
+        vm.reset();
+        int32_t val1 = -123;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[4], 4);
-
-        assert(memory[3] == OP_HALT);
-        assert(actual == _U32_GARBAGE);
-        assert(memory[8] == 0xFF);
+        assert(vm.getRegister(R0) == 0);
     }
 
-    printf("%s\n", "Test: Store zero;");
+    printf("%s\n", "Teste: False - below negative;");
     {
         vm.reset();
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, 0);
+        int32_t val1 = -124;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[4], 4);
+        assert(vm.getRegister(R0) == 0);
+    }
 
-        assert(memory[3] == OP_HALT);
-        assert(actual == 0);
-        assert(memory[8] == 0xFF);
+    printf("%s\n", "Teste: False - below neg/pos;");
+    {
+        vm.reset();
+        int32_t val1 = -124;
+        int32_t val2 = 1;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
     }
 }
 
-void TEST_CASE_OP_STORW()
+void TEST_CASE_OP_JAE()
 {
     uint8_t program[] = {
-        OP_STORW, 5, 0, R0,
+        OP_JAE, R1, R2, 6, 0,
         OP_HALT,
-        0, 0, 0xFF};
+        OP_LCONSB, R0, 1,
+        OP_HALT};
     VM vm(program, sizeof(program));
-    uint16_t actual = 0;
 
-    printf("%s\n", "Test: Store value;");
+    printf("%s\n", "Teste: True - above;");
     {
-        vm.setRegister(R0, _U16_GARBAGE);
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 122);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[5], 2);
-
-        assert(memory[4] == OP_HALT);
-        assert(actual == _U16_GARBAGE);
-        assert(memory[7] == 0xFF);
+        assert(vm.getRegister(R0) == 1);
     }
 
-    printf("%s\n", "Test: Store zero;");
+    printf("%s\n", "Teste: True - equal;");
     {
         vm.reset();
-        vm.setRegister(R0, 0);
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[5], 2);
+        assert(vm.getRegister(R0) == 1);
+    }
 
-        assert(memory[4] == OP_HALT);
-        assert(actual == 0);
-        assert(memory[7] == 0xFF);
+    printf("%s\n", "Teste: False - below;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 122);
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
     }
 }
 
-void TEST_CASE_OP_STORW_P()
+void TEST_CASE_OP_JGE()
 {
     uint8_t program[] = {
-        OP_STORW_P, R1, R0,
+        OP_JGE, R1, R2, 6, 0,
         OP_HALT,
-        0, 0, 0xFF};
+        OP_LCONSB, R0, 1,
+        OP_HALT};
     VM vm(program, sizeof(program));
-    uint16_t actual = 0;
 
-    printf("%s\n", "Test: Store value;");
+    printf("%s\n", "Teste: True - greater negative;");
     {
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, _U16_GARBAGE);
+        int32_t val1 = -122;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[4], 2);
-
-        assert(memory[3] == OP_HALT);
-        assert(actual == _U16_GARBAGE);
-        assert(memory[6] == 0xFF);
+        assert(vm.getRegister(R0) == 1);
     }
 
-    printf("%s\n", "Test: Store zero;");
+    printf("%s\n", "Teste: True - greater neg/pos;");
     {
         vm.reset();
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, 0);
+        int32_t val1 = 1;
+        int32_t val2 = -122;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[4], 2);
-
-        assert(memory[3] == OP_HALT);
-        assert(actual == 0);
-        assert(memory[6] == 0xFF);
+        assert(vm.getRegister(R0) == 1);
     }
-}
-
-void TEST_CASE_OP_STORB()
-{
-    uint8_t program[] = {
-        OP_STORB, 5, 0, R0,
-        OP_HALT,
-        0, 0xFF};
-    VM vm(program, sizeof(program));
 
-    printf("%s\n", "Test: Store value;");
+    printf("%s\n", "Teste: True - equal;");
     {
-        vm.setRegister(R0, _U8_GARBAGE);
+        vm.reset();
+        int32_t val1 = -123;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-
-        assert(memory[4] == OP_HALT);
-        assert(memory[5] == _U8_GARBAGE);
-        assert(memory[6] == 0xFF);
+        assert(vm.getRegister(R0) == 1);
     }
 
-    printf("%s\n", "Test: Store zero;");
+    printf("%s\n", "Teste: False - below negative;");
     {
         vm.reset();
-        vm.setRegister(R0, 0);
+        int32_t val1 = -124;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
+        assert(vm.getRegister(R0) == 0);
+    }
 
-        assert(memory[4] == OP_HALT);
-        assert(memory[5] == 0);
-        assert(memory[6] == 0xFF);
+    printf("%s\n", "Teste: False - below neg/pos;");
+    {
+        vm.reset();
+        int32_t val1 = -124;
+        int32_t val2 = 1;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
     }
 }
 
-void TEST_CASE_OP_STORB_P()
+void TEST_CASE_OP_JB()
 {
     uint8_t program[] = {
-        OP_STORB_P, R1, R0,
+        OP_JB, R1, R2, 6, 0,
         OP_HALT,
-        0, 0xFF};
+        OP_LCONSB, R0, 1,
+        OP_HALT};
     VM vm(program, sizeof(program));
 
-    printf("%s\n", "Test: Store value;");
+    printf("%s\n", "Teste: False - above;");
     {
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, _U8_GARBAGE);
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 122);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-
-        assert(memory[3] == OP_HALT);
-        assert(memory[4] == _U8_GARBAGE);
-        assert(memory[5] == 0xFF);
+        assert(vm.getRegister(R0) == 0);
     }
 
-    printf("%s\n", "Test: Store zero;");
+    printf("%s\n", "Teste: False - equal;");
     {
         vm.reset();
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, 0);
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
+        assert(vm.getRegister(R0) == 0);
+    }
 
-        assert(memory[3] == OP_HALT);
-        assert(memory[4] == 0);
-        assert(memory[5] == 0xFF);
+    printf("%s\n", "Teste: True - below;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 122);
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1);
     }
 }
 
-void TEST_CASE_OP_LOAD()
+void TEST_CASE_OP_JL()
 {
     uint8_t program[] = {
-        OP_LOAD, R0, 5, 0,
+        OP_JL, R1, R2, 6, 0,
         OP_HALT,
-        _NTH_BYTE(_U32_GARBAGE, 0), _NTH_BYTE(_U32_GARBAGE, 1),
-        _NTH_BYTE(_U32_GARBAGE, 2), _NTH_BYTE(_U32_GARBAGE, 3),
-        0xFF};
+        OP_LCONSB, R0, 1,
+        OP_HALT};
     VM vm(program, sizeof(program));
-    uint32_t actual = 0;
 
-    printf("%s\n", "Test: Load value;");
+    printf("%s\n", "Teste: False - greater negative;");
     {
+        int32_t val1 = -122;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[5], 4);
-
-        assert(memory[4] == OP_HALT);
-        assert(actual == _U32_GARBAGE);
-        assert(vm.getRegister(R0) == _U32_GARBAGE);
-        assert(memory[9] == 0xFF);
+        assert(vm.getRegister(R0) == 0);
     }
 
-    printf("%s\n", "Test: Load zero;");
+    printf("%s\n", "Teste: False - greater neg/pos;");
     {
         vm.reset();
-        uint8_t *memory = vm.memory();
-
-        memset(&memory[5], 0, 4);
-        vm.setRegister(R0, _U32_GARBAGE);
+        int32_t val1 = 1;
+        int32_t val2 = -122;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        memcpy(&actual, &memory[5], 4);
-
-        assert(memory[4] == OP_HALT);
-        assert(actual == 0);
         assert(vm.getRegister(R0) == 0);
-        assert(memory[9] == 0xFF);
     }
-}
 
-void TEST_CASE_OP_LOAD_P()
-{
-    uint8_t program[] = {
-        OP_LOAD_P, R0, R1,
-        OP_HALT,
-        _NTH_BYTE(_U32_GARBAGE, 0), _NTH_BYTE(_U32_GARBAGE, 1),
-        _NTH_BYTE(_U32_GARBAGE, 2), _NTH_BYTE(_U32_GARBAGE, 3),
-        0xFF};
-    VM vm(program, sizeof(program));
-    uint32_t actual = 0;
-
-    printf("%s\n", "Test: Load value;");
+    printf("%s\n", "Teste: False - equal;");
     {
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, 0);
+        vm.reset();
+        int32_t val1 = -123;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[4], 4);
-
-        assert(memory[3] == OP_HALT);
-        assert(actual == _U32_GARBAGE);
-        assert(vm.getRegister(R0) == _U32_GARBAGE);
-        assert(memory[8] == 0xFF);
+        assert(vm.getRegister(R0) == 0);
     }
 
-    printf("%s\n", "Test: Load zero;");
+    printf("%s\n", "Teste: True - below negative;");
     {
         vm.reset();
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, _U32_GARBAGE);
-        
-        uint8_t *memory = vm.memory();
-        memset(&memory[4], 0, 4);
-
+        int32_t val1 = -124;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        memcpy(&actual, &memory[4], 4);
+        assert(vm.getRegister(R0) == 1);
+    }
 
-        assert(memory[3] == OP_HALT);
-        assert(actual == 0);
+    printf("%s\n", "Teste: True - below neg/pos;");
+    {
+        vm.reset();
+        int32_t val1 = -124;
+        int32_t val2 = 1;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
         assert(vm.getRegister(R0) == 0);
-        assert(memory[8] == 0xFF);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1);
     }
 }
 
-void TEST_CASE_OP_LOADW()
+void TEST_CASE_OP_JBE()
 {
     uint8_t program[] = {
-        OP_LOADW, R0, 5, 0,
+        OP_JBE, R1, R2, 6, 0,
         OP_HALT,
-        _NTH_BYTE(_U16_GARBAGE, 0), _NTH_BYTE(_U16_GARBAGE, 1),
-        0xFF};
+        OP_LCONSB, R0, 1,
+        OP_HALT};
     VM vm(program, sizeof(program));
-    uint16_t actual = 0;
 
-    printf("%s\n", "Test: Load value;");
+    printf("%s\n", "Teste: False - above;");
     {
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 122);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[5], 2);
-
-        assert(memory[4] == OP_HALT);
-        assert(actual == _U16_GARBAGE);
-        assert(vm.getRegister(R0) == _U16_GARBAGE);
-        assert(memory[7] == 0xFF);
+        assert(vm.getRegister(R0) == 0);
     }
 
-    printf("%s\n", "Test: Load zero;");
+    printf("%s\n", "Teste: True - equal;");
     {
         vm.reset();
-        uint8_t *memory = vm.memory();
-
-        memset(&memory[5], 0, 2);
-        vm.setRegister(R0, _U32_GARBAGE);
+        vm.setRegister(R1, 123);
+        vm.setRegister(R2, 123);
+        assert(vm.getRegister(R0) == 0);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        memcpy(&actual, &memory[5], 2);
+        assert(vm.getRegister(R0) == 1);
+    }
 
-        assert(memory[4] == OP_HALT);
-        assert(actual == 0);
+    printf("%s\n", "Teste: True - below;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 122);
+        vm.setRegister(R2, 123);
         assert(vm.getRegister(R0) == 0);
-        assert(memory[7] == 0xFF);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1);
     }
 }
 
-void TEST_CASE_OP_LOADW_P()
+void TEST_CASE_OP_JLE()
 {
     uint8_t program[] = {
-        OP_LOADW_P, R0, R1,
+        OP_JLE, R1, R2, 6, 0,
         OP_HALT,
-        _NTH_BYTE(_U16_GARBAGE, 0), _NTH_BYTE(_U16_GARBAGE, 1),
-        0xFF};
+        OP_LCONSB, R0, 1,
+        OP_HALT};
     VM vm(program, sizeof(program));
-    uint16_t actual = 0;
 
-    printf("%s\n", "Test: Load value;");
+    printf("%s\n", "Teste: False - greater negative;");
+    {
+        int32_t val1 = -122;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+    }
+
+    printf("%s\n", "Teste: False - greater neg/pos;");
+    {
+        vm.reset();
+        int32_t val1 = 1;
+        int32_t val2 = -122;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+    }
+
+    printf("%s\n", "Teste: True - equal;");
+    {
+        vm.reset();
+        int32_t val1 = -123;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1);
+    }
+
+    printf("%s\n", "Teste: True - below negative;");
+    {
+        vm.reset();
+        int32_t val1 = -124;
+        int32_t val2 = -123;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1);
+    }
+
+    printf("%s\n", "Teste: True - below neg/pos;");
+    {
+        vm.reset();
+        int32_t val1 = -124;
+        int32_t val2 = 1;
+        vm.setRegister(R1, *((uint32_t *)&val1));
+        vm.setRegister(R2, *((uint32_t *)&val2));
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1);
+    }
+}
+
+void TEST_CASE_OP_JCCI()
+{
+    struct Case
+    {
+        Instruction op;
+        int32_t value;
+        int32_t imm;
+        bool taken;
+    };
+    const Case cases[] = {
+        {OP_JEI, 1000000, 1000000, true}, {OP_JEI, -1, 1000000, false},
+        {OP_JNEI, -1, 1000000, true}, {OP_JNEI, 1000000, 1000000, false},
+        {OP_JAI, -1, 10, true}, {OP_JAI, 10, 10, false},
+        {OP_JGI, 11, 10, true}, {OP_JGI, -1, 10, false},
+        {OP_JAEI, 10, 10, true}, {OP_JAEI, 9, 10, false},
+        {OP_JGEI, -5, -5, true}, {OP_JGEI, -6, -5, false},
+        {OP_JBI, 9, 10, true}, {OP_JBI, -1, 10, false},
+        {OP_JLI, -1, 10, true}, {OP_JLI, 10, 10, false},
+        {OP_JBEI, 10, 10, true}, {OP_JBEI, -10, 10, false},
+        {OP_JLEI, -10, -10, true}, {OP_JLEI, -9, -10, false},
+    };
+
+    for (const Case &c : cases)
+    {
+        printf("Test: %s %d, %d;\n", OP_INFO[c.op].name, c.value, c.imm);
+        uint8_t program[] = {
+            c.op, R1, (uint8_t)c.imm, (uint8_t)(c.imm >> 8), (uint8_t)(c.imm >> 16), (uint8_t)(c.imm >> 24), 9, 0,
+            OP_HALT,
+            OP_LCONSB, R0, 1,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, (uint32_t)c.value);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == (c.taken ? 1U : 0U));
+    }
+}
+
+void TEST_CASE_OP_DJNZ()
+{
+    printf("%s\n", "Test: Loop runs the counter down to zero;");
+    {
+        uint8_t program[] = {
+            OP_ADDIB, R1, R1, 3,
+            OP_DJNZ, R0, 0, 0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, 10);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R1) == 30);
+        assert(vm.retired() == 20);
+    }
+
+    printf("%s\n", "Test: Zero wraps around and jumps;");
+    {
+        uint8_t program[] = {
+            OP_DJNZ, R0, 5, 0,
+            OP_HALT,
+            OP_LCONSB, R1, 1,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == UINT32_MAX);
+        assert(vm.getRegister(R1) == 1);
+    }
+}
+
+void TEST_CASE_OP_RELATIVE_JUMPS()
+{
+    printf("%s\n", "Test: Forward and backward offsets;");
+    {
+        uint8_t program[] = {
+            OP_JMP_S, 5,
+            OP_LCONSB, R2, 1,
+            OP_ADDIB, R1, R1, 2, // 5
+            OP_DJNZ_S, R0, (uint8_t)-4,
+            OP_JZ_S, R0, 4, // 12
+            OP_HALT,
+            OP_JNZ_S, R0, (uint8_t)-1, // 16
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, 4);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R1) == 8);
+        assert(vm.getRegister(R2) == 0);
+        assert(vm.getRegister(IP) == 19);
+    }
+
+    printf("%s\n", "Test: Code moved elsewhere runs unchanged;");
+    {
+        uint8_t loop[] = {
+            OP_ADDIB, R1, R1, 1,
+            OP_DJNZ_S, R0, (uint8_t)-4,
+            OP_HALT};
+        uint8_t program[32] = {OP_JMP, 20, 0};
+        memcpy(&program[20], loop, sizeof(loop));
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, 7);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R1) == 7);
+    }
+
+    printf("%s\n", "Test: Offsets before the start are invalid;");
+    {
+        uint8_t program[] = {
+            OP_JMP_S, (uint8_t)-2,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_ERR_INVALID_ADDRESS);
+    }
+
+    printf("%s\n", "Test: Analysis and disassembly follow offsets;");
+    {
+        uint8_t program[] = {
+            OP_INC, R1,
+            OP_DJNZ_S, R0, (uint8_t)-2,
+            OP_JNEI, R1, 0xE8, 0x03, 0, 0, 0, 0,
+            OP_HALT};
+        Program analysis(program, sizeof(program));
+        assert(analysis.verified);
+        assert(analysis.isLeader(0) && analysis.isLeader(5) && analysis.isLeader(13));
+        char text[64];
+        assert(disassemble(program, sizeof(program), 2, text, sizeof(text)) == 3);
+        assert(strcmp(text, "djnz_s r0, 0x0000") == 0);
+        assert(disassemble(program, sizeof(program), 5, text, sizeof(text)) == 8);
+        assert(strcmp(text, "jnei r1, 1000, 0x0000") == 0);
+    }
+}
+
+void TEST_CASE_OP_SWITCH()
+{
+    uint8_t program[] = {
+        OP_SWITCH, R0, 3, 0, 28, 0,
+        19, 0, 22, 0, 25, 0,
+        OP_HALT,
+        OP_HALT,
+        OP_HALT,
+        OP_HALT,
+        OP_HALT,
+        OP_HALT,
+        OP_HALT,
+        OP_LCONSB, R1, 1, // 19
+        OP_LCONSB, R1, 2, // 22
+        OP_LCONSB, R1, 3, // 25
+        OP_LCONSB, R2, 9, // 28
+        OP_HALT};
+
+    printf("%s\n", "Test: Every entry;");
+    {
+        for (uint32_t index = 0; index < 3; index++)
+        {
+            VM vm(program, sizeof(program));
+            vm.setRegister(R0, index);
+            assert(vm.run() == ExecResult::VM_FINISHED);
+            assert(vm.getRegister(R1) == 3);
+            assert(vm.getRegister(R2) == 9);
+        }
+
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, 2);
+        assert(vm.run(1) == ExecResult::VM_PAUSED);
+        assert(vm.getRegister(IP) == 25);
+    }
+
+    printf("%s\n", "Test: Out of range takes the default;");
+    {
+        const uint32_t indexes[] = {3, 255, 0x10000, UINT32_MAX};
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            VM vm(program, sizeof(program));
+            vm.setRegister(R0, indexes[i]);
+            assert(vm.run() == ExecResult::VM_FINISHED);
+            assert(vm.getRegister(R1) == 0);
+            assert(vm.getRegister(R2) == 9);
+        }
+    }
+
+    printf("%s\n", "Test: Empty table;");
+    {
+        uint8_t empty[] = {
+            OP_SWITCH, R0, 0, 0, 7, 0,
+            OP_HALT,
+            OP_INC, R1, // 7
+            OP_HALT};
+        VM vm(empty, sizeof(empty));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R1) == 1);
+    }
+
+    printf("%s\n", "Test: Table past the end of memory;");
+    {
+        uint8_t truncated[] = {
+            OP_SWITCH, R0, 0xFF, 0x7F, 0, 0};
+        VM vm(truncated, sizeof(truncated));
+        assert(vm.run() == ExecResult::VM_ERR_INVALID_ADDRESS);
+        Program analysis(truncated, sizeof(truncated));
+        assert(!analysis.verified);
+    }
+
+    printf("%s\n", "Test: Every target is known statically;");
+    {
+        Program analysis(program, sizeof(program));
+        assert(analysis.verified);
+        assert(analysis.isLeader(19) && analysis.isLeader(22) && analysis.isLeader(25) && analysis.isLeader(28));
+        assert(!analysis.isStart(6) && !analysis.isStart(12));
+
+        uint8_t intoTable[sizeof(program)];
+        memcpy(intoTable, program, sizeof(program));
+        intoTable[7] = 8;
+        Program bad(intoTable, sizeof(intoTable));
+        assert(!bad.verified);
+
+        char text[64];
+        assert(disassemble(program, sizeof(program), 0, text, sizeof(text)) == 6);
+        assert(strcmp(text, "switch r0, 3, 0x001c") == 0);
+    }
+}
+
+void TEST_CASE_OP_CHECKSUMS()
+{
+    // every opcode runs over the r3 bytes at r2, continuing from its destination's value
+    uint8_t program[] = {
+        OP_CRC32C, R0, R2, R3,
+        OP_ADLER32, R1, R2, R3,
+        OP_FLETCHER32, R4, R2, R3,
+        OP_HASH64, T0, R2, R3,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Reference values;");
+    {
+        memcpy(vm.memory(40), "123456789", 9);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 9);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0xE3069283);
+        assert(vm.getRegister64(T0) == 0x4977490251674330ULL);
+
+        vm.reset();
+        memcpy(vm.memory(40), "123456789", 9);
+        vm.setRegister64(T0, 0x1234);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 9);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(T0) == 0x24CFBF0492F9DFULL);
+
+        vm.reset();
+        memcpy(vm.memory(40), "Wikipedia", 9);
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 9);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R1) == 0x11E60398);
+
+        vm.reset();
+        memcpy(vm.memory(40), "abcdef", 6);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 5);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R4) == 0xF04FC729);
+
+        vm.reset();
+        memcpy(vm.memory(40), "abcdef", 6);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 6);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R4) == 0x56502D2A);
+    }
+
+    printf("%s\n", "Test: An empty range keeps the value;");
+    {
+        vm.reset();
+        vm.setRegister(R0, 0x12345678);
+        vm.setRegister(R1, 1);
+        vm.setRegister(R4, 0xABCD);
+        vm.setRegister64(T0, 0x1234);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0x12345678);
+        assert(vm.getRegister(R1) == 1);
+        assert(vm.getRegister(R4) == 0xABCD);
+    }
+
+    printf("%s\n", "Test: Chunks continue the running value;");
+    {
+        vm.reset();
+        memcpy(vm.memory(40), "checksums in chunks", 19);
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 19);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        const uint32_t crc = vm.getRegister(R0);
+        const uint32_t adler = vm.getRegister(R1);
+        const uint32_t fletcher = vm.getRegister(R4);
+
+        vm.reset();
+        memcpy(vm.memory(40), "checksums ", 10);
+        vm.setRegister(R1, 1);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 10);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        const uint32_t head[] = {vm.getRegister(R0), vm.getRegister(R1), vm.getRegister(R4)};
+
+        vm.reset();
+        memcpy(vm.memory(40), "in chunks", 9);
+        vm.setRegister(R0, head[0]);
+        vm.setRegister(R1, head[1]);
+        vm.setRegister(R4, head[2]);
+        vm.setRegister(R2, 40);
+        vm.setRegister(R3, 9);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == crc);
+        assert(vm.getRegister(R1) == adler);
+        assert(vm.getRegister(R4) == fletcher);
+    }
+
+    printf("%s\n", "Test: Range past the end of memory;");
+    {
+        vm.reset();
+        vm.setRegister(R2, 0xFFF0);
+        vm.setRegister(R3, 0x20);
+        assert(vm.run() == ExecResult::VM_ERR_INVALID_ADDRESS);
+    }
+
+    printf("%s\n", "Test: Hash into the last register;");
+    {
+        uint8_t program[] = {
+            OP_HASH64, T9, R2, R3,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_ERR_INVALID_REGISTER);
+    }
+}
+
+float bitsFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void TEST_CASE_OP_FMA()
+{
+    uint8_t program[] = {
+        OP_FMA, R0, R1, R2, R3,
+        OP_FMUL, R4, R1, R2,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+
+    printf("%s\n", "Test: 2 * 3 + 1;");
+    {
+        vm.setRegister(R1, floatBits(2.0f));
+        vm.setRegister(R2, floatBits(3.0f));
+        vm.setRegister(R3, floatBits(1.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == 7.0f);
+    }
+
+    printf("%s\n", "Test: -1.5 * 4 + 0.5;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(-1.5f));
+        vm.setRegister(R2, floatBits(4.0f));
+        vm.setRegister(R3, floatBits(0.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == -5.5f);
+    }
+
+    printf("%s\n", "Test: Rounded once;");
+    {
+        // (1 + 2^-12)^2 - (1 + 2^-11) is 2^-24, lost when the product is rounded first
+        const float a = 1.0f + ldexpf(1.0f, -12);
+        const float c = -(1.0f + ldexpf(1.0f, -11));
+        vm.reset();
+        vm.setRegister(R1, floatBits(a));
+        vm.setRegister(R2, floatBits(a));
+        vm.setRegister(R3, floatBits(c));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == ldexpf(1.0f, -24));
+        assert(bitsFloat(vm.getRegister(R4)) + c == 0.0f);
+    }
+
+    printf("%s\n", "Test: NaN addend;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(1.0f));
+        vm.setRegister(R2, floatBits(1.0f));
+        vm.setRegister(R3, floatBits(nan));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+    }
+
+    printf("%s\n", "Test: NaN factor;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(nan));
+        vm.setRegister(R2, floatBits(1.0f));
+        vm.setRegister(R3, floatBits(1.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+    }
+
+    printf("%s\n", "Test: inf * 0 + 1;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(inf));
+        vm.setRegister(R2, floatBits(0.0f));
+        vm.setRegister(R3, floatBits(1.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+    }
+
+    printf("%s\n", "Test: inf * 1 - inf;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(inf));
+        vm.setRegister(R2, floatBits(1.0f));
+        vm.setRegister(R3, floatBits(-inf));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+    }
+}
+
+void TEST_CASE_OP_FLOAT_UNARY()
+{
+    uint8_t program[] = {
+        OP_FSQRT, R0, R1,
+        OP_FABS, R2, R1,
+        OP_FNEG, R3, R1,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+
+    printf("%s\n", "Test: 2.25;");
+    {
+        vm.setRegister(R1, floatBits(2.25f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == 1.5f);
+        assert(bitsFloat(vm.getRegister(R2)) == 2.25f);
+        assert(bitsFloat(vm.getRegister(R3)) == -2.25f);
+    }
+
+    printf("%s\n", "Test: -3.5;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(-3.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+        assert(bitsFloat(vm.getRegister(R2)) == 3.5f);
+        assert(bitsFloat(vm.getRegister(R3)) == 3.5f);
+    }
+
+    printf("%s\n", "Test: inf;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(inf));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == inf);
+        assert(bitsFloat(vm.getRegister(R2)) == inf);
+        assert(bitsFloat(vm.getRegister(R3)) == -inf);
+    }
+
+    printf("%s\n", "Test: -inf;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(-inf));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+        assert(bitsFloat(vm.getRegister(R2)) == inf);
+        assert(bitsFloat(vm.getRegister(R3)) == inf);
+    }
+
+    printf("%s\n", "Test: -0;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 0x80000000);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0x80000000);
+        assert(vm.getRegister(R2) == 0);
+        assert(vm.getRegister(R3) == 0);
+    }
+
+    printf("%s\n", "Test: NaN keeps its payload;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 0xFFC00001);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+        assert(vm.getRegister(R2) == 0x7FC00001);
+        assert(vm.getRegister(R3) == 0x7FC00001);
+
+        vm.reset();
+        vm.setRegister(R1, floatBits(nan));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R3) == (floatBits(nan) ^ 0x80000000));
+    }
+}
+
+void TEST_CASE_OP_FMIN_FMAX()
+{
+    uint8_t program[] = {
+        OP_FMIN, R0, R1, R2,
+        OP_FMAX, R3, R1, R2,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+
+    printf("%s\n", "Test: 1 and 2;");
+    {
+        vm.setRegister(R1, floatBits(1.0f));
+        vm.setRegister(R2, floatBits(2.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == 1.0f);
+        assert(bitsFloat(vm.getRegister(R3)) == 2.0f);
+    }
+
+    printf("%s\n", "Test: -inf and -7.25;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(-inf));
+        vm.setRegister(R2, floatBits(-7.25f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == -inf);
+        assert(bitsFloat(vm.getRegister(R3)) == -7.25f);
+    }
+
+    printf("%s\n", "Test: -0 orders below +0;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 0);
+        vm.setRegister(R2, 0x80000000);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0x80000000);
+        assert(vm.getRegister(R3) == 0);
+
+        vm.reset();
+        vm.setRegister(R1, 0x80000000);
+        vm.setRegister(R2, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0x80000000);
+        assert(vm.getRegister(R3) == 0);
+    }
+
+    printf("%s\n", "Test: A NaN operand is ignored;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(nan));
+        vm.setRegister(R2, floatBits(2.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == 2.0f);
+        assert(bitsFloat(vm.getRegister(R3)) == 2.0f);
+
+        vm.reset();
+        vm.setRegister(R1, floatBits(-inf));
+        vm.setRegister(R2, floatBits(nan));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == -inf);
+        assert(bitsFloat(vm.getRegister(R3)) == -inf);
+    }
+
+    printf("%s\n", "Test: Two NaN operands;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(nan));
+        vm.setRegister(R2, floatBits(nan));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+        assert(std::isnan(bitsFloat(vm.getRegister(R3))));
+    }
+}
+
+void TEST_CASE_OP_FLOAT_ROUNDING()
+{
+    uint8_t program[] = {
+        OP_FFLOOR, R0, R1,
+        OP_FCEIL, R2, R1,
+        OP_FROUND, R3, R1,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+
+    printf("%s\n", "Test: 2.5;");
+    {
+        vm.setRegister(R1, floatBits(2.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == 2.0f);
+        assert(bitsFloat(vm.getRegister(R2)) == 3.0f);
+        assert(bitsFloat(vm.getRegister(R3)) == 2.0f);
+    }
+
+    printf("%s\n", "Test: -2.5;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(-2.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == -3.0f);
+        assert(bitsFloat(vm.getRegister(R2)) == -2.0f);
+        assert(bitsFloat(vm.getRegister(R3)) == -2.0f);
+    }
+
+    printf("%s\n", "Test: Ties round to even;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(3.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R3)) == 4.0f);
+
+        vm.reset();
+        vm.setRegister(R1, floatBits(2.75f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R3)) == 3.0f);
+    }
+
+    printf("%s\n", "Test: The host rounding mode does not matter;");
+    {
+        const int mode = fegetround();
+        fesetround(FE_UPWARD);
+        vm.reset();
+        vm.setRegister(R1, floatBits(2.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        const uint32_t up = vm.getRegister(R3);
+        fesetround(FE_DOWNWARD);
+        vm.reset();
+        vm.setRegister(R1, floatBits(-3.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        const uint32_t down = vm.getRegister(R3);
+        fesetround(mode);
+        assert(bitsFloat(up) == 2.0f);
+        assert(bitsFloat(down) == -4.0f);
+    }
+
+    printf("%s\n", "Test: -0.5 rounds to -0;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(-0.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == -1.0f);
+        assert(vm.getRegister(R2) == 0x80000000);
+        assert(vm.getRegister(R3) == 0x80000000);
+    }
+
+    printf("%s\n", "Test: Integers, infinities and NaN are kept;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(1e10f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == 1e10f);
+        assert(bitsFloat(vm.getRegister(R2)) == 1e10f);
+        assert(bitsFloat(vm.getRegister(R3)) == 1e10f);
+
+        vm.reset();
+        vm.setRegister(R1, floatBits(-inf));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsFloat(vm.getRegister(R0)) == -inf);
+        assert(bitsFloat(vm.getRegister(R2)) == -inf);
+        assert(bitsFloat(vm.getRegister(R3)) == -inf);
+
+        vm.reset();
+        vm.setRegister(R1, floatBits(nan));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsFloat(vm.getRegister(R0))));
+        assert(std::isnan(bitsFloat(vm.getRegister(R2))));
+        assert(std::isnan(bitsFloat(vm.getRegister(R3))));
+    }
+}
+
+void TEST_CASE_OP_FLOAT_JUMPS()
+{
+    // each jump skips the increment after it, so a register left at 0 marks a taken jump
+    uint8_t program[] = {
+        OP_JFE, R1, R2, 7, 0,
+        OP_INC, T0,
+        OP_JFNE, R1, R2, 14, 0, // 7
+        OP_INC, T1,
+        OP_JFG, R1, R2, 21, 0, // 14
+        OP_INC, T2,
+        OP_JFGE, R1, R2, 28, 0, // 21
+        OP_INC, T3,
+        OP_JFL, R1, R2, 35, 0, // 28
+        OP_INC, T4,
+        OP_JFLE, R1, R2, 42, 0, // 35
+        OP_INC, T5,
+        OP_HALT}; // 42
+    VM vm(program, sizeof(program));
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    printf("%s\n", "Test: -2.5 and 1;");
+    {
+        vm.setRegister(R1, floatBits(-2.5f));
+        vm.setRegister(R2, floatBits(1.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T0) == 1); // jfe
+        assert(vm.getRegister(T1) == 0); // jfne
+        assert(vm.getRegister(T2) == 1); // jfg
+        assert(vm.getRegister(T3) == 1); // jfge
+        assert(vm.getRegister(T4) == 0); // jfl
+        assert(vm.getRegister(T5) == 0); // jfle
+    }
+
+    printf("%s\n", "Test: 1 and -2.5;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(1.0f));
+        vm.setRegister(R2, floatBits(-2.5f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T0) == 1);
+        assert(vm.getRegister(T1) == 0);
+        assert(vm.getRegister(T2) == 0);
+        assert(vm.getRegister(T3) == 0);
+        assert(vm.getRegister(T4) == 1);
+        assert(vm.getRegister(T5) == 1);
+    }
+
+    printf("%s\n", "Test: 1 and 1;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(1.0f));
+        vm.setRegister(R2, floatBits(1.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T0) == 0);
+        assert(vm.getRegister(T1) == 1);
+        assert(vm.getRegister(T2) == 1);
+        assert(vm.getRegister(T3) == 0);
+        assert(vm.getRegister(T4) == 1);
+        assert(vm.getRegister(T5) == 0);
+    }
+
+    printf("%s\n", "Test: -0 equals +0;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 0x80000000);
+        vm.setRegister(R2, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T0) == 0);
+        assert(vm.getRegister(T1) == 1);
+        assert(vm.getRegister(T4) == 1);
+    }
+
+    printf("%s\n", "Test: NaN only takes jfne;");
+    {
+        vm.reset();
+        vm.setRegister(R1, floatBits(nan));
+        vm.setRegister(R2, floatBits(1.0f));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T0) == 1);
+        assert(vm.getRegister(T1) == 0);
+        assert(vm.getRegister(T2) == 1);
+        assert(vm.getRegister(T3) == 1);
+        assert(vm.getRegister(T4) == 1);
+        assert(vm.getRegister(T5) == 1);
+
+        vm.reset();
+        vm.setRegister(R1, floatBits(1.0f));
+        vm.setRegister(R2, floatBits(nan));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T0) == 1);
+        assert(vm.getRegister(T1) == 0);
+        assert(vm.getRegister(T2) == 1);
+        assert(vm.getRegister(T3) == 1);
+        assert(vm.getRegister(T4) == 1);
+        assert(vm.getRegister(T5) == 1);
+
+        vm.reset();
+        vm.setRegister(R1, floatBits(nan));
+        vm.setRegister(R2, floatBits(nan));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(T0) == 1);
+        assert(vm.getRegister(T1) == 0);
+        assert(vm.getRegister(T2) == 1);
+        assert(vm.getRegister(T3) == 1);
+        assert(vm.getRegister(T4) == 1);
+        assert(vm.getRegister(T5) == 1);
+    }
+}
+
+void TEST_CASE_OP_F2I()
+{
+    uint8_t program[] = {
+        OP_F2I, R0, R1,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: 1345.937;");
+    {
+        float val = 1345.937f;
+        int32_t expected = 1345;
+        vm.setRegister(R1, *((uint32_t *)&val));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        assert(vm.getRegister(R0) == *((uint32_t *)&expected));
+    }
+
+    printf("%s\n", "Test: -781345.719;");
+    {
+        vm.reset();
+        float val = -781345.719;
+        int32_t expected = -781345;
+        vm.setRegister(R1, *((uint32_t *)&val));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        
+        assert(vm.getRegister(R0) == *((uint32_t *)&expected));
+    }
+}
+
+void TEST_CASE_OP_I2F()
+{
+    uint8_t program[] = {
+        OP_I2F, R0, R1,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: 1345;");
+    {
+        int32_t val = 1345;
+        float expected = 1345.0f;
+        vm.setRegister(R1, *((uint32_t *)&val));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        assert(vm.getRegister(R0) == *((uint32_t *)&expected));
+    }
+
+    printf("%s\n", "Test: -781345;");
+    {
+        vm.reset();
+        int32_t val = -781345;
+        float expected = -781345.0f;
+        vm.setRegister(R1, *((uint32_t *)&val));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        assert(vm.getRegister(R0) == *((uint32_t *)&expected));
+    }
+}
+
+uint64_t doubleBits(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(uint64_t bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void TEST_CASE_OP_QWORD()
+{
+    printf("%s\n", "Test: Carries and borrows across the halves;");
+    {
+        uint8_t program[] = {
+            OP_ADDQ, R0, R2, R4,
+            OP_SUBQ, T0, R2, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister64(R2, 0xFFFFFFFFULL);
+        vm.setRegister64(R4, 1);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(R0) == 0x100000000ULL);
+        assert(vm.getRegister64(T0) == 0xFFFFFFFEULL);
+
+        vm.reset();
+        vm.setRegister64(R2, UINT64_MAX);
+        vm.setRegister64(R4, 2);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(R0) == 1);
+        assert(vm.getRegister64(T0) == UINT64_MAX - 2);
+
+        vm.reset();
+        vm.setRegister64(R2, 0x100000000ULL);
+        vm.setRegister64(R4, 1);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(R0) == 0x100000001ULL);
+        assert(vm.getRegister64(T0) == 0xFFFFFFFFULL);
+
+        vm.reset();
+        vm.setRegister64(R2, 0);
+        vm.setRegister64(R4, 1);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(T0) == UINT64_MAX);
+    }
+
+    printf("%s\n", "Test: Multiply, divide and modulo;");
+    {
+        uint8_t program[] = {
+            OP_MULQ, R0, R2, R4,
+            OP_DIVQ, T0, R2, R4,
+            OP_IDIVQ, T2, R2, R4,
+            OP_MODQ, T4, R2, R4,
+            OP_IMODQ, T6, R2, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister64(R2, 0x100000000ULL);
+        vm.setRegister64(R4, 3);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(R0) == 0x300000000ULL);
+        assert(vm.getRegister64(T0) == 0x55555555ULL);
+        assert(vm.getRegister64(T4) == 1);
+
+        vm.reset();
+        vm.setRegister64(R2, 1000000007ULL);
+        vm.setRegister64(R4, 1000000009ULL);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(R0) == 1000000016000000063ULL);
+        assert(vm.getRegister64(T0) == 0);
+        assert(vm.getRegister64(T4) == 1000000007ULL);
+
+        vm.reset();
+        vm.setRegister64(R2, UINT64_MAX);
+        vm.setRegister64(R4, 3);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(T0) == 0x5555555555555555ULL);
+        assert(vm.getRegister64(T2) == 0);
+        assert(vm.getRegister64(T6) == UINT64_MAX);
+
+        vm.reset();
+        vm.setRegister64(R2, (uint64_t)-9LL);
+        vm.setRegister64(R4, 2);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(T2) == (uint64_t)-4LL);
+        assert(vm.getRegister64(T6) == (uint64_t)-1LL);
+
+        vm.reset();
+        vm.setRegister64(R2, 1000000000000ULL);
+        vm.setRegister64(R4, 7);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(T4) == 1000000000000ULL % 7);
+        assert(vm.getRegister64(T6) == 1000000000000ULL % 7);
+    }
+
+    printf("%s\n", "Test: Logic;");
+    {
+        uint8_t program[] = {
+            OP_ANDQ, R0, R2, R4,
+            OP_ORQ, T0, R2, R4,
+            OP_XORQ, T2, R2, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister64(R2, 0xFF00FF00FF00FF00ULL);
+        vm.setRegister64(R4, 0x0FF00FF00FF00FF0ULL);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(R0) == 0x0F000F000F000F00ULL);
+        assert(vm.getRegister64(T0) == 0xFFF0FFF0FFF0FFF0ULL);
+        assert(vm.getRegister64(T2) == 0xF0F0F0F0F0F0F0F0ULL);
+
+        vm.reset();
+        vm.setRegister64(R2, UINT64_MAX);
+        vm.setRegister64(R4, 0xF0F0F0F0F0F0F0F0ULL);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(T2) == 0x0F0F0F0F0F0F0F0FULL);
+    }
+
+    printf("%s\n", "Test: Shifts;");
+    {
+        uint8_t program[] = {
+            OP_SHLQ, R0, R2, R4,
+            OP_SHRQ, T0, R2, R4,
+            OP_ISHRQ, T2, R2, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister64(R2, 1);
+        vm.setRegister64(R4, 40);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(R0) == 1ULL << 40);
+        assert(vm.getRegister64(T0) == 0);
+
+        vm.reset();
+        vm.setRegister64(R2, 5);
+        vm.setRegister64(R4, 64);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(R0) == 5);
+
+        vm.reset();
+        vm.setRegister64(R2, 0x8000000000000000ULL);
+        vm.setRegister64(R4, 63);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(T0) == 1);
+        assert(vm.getRegister64(T2) == UINT64_MAX);
+
+        vm.reset();
+        vm.setRegister64(R2, (uint64_t)-256LL);
+        vm.setRegister64(R4, 4);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister64(T0) == 0x0FFFFFFFFFFFFFF0ULL);
+        assert(vm.getRegister64(T2) == (uint64_t)-16LL);
+    }
+
+    printf("%s\n", "Test: Signed and unsigned compares;");
+    {
+        uint8_t program[] = {
+            OP_CMPQ, R0, R2, R4,
+            OP_UCMPQ, T0, R2, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister64(R2, (uint64_t)-1LL);
+        vm.setRegister64(R4, 1);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == -1);
+        assert((int32_t)vm.getRegister(T0) == 1);
+
+        vm.reset();
+        vm.setRegister64(R2, 0x100000005ULL);
+        vm.setRegister64(R4, 0x200000005ULL);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == -1);
+        assert((int32_t)vm.getRegister(T0) == -1);
+
+        vm.reset();
+        vm.setRegister64(R2, 0x100000005ULL);
+        vm.setRegister64(R4, 0x100000005ULL);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == 0);
+        assert((int32_t)vm.getRegister(T0) == 0);
+    }
+
+
+    printf("%s\n", "Test: Pairs must stay in the general registers;");
+    {
+        uint8_t program[] = {
+            OP_ADDQ, T9, R0, R2,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_ERR_INVALID_REGISTER);
+    }
+}
+
+void TEST_CASE_OP_QWORD_MEMORY()
+{
+    printf("%s\n", "Test: Constants, loads and stores;");
+    {
+        uint8_t program[] = {
+            OP_LCONSQ, R0, 0xEF, 0xCD, 0xAB, 0x89, 0x67, 0x45, 0x23, 0x01,
+            OP_STORQ, 64, 0, R0,
+            OP_LOADQ, R2, 64, 0,
+            OP_STORQ_D, T0, 8, 0, R2,
+            OP_LOADQ_D, R4, T0, 8, 0,
+            OP_MOVQ, T2, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(T0, 64);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        uint64_t stored = 0;
+        memcpy(&stored, vm.memory(64), 8);
+        assert(stored == 0x0123456789ABCDEFULL);
+        memcpy(&stored, vm.memory(72), 8);
+        assert(stored == 0x0123456789ABCDEFULL);
+        assert(vm.getRegister(R0) == 0x89ABCDEF);
+        assert(vm.getRegister(R1) == 0x01234567);
+        assert(vm.getRegister64(R2) == 0x0123456789ABCDEFULL);
+        assert(vm.getRegister64(R4) == 0x0123456789ABCDEFULL);
+        assert(vm.getRegister64(T2) == 0x0123456789ABCDEFULL);
+    }
+
+    printf("%s\n", "Test: Past the end of memory;");
+    {
+        uint8_t program[] = {
+            OP_LOADQ_D, R0, R2, 0, 0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R2, sizeof(program) + 256 - 4);
+        assert(vm.run() == ExecResult::VM_ERR_INVALID_ADDRESS);
+    }
+}
+
+void TEST_CASE_OP_DOUBLE()
+{
+    printf("%s\n", "Test: Arithmetic;");
+    {
+        uint8_t program[] = {
+            OP_DADD, R0, R2, R4,
+            OP_DSUB, T0, R2, R4,
+            OP_DMUL, T2, R2, R4,
+            OP_DDIV, T4, R2, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister64(R2, doubleBits(1.5));
+        vm.setRegister64(R4, doubleBits(2.25));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsDouble(vm.getRegister64(R0)) == 3.75);
+        assert(bitsDouble(vm.getRegister64(T0)) == -0.75);
+        assert(bitsDouble(vm.getRegister64(T2)) == 3.375);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(1.0));
+        vm.setRegister64(R4, doubleBits(1e-12));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsDouble(vm.getRegister64(T0)) == 1.0 - 1e-12);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(0.1));
+        vm.setRegister64(R4, doubleBits(3.0));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsDouble(vm.getRegister64(T2)) == 0.1 * 3.0);
+        assert(bitsDouble(vm.getRegister64(T4)) == 0.1 / 3.0);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(1.0));
+        vm.setRegister64(R4, doubleBits(0.0));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(bitsDouble(vm.getRegister64(T4)) == INFINITY);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(NAN));
+        vm.setRegister64(R4, doubleBits(1.0));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(std::isnan(bitsDouble(vm.getRegister64(R0))));
+    }
+
+    printf("%s\n", "Test: Compare;");
+    {
+        uint8_t program[] = {
+            OP_DCMP, R0, R2, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+
+        vm.setRegister64(R2, doubleBits(-1.0));
+        vm.setRegister64(R4, doubleBits(2.0));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == -1);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(2.0));
+        vm.setRegister64(R4, doubleBits(2.0));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == 0);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(0.0));
+        vm.setRegister64(R4, doubleBits(-0.0));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == 0);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(INFINITY));
+        vm.setRegister64(R4, doubleBits(2.0));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == 1);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(NAN));
+        vm.setRegister64(R4, doubleBits(2.0));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == 2);
+
+        vm.reset();
+        vm.setRegister64(R2, doubleBits(2.0));
+        vm.setRegister64(R4, doubleBits(NAN));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)vm.getRegister(R0) == 2);
+    }
+}
+
+void TEST_CASE_OP_WIDE_CONVERSIONS()
+{
+    uint8_t program[] = {
+        OP_NOP, R0, R2,
+        OP_HALT};
+    float f = 0;
+
+    printf("%s\n", "Test: Integer widening;");
+    {
+        program[0] = OP_SEXQ;
+        VM sex(program, sizeof(program));
+        sex.setRegister(R2, (uint32_t)-5);
+        assert(sex.run() == ExecResult::VM_FINISHED);
+        assert((int64_t)sex.getRegister64(R0) == -5);
+
+        program[0] = OP_ZEXQ;
+        VM zex(program, sizeof(program));
+        zex.setRegister(R1, 7);
+        zex.setRegister(R2, UINT32_MAX);
+        assert(zex.run() == ExecResult::VM_FINISHED);
+        assert(zex.getRegister64(R0) == 0xFFFFFFFFULL);
+    }
+
+    printf("%s\n", "Test: To and from doubles;");
+    {
+        program[0] = OP_I2D;
+        VM i2d(program, sizeof(program));
+        i2d.setRegister(R2, (uint32_t)-7);
+        assert(i2d.run() == ExecResult::VM_FINISHED);
+        assert(bitsDouble(i2d.getRegister64(R0)) == -7.0);
+
+        program[0] = OP_D2I;
+        VM d2i(program, sizeof(program));
+        d2i.setRegister64(R2, doubleBits(-7.9));
+        assert(d2i.run() == ExecResult::VM_FINISHED);
+        assert((int32_t)d2i.getRegister(R0) == -7);
+
+        program[0] = OP_F2D;
+        VM f2d(program, sizeof(program));
+        f = 1.5f;
+        f2d.setRegister(R2, *(uint32_t *)&f);
+        assert(f2d.run() == ExecResult::VM_FINISHED);
+        assert(bitsDouble(f2d.getRegister64(R0)) == 1.5);
+
+        program[0] = OP_D2F;
+        VM d2f(program, sizeof(program));
+        d2f.setRegister64(R2, doubleBits(0.1));
+        assert(d2f.run() == ExecResult::VM_FINISHED);
+        const uint32_t fbits = d2f.getRegister(R0);
+        memcpy(&f, &fbits, sizeof(f));
+        assert(f == 0.1f);
+
+        program[0] = OP_Q2D;
+        VM q2d(program, sizeof(program));
+        q2d.setRegister64(R2, (uint64_t)-(1LL << 40));
+        assert(q2d.run() == ExecResult::VM_FINISHED);
+        assert(bitsDouble(q2d.getRegister64(R0)) == -1099511627776.0);
+
+        program[0] = OP_D2Q;
+        VM d2q(program, sizeof(program));
+        d2q.setRegister64(R2, doubleBits(1e15 + 0.5));
+        assert(d2q.run() == ExecResult::VM_FINISHED);
+        assert(d2q.getRegister64(R0) == 1000000000000000ULL);
+    }
+
+    printf("%s\n", "Test: Between floats and 64-bit integers;");
+    {
+        program[0] = OP_Q2F;
+        VM q2f(program, sizeof(program));
+        q2f.setRegister64(R2, 1ULL << 40);
+        assert(q2f.run() == ExecResult::VM_FINISHED);
+        const uint32_t fbits = q2f.getRegister(R0);
+        memcpy(&f, &fbits, sizeof(f));
+        assert(f == 1099511627776.0f);
+
+        program[0] = OP_F2Q;
+        VM f2q(program, sizeof(program));
+        f = -3.75f;
+        f2q.setRegister(R2, *(uint32_t *)&f);
+        assert(f2q.run() == ExecResult::VM_FINISHED);
+        assert((int64_t)f2q.getRegister64(R0) == -3);
+    }
+}
+
+void TEST_CASE_OP_PRINTQ()
+{
+    printf("%s\n", "Test: 64-bit integers and doubles;");
+    {
+        uint8_t program[] = {
+            OP_PRINTQ, R0, 1,
+            OP_PRINTD, R2, 0,
+            OP_HALT};
+        char *output = nullptr;
+        size_t outputLen = 0;
+        FILE *out = open_memstream(&output, &outputLen);
+
+        VM vm(program, sizeof(program));
+        vm.setOutput(out);
+        vm.setRegister64(R0, (uint64_t)-1234567890123LL);
+        vm.setRegister64(R2, doubleBits(2.5));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        fclose(out);
+        assert(strcmp(output, "-1234567890123\n2.500000") == 0);
+        assert(vm.stats().get(STAT_BYTES_PRINTED) == strlen(output));
+        free(output);
+    }
+}
+
+void TEST_CASE_OP_STOR()
+{
+    uint8_t program[] = {
+        OP_STOR, 5, 0, R0,
+        OP_HALT,
+        0, 0, 0, 0, 0xFF};
+    VM vm(program, sizeof(program));
+    uint32_t actual = 0;
+
+    printf("%s\n", "Test: Store value;");
+    {
+        vm.setRegister(R0, _U32_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[5], 4);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == _U32_GARBAGE);
+        assert(memory[9] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Store zero;");
+    {
+        vm.reset();
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[5], 4);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == 0);
+        assert(memory[9] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_STOR_P()
+{
+    uint8_t program[] = {
+        OP_STOR_P, R1, R0,
+        OP_HALT,
+        0, 0, 0, 0, 0xFF};
+    VM vm(program, sizeof(program));
+    uint32_t actual = 0;
+
+    printf("%s\n", "Test: Store value;");
+    {
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, _U32_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[4], 4);
+
+        assert(memory[3] == OP_HALT);
+        assert(actual == _U32_GARBAGE);
+        assert(memory[8] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Store zero;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[4], 4);
+
+        assert(memory[3] == OP_HALT);
+        assert(actual == 0);
+        assert(memory[8] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_STORW()
+{
+    uint8_t program[] = {
+        OP_STORW, 5, 0, R0,
+        OP_HALT,
+        0, 0, 0xFF};
+    VM vm(program, sizeof(program));
+    uint16_t actual = 0;
+
+    printf("%s\n", "Test: Store value;");
+    {
+        vm.setRegister(R0, _U16_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[5], 2);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == _U16_GARBAGE);
+        assert(memory[7] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Store zero;");
+    {
+        vm.reset();
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[5], 2);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == 0);
+        assert(memory[7] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_STORW_P()
+{
+    uint8_t program[] = {
+        OP_STORW_P, R1, R0,
+        OP_HALT,
+        0, 0, 0xFF};
+    VM vm(program, sizeof(program));
+    uint16_t actual = 0;
+
+    printf("%s\n", "Test: Store value;");
+    {
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, _U16_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[4], 2);
+
+        assert(memory[3] == OP_HALT);
+        assert(actual == _U16_GARBAGE);
+        assert(memory[6] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Store zero;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[4], 2);
+
+        assert(memory[3] == OP_HALT);
+        assert(actual == 0);
+        assert(memory[6] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_STORB()
+{
+    uint8_t program[] = {
+        OP_STORB, 5, 0, R0,
+        OP_HALT,
+        0, 0xFF};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Store value;");
+    {
+        vm.setRegister(R0, _U8_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+
+        assert(memory[4] == OP_HALT);
+        assert(memory[5] == _U8_GARBAGE);
+        assert(memory[6] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Store zero;");
+    {
+        vm.reset();
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+
+        assert(memory[4] == OP_HALT);
+        assert(memory[5] == 0);
+        assert(memory[6] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_STORB_P()
+{
+    uint8_t program[] = {
+        OP_STORB_P, R1, R0,
+        OP_HALT,
+        0, 0xFF};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Store value;");
+    {
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, _U8_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+
+        assert(memory[3] == OP_HALT);
+        assert(memory[4] == _U8_GARBAGE);
+        assert(memory[5] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Store zero;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+
+        assert(memory[3] == OP_HALT);
+        assert(memory[4] == 0);
+        assert(memory[5] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_LOAD()
+{
+    uint8_t program[] = {
+        OP_LOAD, R0, 5, 0,
+        OP_HALT,
+        _NTH_BYTE(_U32_GARBAGE, 0), _NTH_BYTE(_U32_GARBAGE, 1),
+        _NTH_BYTE(_U32_GARBAGE, 2), _NTH_BYTE(_U32_GARBAGE, 3),
+        0xFF};
+    VM vm(program, sizeof(program));
+    uint32_t actual = 0;
+
+    printf("%s\n", "Test: Load value;");
+    {
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[5], 4);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == _U32_GARBAGE);
+        assert(vm.getRegister(R0) == _U32_GARBAGE);
+        assert(memory[9] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Load zero;");
+    {
+        vm.reset();
+        uint8_t *memory = vm.memory();
+
+        memset(&memory[5], 0, 4);
+        vm.setRegister(R0, _U32_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        memcpy(&actual, &memory[5], 4);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == 0);
+        assert(vm.getRegister(R0) == 0);
+        assert(memory[9] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_LOAD_P()
+{
+    uint8_t program[] = {
+        OP_LOAD_P, R0, R1,
+        OP_HALT,
+        _NTH_BYTE(_U32_GARBAGE, 0), _NTH_BYTE(_U32_GARBAGE, 1),
+        _NTH_BYTE(_U32_GARBAGE, 2), _NTH_BYTE(_U32_GARBAGE, 3),
+        0xFF};
+    VM vm(program, sizeof(program));
+    uint32_t actual = 0;
+
+    printf("%s\n", "Test: Load value;");
+    {
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[4], 4);
+
+        assert(memory[3] == OP_HALT);
+        assert(actual == _U32_GARBAGE);
+        assert(vm.getRegister(R0) == _U32_GARBAGE);
+        assert(memory[8] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Load zero;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, _U32_GARBAGE);
+        
+        uint8_t *memory = vm.memory();
+        memset(&memory[4], 0, 4);
+
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        memcpy(&actual, &memory[4], 4);
+
+        assert(memory[3] == OP_HALT);
+        assert(actual == 0);
+        assert(vm.getRegister(R0) == 0);
+        assert(memory[8] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_LOADW()
+{
+    uint8_t program[] = {
+        OP_LOADW, R0, 5, 0,
+        OP_HALT,
+        _NTH_BYTE(_U16_GARBAGE, 0), _NTH_BYTE(_U16_GARBAGE, 1),
+        0xFF};
+    VM vm(program, sizeof(program));
+    uint16_t actual = 0;
+
+    printf("%s\n", "Test: Load value;");
+    {
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[5], 2);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == _U16_GARBAGE);
+        assert(vm.getRegister(R0) == _U16_GARBAGE);
+        assert(memory[7] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Load zero;");
+    {
+        vm.reset();
+        uint8_t *memory = vm.memory();
+
+        memset(&memory[5], 0, 2);
+        vm.setRegister(R0, _U32_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        memcpy(&actual, &memory[5], 2);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == 0);
+        assert(vm.getRegister(R0) == 0);
+        assert(memory[7] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_LOADW_P()
+{
+    uint8_t program[] = {
+        OP_LOADW_P, R0, R1,
+        OP_HALT,
+        _NTH_BYTE(_U16_GARBAGE, 0), _NTH_BYTE(_U16_GARBAGE, 1),
+        0xFF};
+    VM vm(program, sizeof(program));
+    uint16_t actual = 0;
+
+    printf("%s\n", "Test: Load value;");
+    {
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[4], 2);
+
+        assert(memory[3] == OP_HALT);
+        assert(actual == _U16_GARBAGE);
+        assert(vm.getRegister(R0) == _U16_GARBAGE);
+        assert(memory[6] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Load zero;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, _U32_GARBAGE);
+        
+        uint8_t *memory = vm.memory();
+        memset(&memory[4], 0, 2);
+
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        memcpy(&actual, &memory[4], 2);
+
+        assert(memory[3] == OP_HALT);
+        assert(actual == 0);
+        assert(vm.getRegister(R0) == 0);
+        assert(memory[6] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_LOADB()
+{
+    uint8_t program[] = {
+        OP_LOADB, R0, 5, 0,
+        OP_HALT,
+        _U8_GARBAGE,
+        0xFF};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Load value;");
+    {
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+
+        assert(memory[4] == OP_HALT);
+        assert(memory[5] == _U8_GARBAGE);
+        assert(vm.getRegister(R0) == _U8_GARBAGE);
+        assert(memory[6] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Load zero;");
+    {
+        vm.reset();
+        uint8_t *memory = vm.memory();
+
+        vm.setRegister(R0, _U32_GARBAGE);
+        memory[5] = 0;
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        assert(memory[4] == OP_HALT);
+        assert(memory[5] == 0);
+        assert(vm.getRegister(R0) == 0);
+        assert(memory[6] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_LOADB_P()
+{
+    uint8_t program[] = {
+        OP_LOADB_P, R0, R1,
+        OP_HALT,
+        _U8_GARBAGE,
+        0xFF};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Load value;");
+    {
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+
+        assert(memory[3] == OP_HALT);
+        assert(memory[4] == _U8_GARBAGE);
+        assert(vm.getRegister(R0) == _U8_GARBAGE);
+        assert(memory[5] == 0xFF);
+    }
+
+    printf("%s\n", "Test: Load zero;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 4);
+        vm.setRegister(R0, _U32_GARBAGE);
+        
+        uint8_t *memory = vm.memory();
+        memory[4] = 0;
+
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        assert(memory[3] == OP_HALT);
+        assert(memory[4] == 0);
+        assert(vm.getRegister(R0) == 0);
+        assert(memory[5] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_MEMCPY()
+{
+    uint8_t program[] = {
+        OP_MEMCPY, 8, 0, 12, 0, 4, 0, // copy 4 bytes from 0xC to 0x8
+        OP_HALT,
+        0, 0, 0, 0,
+        _NTH_BYTE(_U32_GARBAGE, 0), _NTH_BYTE(_U32_GARBAGE, 1),
+        _NTH_BYTE(_U32_GARBAGE, 2), _NTH_BYTE(_U32_GARBAGE, 3),
+        0xFF};
+    VM vm(program, sizeof(program));
+    uint32_t actual = 0;
+    uint32_t source = 0;
+
+    printf("%s\n", "Test: Copy 4 bytes;");
+    {
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[8], 4);
+        memcpy(&source, &memory[12], 4);
+
+        assert(memory[7] == OP_HALT);
+        assert(actual == _U32_GARBAGE);
+        assert(source == _U32_GARBAGE);
+        assert(memory[16] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_MEMCPY_P()
+{
+    uint8_t program[] = {
+        OP_MEMCPY_P, R0, R1, R2,
+        OP_HALT,
+        0, 0, 0, 0,
+        _NTH_BYTE(_U32_GARBAGE, 0), _NTH_BYTE(_U32_GARBAGE, 1),
+        _NTH_BYTE(_U32_GARBAGE, 2), _NTH_BYTE(_U32_GARBAGE, 3),
+        0xFF};
+    VM vm(program, sizeof(program));
+    uint32_t actual = 0;
+    uint32_t source = 0;
+
+    printf("%s\n", "Test: Copy 4 bytes;");
+    {
+        vm.setRegister(R0, 5);
+        vm.setRegister(R1, 9);
+        vm.setRegister(R2, 4);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        uint8_t *memory = vm.memory();
+        memcpy(&actual, &memory[5], 4);
+        memcpy(&source, &memory[9], 4);
+
+        assert(memory[4] == OP_HALT);
+        assert(actual == _U32_GARBAGE);
+        assert(source == _U32_GARBAGE);
+        assert(memory[13] == 0xFF);
+    }
+}
+
+void TEST_CASE_OP_DISPLACEMENT()
+{
+    printf("%s\n", "Test: Loads and stores around a base;");
+    {
+        uint8_t program[] = {
+            OP_LOAD_D, R0, R1, 0xFC, 0xFF,
+            OP_LOADW_D, R2, R1, 2, 0,
+            OP_LOADB_D, R3, R1, 5, 0,
+            OP_STOR_D, R1, 16, 0, R0,
+            OP_STORW_D, R1, 20, 0, R2,
+            OP_STORB_D, R1, 0xFE, 0xFF, R3,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        uint8_t *memory = vm.memory();
+        const uint32_t garbage = _U32_GARBAGE;
+        const uint16_t word = _U16_GARBAGE;
+        memcpy(&memory[36], &garbage, 4);
+        memcpy(&memory[42], &word, 2);
+        memory[45] = 0xA5;
+        vm.setRegister(R1, 40);
+        vm.setRegister(R2, _U32_GARBAGE);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        uint32_t actual = 0;
+        uint16_t actualWord = 0;
+        assert(vm.getRegister(R0) == _U32_GARBAGE);
+        assert(vm.getRegister(R2) == _U16_GARBAGE);
+        assert(vm.getRegister(R3) == 0xA5);
+        memcpy(&actual, &memory[56], 4);
+        memcpy(&actualWord, &memory[60], 2);
+        assert(actual == _U32_GARBAGE);
+        assert(actualWord == _U16_GARBAGE);
+        assert(memory[62] == 0);
+        assert(memory[38] == 0xA5);
+    }
+
+    printf("%s\n", "Test: Past the end of memory;");
+    {
+        uint8_t program[] = {
+            OP_LOAD_D, R0, R1, 1, 0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R1, sizeof(program) + 256 - 4);
+        assert(vm.run() == ExecResult::VM_ERR_INVALID_ADDRESS);
+    }
+
+    printf("%s\n", "Test: Copy between displaced bases;");
+    {
+        uint8_t program[] = {
+            OP_MEMCPY_D, R0, 8, 0, R1, 0xF8, 0xFF, R2,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        uint8_t *memory = vm.memory();
+        const uint32_t garbage = _U32_GARBAGE;
+        memcpy(&memory[64], &garbage, 4);
+        vm.setRegister(R0, 40);
+        vm.setRegister(R1, 72);
+        vm.setRegister(R2, 4);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        uint32_t actual = 0;
+        memcpy(&actual, &memory[48], 4);
+        assert(actual == _U32_GARBAGE);
+        assert(memory[52] == 0);
+    }
+
+    printf("%s\n", "Test: Disassembly;");
+    {
+        uint8_t program[] = {
+            OP_LOAD_D, R0, R1, 0xFC, 0xFF,
+            OP_STORB_D, R1, 16, 0, R0};
+        char text[64];
+        assert(disassemble(program, sizeof(program), 0, text, sizeof(text)) == 5);
+        assert(strcmp(text, "load_d r0, r1, -4") == 0);
+        assert(disassemble(program, sizeof(program), 5, text, sizeof(text)) == 5);
+        assert(strcmp(text, "storb_d r1, 16, r0") == 0);
+    }
+}
+
+void TEST_CASE_OP_INDEXED()
+{
+    printf("%s\n", "Test: Loads and stores of array elements;");
+    {
+        uint8_t program[] = {
+            OP_LOAD_X, R0, R1, R2, 4,
+            OP_LOADW_X, R3, R1, R2, 2,
+            OP_LOADB_X, R4, R1, R2, 1,
+            OP_STOR_X, R1, R2, 12, R0,
+            OP_STORW_X, R1, R5, 2, R3,
+            OP_STORB_X, R1, R5, 1, R4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        uint8_t *memory = vm.memory();
+        const uint32_t garbage = _U32_GARBAGE;
+        const uint16_t word = _U16_GARBAGE;
+        memcpy(&memory[52], &garbage, 4);
+        memcpy(&memory[46], &word, 2);
+        memory[43] = 0xA5;
+        vm.setRegister(R1, 40);
+        vm.setRegister(R2, 3);
+        vm.setRegister(R5, 20);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        uint32_t actual = 0;
+        uint16_t actualWord = 0;
+        assert(vm.getRegister(R0) == _U32_GARBAGE);
+        assert(vm.getRegister(R3) == _U16_GARBAGE);
+        assert(vm.getRegister(R4) == 0xA5);
+        memcpy(&actual, &memory[76], 4);
+        memcpy(&actualWord, &memory[80], 2);
+        assert(actual == _U32_GARBAGE);
+        assert(actualWord == _U16_GARBAGE);
+        assert(memory[60] == 0xA5);
+    }
+
+    printf("%s\n", "Test: Negative indexes wrap around;");
+    {
+        uint8_t program[] = {
+            OP_LOAD_X, R0, R1, R2, 4,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        uint8_t *memory = vm.memory();
+        const uint32_t garbage = _U32_GARBAGE;
+        memcpy(&memory[36], &garbage, 4);
+        vm.setRegister(R1, 40);
+        vm.setRegister(R2, UINT32_MAX);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == _U32_GARBAGE);
+    }
+
+    printf("%s\n", "Test: Copy an element between arrays;");
+    {
+        uint8_t program[] = {
+            OP_MEMCPY_X, R0, R1, R2, 8, R3,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        uint8_t *memory = vm.memory();
+        for (uint8_t i = 0; i < 24; i++)
+            memory[40 + i] = i + 1;
+        vm.setRegister(R0, 100);
+        vm.setRegister(R1, 40);
+        vm.setRegister(R2, 2);
+        vm.setRegister(R3, 8);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(memory[115] == 0);
+        for (uint8_t i = 0; i < 8; i++)
+            assert(memory[116 + i] == 17 + i);
+        assert(memory[124] == 0);
+    }
+}
+
+void TEST_CASE_OP_POST_INCREMENT()
+{
+    printf("%s\n", "Test: Streaming loop;");
+    {
+        uint8_t program[] = {
+            OP_LOADB_PI, R2, R1,
+            OP_ADD, R0, R0, R2,
+            OP_STORW_PI, R3, R2,
+            OP_DJNZ_S, R4, (uint8_t)-10,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        uint8_t *memory = vm.memory();
+        for (uint8_t i = 0; i < 5; i++)
+            memory[40 + i] = i + 1;
+        vm.setRegister(R1, 40);
+        vm.setRegister(R3, 60);
+        vm.setRegister(R4, 5);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 15);
+        assert(vm.getRegister(R1) == 45);
+        assert(vm.getRegister(R3) == 70);
+        for (uint8_t i = 0; i < 5; i++)
+            assert(memory[60 + 2 * i] == i + 1 && memory[61 + 2 * i] == 0);
+    }
+
+    printf("%s\n", "Test: Every width advances by its size;");
+    {
+        uint8_t program[] = {
+            OP_LOAD_PI, R0, R1,
+            OP_LOADW_PI, R2, R1,
+            OP_STOR_PI, R3, R0,
+            OP_STORB_PI, R3, R2,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        uint8_t *memory = vm.memory();
+        const uint32_t garbage = _U32_GARBAGE;
+        const uint16_t word = _U16_GARBAGE;
+        memcpy(&memory[40], &garbage, 4);
+        memcpy(&memory[44], &word, 2);
+        vm.setRegister(R1, 40);
+        vm.setRegister(R3, 80);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        uint32_t actual = 0;
+        memcpy(&actual, &memory[80], 4);
+        assert(vm.getRegister(R0) == _U32_GARBAGE);
+        assert(vm.getRegister(R2) == _U16_GARBAGE);
+        assert(vm.getRegister(R1) == 46);
+        assert(vm.getRegister(R3) == 85);
+        assert(actual == _U32_GARBAGE);
+        assert(memory[84] == (uint8_t)_U16_GARBAGE);
+    }
+
+    printf("%s\n", "Test: A load into the pointer wins;");
+    {
+        uint8_t program[] = {
+            OP_LOAD_PI, R1, R1,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        const uint32_t garbage = _U32_GARBAGE;
+        memcpy(vm.memory(40), &garbage, 4);
+        vm.setRegister(R1, 40);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R1) == _U32_GARBAGE);
+    }
+
+    printf("%s\n", "Test: Copy in chunks;");
+    {
+        uint8_t program[] = {
+            OP_MEMCPY_PI, R0, R1, R2,
+            OP_MEMCPY_PI, R0, R1, R2,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        uint8_t *memory = vm.memory();
+        for (uint8_t i = 0; i < 6; i++)
+            memory[40 + i] = i + 1;
+        vm.setRegister(R0, 100);
+        vm.setRegister(R1, 40);
+        vm.setRegister(R2, 3);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 106);
+        assert(vm.getRegister(R1) == 46);
+        for (uint8_t i = 0; i < 6; i++)
+            assert(memory[100 + i] == i + 1);
+    }
+}
+
+void TEST_CASE_OP_LCONS()
+{
+    printf("%s\n", "Test: Load zero;");
+    {
+        uint8_t program[] = {
+            OP_LCONS, R0, 0, 0, 0, 0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+    }
+
+    printf("%s\n", "Test: Load max;");
+    {
+        uint8_t program[] = {
+            OP_LCONS, R0, 0xFF, 0xFF, 0xFF, 0xFF,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == UINT32_MAX);
+    }
+}
+
+void TEST_CASE_OP_LCONSW()
+{
+    printf("%s\n", "Test: Load zero;");
+    {
+        uint8_t program[] = {
+            OP_LCONSW, R0, 0, 0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+    }
+
+    printf("%s\n", "Test: Load max;");
+    {
+        uint8_t program[] = {
+            OP_LCONSW, R0, 0xFF, 0xFF,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == UINT16_MAX);
+    }
+}
+
+void TEST_CASE_OP_LCONSB()
+{
+    printf("%s\n", "Test: Load zero;");
+    {
+        uint8_t program[] = {
+            OP_LCONSB, R0, 0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+    }
+
+    printf("%s\n", "Test: Load max;");
+    {
+        uint8_t program[] = {
+            OP_LCONSB, R0, 0xFF,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == UINT8_MAX);
+    }
+}
+
+void TEST_CASE_OP_MOV()
+{
+    uint8_t program[] = {
+        OP_MOV, R0, R1,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Load zero;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 0);
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+    }
+
+    printf("%s\n", "Test: Load 1122334455U;");
+    {
+        vm.reset();
+        vm.setRegister(R1, 1122334455U);
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1122334455U);
+    }
+
+    printf("%s\n", "Test: Load max;");
+    {
+        vm.reset();
+        vm.setRegister(R1, UINT32_MAX);
+        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == UINT32_MAX);
+    }
+}
+
+void TEST_CASE_OP_PUSH()
+{
+    uint8_t program[] = {
+        OP_PUSH, R0,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Zero;");
+    {
+        vm.setRegister(R0, 0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 4);
+        assert(vm.stackPop() == 0);
+    }
+
+    printf("%s\n", "Test: 1123497651;");
+    {
+        vm.reset();
+        vm.setRegister(R0, 1123497651);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 4);
+        assert(vm.stackPop() == 1123497651);
+    }
+
+    printf("%s\n", "Test: UINT32_MAX;");
+    {
+        vm.reset();
+        vm.setRegister(R0, UINT32_MAX);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 4);
+        assert(vm.stackPop() == UINT32_MAX);
+    }
+}
+
+void TEST_CASE_OP_POP()
+{
+    uint8_t program[] = {
+        OP_POP, R0,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Zero;");
+    {
+        vm.stackPush(0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 0);
+        assert(vm.getRegister(R0) == 0);
+    }
+
+    printf("%s\n", "Test: 1123497651;");
+    {
+        vm.reset();
+        vm.stackPush(1123497651);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 0);
+        assert(vm.getRegister(R0) == 1123497651);
+    }
+
+    printf("%s\n", "Test: UINT32_MAX;");
+    {
+        vm.reset();
+        vm.stackPush(UINT32_MAX);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 0);
+        assert(vm.getRegister(R0) == UINT32_MAX);
+    }
+}
+
+void TEST_CASE_OP_POP2()
+{
+    uint8_t program[] = {
+        OP_POP2, R0, R1,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Zero;");
+    {
+        vm.stackPush(0);
+        vm.stackPush(0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 0);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R1) == 0);
+    }
+
+    printf("%s\n", "Test: 1123497651 / 123;");
+    {
+        vm.reset();
+        vm.stackPush(1123497651);
+        vm.stackPush(123);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 0);
+        assert(vm.getRegister(R0) == 123);
+        assert(vm.getRegister(R1) == 1123497651);
+    }
+
+    printf("%s\n", "Test: UINT32_MAX;");
+    {
+        vm.reset();
+        vm.stackPush(UINT32_MAX);
+        vm.stackPush(UINT32_MAX);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 0);
+        assert(vm.getRegister(R0) == UINT32_MAX);
+        assert(vm.getRegister(R1) == UINT32_MAX);
+    }
+}
+
+void TEST_CASE_OP_DUP()
+{
+    uint8_t program[] = {
+        OP_DUP,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+
+    printf("%s\n", "Test: Zero;");
+    {
+        vm.stackPush(0);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 8);
+        assert(vm.stackPop() == 0);
+        assert(vm.stackPop() == 0);
+    }
+
+    printf("%s\n", "Test: 1123497651 ;");
+    {
+        vm.reset();
+        vm.stackPush(1123497651);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 8);
+        assert(vm.stackPop() == 1123497651);
+        assert(vm.stackPop() == 1123497651);
+    }
+
+    printf("%s\n", "Test: UINT32_MAX;");
+    {
+        vm.reset();
+        vm.stackPush(UINT32_MAX);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.stackCount() == 8);
+        assert(vm.stackPop() == UINT32_MAX);
+        assert(vm.stackPop() == UINT32_MAX);
+    }
+}
+
+void TEST_CASE_OP_CALLF()
+{
+    printf("%s\n", "Test: Recursion without saving RA;");
+    {
+        uint8_t program[] = {
+            OP_LCONSB, R0, 5,
+            OP_CALLF, 7, 0,
+            OP_HALT,
+            OP_JZ, R0, 20, 0, // 7
+            OP_DEC, R0,
+            OP_ADDIB, R1, R1, 3,
+            OP_CALLF, 7, 0,
+            OP_RETF}; // 20
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R1) == 15);
+        assert(vm.getRegister(SP) == sizeof(program) + 256);
+        assert(vm.getRegister(BP) == sizeof(program) + 256);
+        assert(vm.stackCount() == 0);
+    }
+
+    printf("%s\n", "Test: Locals between ENTER and LEAVE;");
+    {
+        uint8_t program[] = {
+            OP_CALLF, 4, 0,
+            OP_HALT,
+            OP_ENTER, 16, 0, // 4
+            OP_MOV, R2, SP,
+            OP_MOV, R3, BP,
+            OP_PUSH, R0,
+            OP_LEAVE,
+            OP_RETF};
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R3) == sizeof(program) + 256 - 8);
+        assert(vm.getRegister(R3) - vm.getRegister(R2) == 16);
+        assert(vm.getRegister(SP) == sizeof(program) + 256);
+        assert(vm.getRegister(BP) == sizeof(program) + 256);
+    }
+
+    printf("%s\n", "Test: Frames that do not fit;");
+    {
+        uint8_t program[] = {
+            OP_ENTER, 56, 0,
+            OP_CALLF, 7, 0,
+            OP_HALT,
+            OP_RETF}; // 7
+        VM fits(program, sizeof(program), 64);
+        assert(fits.run() == ExecResult::VM_FINISHED);
+
+        program[1] = 60;
+        VM noCall(program, sizeof(program), 64);
+        assert(noCall.run() == ExecResult::VM_ERR_STACK_OVERFLOW);
+        assert(noCall.getRegister(IP) == 3);
+
+        program[1] = 65;
+        VM noLocals(program, sizeof(program), 64);
+        assert(noLocals.run() == ExecResult::VM_ERR_STACK_OVERFLOW);
+        assert(noLocals.getRegister(SP) == sizeof(program) + 64);
+    }
+
+    printf("%s\n", "Test: RETF on an empty stack;");
+    {
+        uint8_t program[] = {
+            OP_RETF};
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_ERR_STACK_UNDERFLOW);
+    }
+
+    printf("%s\n", "Test: Tail calls run in constant stack;");
+    {
+        uint8_t program[] = {
+            OP_LCONSW, R0, 0xE8, 0x03,
+            OP_CALLF, 11, 0,
+            OP_INC, R5,
+            OP_HALT,
+            OP_NOP,
+            OP_ENTER, 8, 0, // 11
+            OP_JZ, R0, 25, 0,
+            OP_DEC, R0,
+            OP_INC, R1,
+            OP_TAILCALL, 11, 0,
+            OP_LEAVE, // 25
+            OP_RETF};
+        VM vm(program, sizeof(program), 64);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R1) == 1000);
+        assert(vm.getRegister(R5) == 1);
+        assert(vm.getRegister(SP) == sizeof(program) + 64);
+        assert(vm.getRegister(BP) == sizeof(program) + 64);
+    }
+
+    printf("%s\n", "Test: Disassembly;");
+    {
+        uint8_t program[] = {
+            OP_CALLF, 7, 0,
+            OP_ENTER, 16, 0,
+            OP_TAILCALL, 0, 0,
+            OP_RETF};
+        char text[64];
+        assert(disassemble(program, sizeof(program), 0, text, sizeof(text)) == 3);
+        assert(strcmp(text, "callf 0x0007") == 0);
+        assert(disassemble(program, sizeof(program), 3, text, sizeof(text)) == 3);
+        assert(strcmp(text, "enter 16") == 0);
+        assert(disassemble(program, sizeof(program), 6, text, sizeof(text)) == 3);
+        assert(strcmp(text, "tailcall 0x0000") == 0);
+    }
+}
+
+uint8_t intCode;
+bool intContinue;
+
+bool handleInterrupt(uint8_t code)
+{
+    intCode = code;
+    return intContinue;
+}
+
+void TEST_CASE_OP_INT()
+{
+    printf("%s\n", "Test: Code is correct;");
+    {
+        uint8_t program[] = {
+            OP_INT, 3,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.onInterrupt(handleInterrupt);
+        intContinue = true;
+        intCode = 0;
+
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(intCode == 3);
+
+        vm.reset();
+        uint8_t *memory = vm.memory();
+        intCode = 0;
+        memory[1] = 253;
+
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(intCode == 253);
+    }
+
+    printf("%s\n", "Test: Can stop exec;");
+    {
+        uint8_t program[] = {
+            OP_INT, 3,
+            OP_LCONSB, R0, 123,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.onInterrupt(handleInterrupt);
+        intContinue = true;
+        intCode = 0;
+
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(intCode == 3);
+        assert(vm.getRegister(R0) == 123);
+        assert(vm.getRegister(IP) == 5);
+
+        intContinue = false;
+        intCode = 0;
+        vm.reset();
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(intCode == 3);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(IP) == 1);
+    }
+
+    printf("%s\n", "Test: Unhandled interrupt causes error;");
+    {
+        uint8_t program[] = {
+            OP_INT, 3,
+            OP_LCONSB, R0, 123,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        assert(vm.run() == ExecResult::VM_ERR_UNHANDLED_INTERRUPT);
+        assert(vm.getRegister(IP) == 1);
+    }
+}
+
+InterruptResult handleAsyncRead(VM *vm, uint8_t code, uint32_t *token)
+{
+    if (code == 0)
+        return INT_FINISH;
+    // the descriptor to wait on is passed in R1
+    *token = vm->getRegister(R1);
+    return INT_PENDING;
+}
+
+void completeAsyncRead(VM *vm, uint32_t token)
+{
+    uint32_t value = 0;
+    if (read((int)token, &value, sizeof(value)) == sizeof(value))
+        vm->setRegister(R0, value);
+}
+
+uint32_t asyncDone = 0;
+void finishAsyncRead(VM *vm, ExecResult result)
+{
+    assert(result == ExecResult::VM_FINISHED);
+    __sync_fetch_and_add(&asyncDone, 1);
+}
+
+uint32_t asyncFailed = 0;
+void finishOrFailAsyncRead(VM *vm, ExecResult result)
+{
+    assert(result == ExecResult::VM_FINISHED || result == ExecResult::VM_ERR_WAIT_FAILED);
+    __sync_fetch_and_add(result == ExecResult::VM_FINISHED ? &asyncDone : &asyncFailed, 1);
+}
+
+// a slow disk: every completion takes 50ms
+void completeSlowRead(VM *vm, uint32_t token)
+{
+    usleep(50000);
+    completeAsyncRead(vm, token);
+}
+
+void TEST_CASE_OP_INT_ASYNC()
+{
+    printf("%s\n", "Test: Pending interrupt suspends and resumes;");
+    {
+        uint8_t program[] = {
+            OP_INT, 1,
+            OP_INC, R0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.onInterruptAsync(handleAsyncRead);
+        vm.setRegister(R1, 42);
+        assert(vm.run() == ExecResult::VM_WAITING);
+        assert(vm.waiting());
+        assert(vm.pendingToken() == 42);
+        assert(vm.getRegister(IP) == 2);
+        assert(vm.run() == ExecResult::VM_WAITING);
+        assert(!vm.resume(41));
+        vm.setRegister(R0, 122);
+        assert(vm.resume(42));
+        assert(!vm.waiting());
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 123);
+    }
+
+    printf("%s\n", "Test: Finishing interrupt;");
+    {
+        uint8_t program[] = {
+            OP_INT, 0,
+            OP_INC, R0,
+            OP_HALT};
+        VM vm(program, sizeof(program));
+        vm.onInterruptAsync(handleAsyncRead);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(IP) == 1);
+    }
+
+    printf("%s\n", "Test: Scheduler resumes VMs when their descriptors are readable;");
+    {
+        uint8_t program[] = {
+            OP_INT, 1,
+            OP_INC, R0,
+            OP_HALT};
+        const int count = 8;
+        int fds[count][2];
+        VM *vms[count];
+        VMScheduler scheduler(completeAsyncRead, finishAsyncRead, 16);
+
+        asyncDone = 0;
+        for (int i = 0; i < count; i++)
+        {
+            assert(pipe(fds[i]) == 0);
+            vms[i] = new VM(program, sizeof(program));
+            vms[i]->onInterruptAsync(handleAsyncRead);
+            vms[i]->setRegister(R1, fds[i][0]);
+            scheduler.submit(vms[i]);
+        }
+
+        std::thread writer([&fds] {
+            usleep(10000);
+            for (uint32_t i = 0; i < count; i++)
+                assert(write(fds[i][1], &i, sizeof(i)) == sizeof(i));
+        });
+        scheduler.run(2);
+        writer.join();
+
+        assert(asyncDone == count);
+        for (int i = 0; i < count; i++)
+        {
+            assert(vms[i]->getRegister(R0) == (uint32_t)i + 1);
+            close(fds[i][0]);
+            close(fds[i][1]);
+            delete vms[i];
+        }
+    }
+
+    printf("%s\n", "Test: Scheduler queues VMs waiting on the same descriptor;");
+    {
+        uint8_t program[] = {
+            OP_INT, 1,
+            OP_INC, R0,
+            OP_HALT};
+        const int count = 4;
+        int fds[2];
+        VM *vms[count];
+        VMScheduler scheduler(completeAsyncRead, finishAsyncRead, 16);
+
+        assert(pipe(fds) == 0);
+        asyncDone = 0;
+        for (int i = 0; i < count; i++)
+        {
+            vms[i] = new VM(program, sizeof(program));
+            vms[i]->onInterruptAsync(handleAsyncRead);
+            vms[i]->setRegister(R1, fds[0]);
+            scheduler.submit(vms[i]);
+        }
+
+        std::thread writer([&fds] {
+            usleep(10000);
+            for (uint32_t i = 0; i < count; i++)
+                assert(write(fds[1], &i, sizeof(i)) == sizeof(i));
+        });
+        scheduler.run(2);
+        writer.join();
+
+        // every VM got exactly one of the values
+        assert(asyncDone == count);
+        uint32_t seen = 0;
+        for (int i = 0; i < count; i++)
+        {
+            seen |= 1 << (vms[i]->getRegister(R0) - 1);
+            delete vms[i];
+        }
+        assert(seen == (1 << count) - 1);
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    printf("%s\n", "Test: Scheduler completes regular files and fails unwatchable descriptors;");
+    {
+        uint8_t program[] = {
+            OP_INT, 1,
+            OP_INC, R0,
+            OP_HALT};
+        char path[] = "/tmp/microbytevm_XXXXXX";
+        const int file = mkstemp(path);
+        const uint32_t value = 41;
+        assert(file >= 0 && write(file, &value, sizeof(value)) == sizeof(value));
+        assert(lseek(file, 0, SEEK_SET) == 0);
+        unlink(path);
+
+        int closed[2];
+        assert(pipe(closed) == 0);
+        close(closed[0]);
+        close(closed[1]);
+
+        VM fromFile(program, sizeof(program));
+        VM fromClosed(program, sizeof(program));
+        fromFile.onInterruptAsync(handleAsyncRead);
+        fromClosed.onInterruptAsync(handleAsyncRead);
+        fromFile.setRegister(R1, file);
+        fromClosed.setRegister(R1, closed[0]);
+
+        asyncDone = 0;
+        asyncFailed = 0;
+        VMScheduler scheduler(completeAsyncRead, finishOrFailAsyncRead, 16);
+        scheduler.submit(&fromFile);
+        scheduler.submit(&fromClosed);
+        scheduler.run(2);
+        close(file);
+
+        assert(asyncDone == 1 && asyncFailed == 1);
+        assert(fromFile.getRegister(R0) == 42);
+        assert(fromClosed.waiting());
+    }
+
+    printf("%s\n", "Test: Scheduler overlaps waits on regular files;");
     {
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, 0);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[4], 2);
+        uint8_t program[] = {
+            OP_INT, 1,
+            OP_INC, R0,
+            OP_HALT};
+        const int count = 8;
+        int fds[count];
+        VM *vms[count];
+        VMScheduler scheduler(completeSlowRead, finishAsyncRead, 16);
+
+        asyncDone = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            char path[] = "/tmp/microbytevm_XXXXXX";
+            fds[i] = mkstemp(path);
+            assert(fds[i] >= 0 && write(fds[i], &i, sizeof(i)) == sizeof(i));
+            assert(lseek(fds[i], 0, SEEK_SET) == 0);
+            unlink(path);
+            vms[i] = new VM(program, sizeof(program));
+            vms[i]->onInterruptAsync(handleAsyncRead);
+            vms[i]->setRegister(R1, fds[i]);
+            scheduler.submit(vms[i]);
+        }
 
-        assert(memory[3] == OP_HALT);
-        assert(actual == _U16_GARBAGE);
-        assert(vm.getRegister(R0) == _U16_GARBAGE);
-        assert(memory[6] == 0xFF);
+        // four file threads take two rounds of 50ms, one thread would take eight
+        const uint64_t before = VM::clock();
+        scheduler.run(2, 4);
+        assert(VM::clock() - before < 300000000ULL);
+
+        assert(asyncDone == count);
+        for (int i = 0; i < count; i++)
+        {
+            assert(vms[i]->getRegister(R0) == (uint32_t)i + 1);
+            close(fds[i]);
+            delete vms[i];
+        }
     }
+}
 
-    printf("%s\n", "Test: Load zero;");
+void TEST_CASE_IO_REDIRECT()
+{
+    printf("%s\n", "Test: Read and print through host streams;");
     {
-        vm.reset();
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, _U32_GARBAGE);
-        
-        uint8_t *memory = vm.memory();
-        memset(&memory[4], 0, 2);
+        uint8_t program[] = {
+            OP_READ, R0,
+            OP_READC, R1,
+            OP_INC, R0,
+            OP_PRINT, R0, 1,
+            OP_READS, 18, 0, 8, 0,
+            OP_PRINTS, 18, 0,
+            OP_HALT,
+            0, 0, 0, 0, 0, 0, 0, 0};
+        char input[] = "41\nhello world\n";
+        char *output = nullptr;
+        size_t outputLen = 0;
+        FILE *in = fmemopen(input, strlen(input), "r");
+        FILE *out = open_memstream(&output, &outputLen);
 
+        VM vm(program, sizeof(program));
+        vm.setInput(in);
+        vm.setOutput(out);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        memcpy(&actual, &memory[4], 2);
-
-        assert(memory[3] == OP_HALT);
-        assert(actual == 0);
-        assert(vm.getRegister(R0) == 0);
-        assert(memory[6] == 0xFF);
+        fclose(out);
+        fclose(in);
+        assert(vm.getRegister(R1) == '\n');
+        assert(strcmp(output, "42\nhello w") == 0);
+        free(output);
     }
 }
 
-void TEST_CASE_OP_LOADB()
+void TEST_CASE_OP_HALT()
 {
     uint8_t program[] = {
-        OP_LOADB, R0, 5, 0,
         OP_HALT,
-        _U8_GARBAGE,
-        0xFF};
+        OP_LCONSB, R0, 1,
+        OP_HALT};
     VM vm(program, sizeof(program));
+    vm.setRegister(R0, 123);
+    assert(vm.run() == ExecResult::VM_FINISHED);
+    assert(vm.getRegister(R0) == 123);
+    assert(vm.getRegister(IP) == 0);
+}
 
-    printf("%s\n", "Test: Load value;");
-    {
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
+void TEST_CASE_OP_NOP()
+{
+    uint8_t program[] = {
+        OP_NOP,
+        OP_HALT};
+    VM vm(program, sizeof(program));
+    assert(vm.run() == ExecResult::VM_FINISHED);
 
-        assert(memory[4] == OP_HALT);
-        assert(memory[5] == _U8_GARBAGE);
-        assert(vm.getRegister(R0) == _U8_GARBAGE);
-        assert(memory[6] == 0xFF);
+    printf("%s\n", "Test: Registers unchanged;");
+    {
+        for (uint8_t i = R0; i <= T9; i++)
+            assert(vm.getRegister((Register)i) == 0);
     }
 
-    printf("%s\n", "Test: Load zero;");
+    printf("%s\n", "Test: Correct IP;");
     {
-        vm.reset();
-        uint8_t *memory = vm.memory();
-
-        vm.setRegister(R0, _U32_GARBAGE);
-        memory[5] = 0;
-        assert(vm.run() == ExecResult::VM_FINISHED);
-
-        assert(memory[4] == OP_HALT);
-        assert(memory[5] == 0);
-        assert(vm.getRegister(R0) == 0);
-        assert(memory[6] == 0xFF);
+        assert(vm.getRegister(IP) == 1);
     }
 }
 
-void TEST_CASE_OP_LOADB_P()
+void TEST_CASE_BATCH()
 {
-    uint8_t program[] = {
-        OP_LOADB_P, R0, R1,
-        OP_HALT,
-        _U8_GARBAGE,
-        0xFF};
-    VM vm(program, sizeof(program));
+    printf("%s\n", "Test: Diverging loops match the scalar VM;");
+    {
+        uint8_t program[] = {
+            OP_LCONSB, R1, 0,
+            OP_ADD, R1, R1, R0,
+            OP_DEC, R0,
+            OP_JNZ, R0, 3, 0,
+            OP_PUSH, R1,
+            OP_POP, R2,
+            OP_HALT};
+        VMBatch batch(program, sizeof(program), 13);
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+            batch.setRegister(l, R0, l + 1);
+        batch.run();
 
-    printf("%s\n", "Test: Load value;");
+        VM vm(program, sizeof(program));
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            vm.reset();
+            vm.setRegister(R0, l + 1);
+            assert(vm.run() == ExecResult::VM_FINISHED);
+            assert(batch.result(l) == ExecResult::VM_FINISHED);
+            assert(batch.getRegister(l, R1) == (l + 1) * (l + 2) / 2);
+            for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+                assert(batch.getRegister(l, (Register)r) == vm.getRegister((Register)r));
+        }
+    }
+
+    printf("%s\n", "Test: Immediate forms match the scalar VM;");
     {
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, 0);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
+        uint8_t program[] = {
+            OP_ADDIB, R1, R0, 3,
+            OP_MULI, R2, R1, 0xF9, 0xFF, 0xFF, 0xFF,
+            OP_SHLIB, R3, R1, 2,
+            OP_ISHRIB, R4, R2, 1,
+            OP_XORIB, R5, R1, 0x55,
+            OP_I2F, T0, R1,
+            OP_FMULI, T1, T0, 0x00, 0x00, 0x00, 0x3F,
+            OP_DIVIB, T2, R1, 3,
+            OP_HALT};
+        VMBatch batch(program, sizeof(program), 11);
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+            batch.setRegister(l, R0, l * 37);
+        batch.run();
 
-        assert(memory[3] == OP_HALT);
-        assert(memory[4] == _U8_GARBAGE);
-        assert(vm.getRegister(R0) == _U8_GARBAGE);
-        assert(memory[5] == 0xFF);
+        VM vm(program, sizeof(program));
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            vm.reset();
+            vm.setRegister(R0, l * 37);
+            assert(vm.run() == ExecResult::VM_FINISHED);
+            assert(batch.result(l) == ExecResult::VM_FINISHED);
+            for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+                assert(batch.getRegister(l, (Register)r) == vm.getRegister((Register)r));
+        }
     }
 
-    printf("%s\n", "Test: Load zero;");
+    printf("%s\n", "Test: Bit manipulation matches the scalar VM;");
     {
-        vm.reset();
-        vm.setRegister(R1, 4);
-        vm.setRegister(R0, _U32_GARBAGE);
-        
-        uint8_t *memory = vm.memory();
-        memory[4] = 0;
+        uint8_t program[] = {
+            OP_MULI, R1, R0, 0xB9, 0x79, 0x37, 0x9E,
+            OP_POPCNT, R2, R1,
+            OP_CLZ, R3, R0,
+            OP_CTZ, R4, R0,
+            OP_ROL, R5, R1, R0,
+            OP_RORIB, T0, R1, 13,
+            OP_BSWAP, T1, R5,
+            OP_BEXT, T2, R1, 5, 9,
+            OP_IMAX, T3, R1, R0,
+            OP_MIN, T4, R1, R0,
+            OP_SELECT, T5, R1, R0, COND_L, R1, R0,
+            OP_HALT};
+        VMBatch batch(program, sizeof(program), 11);
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+            batch.setRegister(l, R0, l * 3);
+        batch.run();
 
-        assert(vm.run() == ExecResult::VM_FINISHED);
+        VM vm(program, sizeof(program));
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            vm.reset();
+            vm.setRegister(R0, l * 3);
+            assert(vm.run() == ExecResult::VM_FINISHED);
+            assert(batch.result(l) == ExecResult::VM_FINISHED);
+            for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+                assert(batch.getRegister(l, (Register)r) == vm.getRegister((Register)r));
+        }
+    }
 
-        assert(memory[3] == OP_HALT);
-        assert(memory[4] == 0);
-        assert(vm.getRegister(R0) == 0);
-        assert(memory[5] == 0xFF);
+    printf("%s\n", "Test: Float math matches the scalar VM;");
+    {
+        uint8_t program[] = {
+            OP_FMA, R2, R1, R1, R1,
+            OP_FSQRT, R3, R1,
+            OP_FABS, R4, R1,
+            OP_FNEG, R5, R1,
+            OP_FMIN, T0, R1, R2,
+            OP_FMAX, T1, R1, R3,
+            OP_FFLOOR, T2, R1,
+            OP_FCEIL, T3, R1,
+            OP_FROUND, T4, R1,
+            OP_JFL, R1, R4, 38, 0, // 31
+            OP_INC, T5,
+            OP_HALT}; // 38
+        VMBatch batch(program, sizeof(program), 11);
+        // lane 0 holds a NaN, the others -2.25 up to 4.5
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+            batch.setRegister(l, R1, l == 0 ? 0x7FC00000 : floatBits(l * 0.75f - 3.0f));
+        batch.run();
+
+        VM vm(program, sizeof(program));
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            vm.reset();
+            vm.setRegister(R1, batch.getRegister(l, R1));
+            assert(vm.run() == ExecResult::VM_FINISHED);
+            assert(batch.result(l) == ExecResult::VM_FINISHED);
+            for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+                assert(batch.getRegister(l, (Register)r) == vm.getRegister((Register)r));
+        }
     }
-}
 
-void TEST_CASE_OP_MEMCPY()
-{
-    uint8_t program[] = {
-        OP_MEMCPY, 8, 0, 12, 0, 4, 0, // copy 4 bytes from 0xC to 0x8
-        OP_HALT,
-        0, 0, 0, 0,
-        _NTH_BYTE(_U32_GARBAGE, 0), _NTH_BYTE(_U32_GARBAGE, 1),
-        _NTH_BYTE(_U32_GARBAGE, 2), _NTH_BYTE(_U32_GARBAGE, 3),
-        0xFF};
-    VM vm(program, sizeof(program));
-    uint32_t actual = 0;
-    uint32_t source = 0;
+    printf("%s\n", "Test: Counted loops and immediate branches match the scalar VM;");
+    {
+        uint8_t program[] = {
+            OP_ADDIB, R1, R1, 1,
+            OP_JLI, R1, 5, 0, 0, 0, 16, 0, // 4
+            OP_ADDIB, R2, R2, 1,
+            OP_DJNZ_S, R0, (uint8_t)-16, // 16
+            OP_JZ_S, R2, 7,
+            OP_JMP_S, 2,
+            OP_INC, R3, // 24
+            OP_HALT};
+        VMBatch batch(program, sizeof(program), 9);
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+            batch.setRegister(l, R0, l + 1);
+        batch.run();
 
-    printf("%s\n", "Test: Copy 4 bytes;");
+        VM vm(program, sizeof(program));
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            vm.reset();
+            vm.setRegister(R0, l + 1);
+            assert(vm.run() == ExecResult::VM_FINISHED);
+            assert(batch.result(l) == ExecResult::VM_FINISHED);
+            for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+                assert(batch.getRegister(l, (Register)r) == vm.getRegister((Register)r));
+        }
+    }
+
+    printf("%s\n", "Test: Reading IP matches the scalar VM;");
     {
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[8], 4);
-        memcpy(&source, &memory[12], 4);
+        uint8_t program[] = {
+            OP_MOV, R0, IP,
+            OP_ADD, R1, IP, R2,
+            OP_JE, IP, R3, 14, 0, // 7
+            OP_INC, R4,
+            OP_HALT}; // 14
+        VMBatch batch(program, sizeof(program), 5);
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            batch.setRegister(l, R2, l);
+            batch.setRegister(l, R3, l == 2 ? 11 : 0);
+        }
+        batch.run();
 
-        assert(memory[7] == OP_HALT);
-        assert(actual == _U32_GARBAGE);
-        assert(source == _U32_GARBAGE);
-        assert(memory[16] == 0xFF);
+        VM vm(program, sizeof(program));
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            vm.reset();
+            vm.setRegister(R2, l);
+            vm.setRegister(R3, l == 2 ? 11 : 0);
+            assert(vm.run() == ExecResult::VM_FINISHED);
+            assert(batch.result(l) == ExecResult::VM_FINISHED);
+            for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+                assert(batch.getRegister(l, (Register)r) == vm.getRegister((Register)r));
+        }
+        assert(batch.getRegister(0, R0) == 2 && batch.getRegister(0, R1) == 6);
     }
-}
 
-void TEST_CASE_OP_MEMCPY_P()
-{
-    uint8_t program[] = {
-        OP_MEMCPY_P, R0, R1, R2,
-        OP_HALT,
-        0, 0, 0, 0,
-        _NTH_BYTE(_U32_GARBAGE, 0), _NTH_BYTE(_U32_GARBAGE, 1),
-        _NTH_BYTE(_U32_GARBAGE, 2), _NTH_BYTE(_U32_GARBAGE, 3),
-        0xFF};
-    VM vm(program, sizeof(program));
-    uint32_t actual = 0;
-    uint32_t source = 0;
+    printf("%s\n", "Test: Paused lanes resume;");
+    {
+        uint8_t program[] = {
+            OP_INC, R0,
+            OP_INC, R0,
+            OP_INC, R0,
+            OP_HALT};
+        VMBatch batch(program, sizeof(program), 3);
+        batch.run(2);
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            assert(batch.result(l) == ExecResult::VM_PAUSED);
+            assert(batch.getRegister(l, R0) == 2);
+            assert(batch.getRegister(l, IP) == 4);
+        }
+        batch.run();
+        for (uint32_t l = 0; l < batch.laneCount(); l++)
+        {
+            assert(batch.result(l) == ExecResult::VM_FINISHED);
+            assert(batch.getRegister(l, R0) == 3);
+            assert(batch.instrCount(l) == 1);
+        }
+    }
 
-    printf("%s\n", "Test: Copy 4 bytes;");
+    printf("%s\n", "Test: Faulting lane does not stop the others;");
     {
-        vm.setRegister(R0, 5);
-        vm.setRegister(R1, 9);
-        vm.setRegister(R2, 4);
-        assert(vm.run() == ExecResult::VM_FINISHED);
+        uint8_t program[] = {
+            OP_LOAD_P, R1, R0,
+            OP_HALT};
+        VMBatch batch(program, sizeof(program), 2);
+        batch.setRegister(1, R0, 0xFFFF);
+        batch.run();
+        assert(batch.result(0) == ExecResult::VM_FINISHED);
+        assert(batch.getRegister(0, R1) == (OP_LOAD_P | R1 << 8 | R0 << 16 | OP_HALT << 24));
+        assert(batch.result(1) == ExecResult::VM_ERR_INVALID_ADDRESS);
+    }
+}
 
-        uint8_t *memory = vm.memory();
-        memcpy(&actual, &memory[5], 4);
-        memcpy(&source, &memory[9], 4);
+void TEST_CASE_PROGRAM_CACHE()
+{
+    printf("%s\n", "Test: CRC32C;");
+    {
+        assert(hashProgram((const uint8_t *)"123456789", 9) == 0xE3069283U);
+        assert(hashProgram((const uint8_t *)"", 0) == 0);
+    }
 
-        assert(memory[4] == OP_HALT);
-        assert(actual == _U32_GARBAGE);
-        assert(source == _U32_GARBAGE);
-        assert(memory[13] == 0xFF);
+    printf("%s\n", "Test: Analysis finds instructions and block leaders;");
+    {
+        uint8_t program[] = {
+            OP_LCONSB, R0, 3,
+            OP_DEC, R0,
+            OP_JNZ, R0, 3, 0,
+            OP_CALL, 13, 0,
+            OP_HALT,
+            OP_RET};
+        Program analyzed(program, sizeof(program));
+        assert(analyzed.verified);
+        assert(analyzed.isStart(0) && analyzed.isStart(3) && analyzed.isStart(5));
+        assert(analyzed.isStart(9) && analyzed.isStart(12) && analyzed.isStart(13));
+        assert(!analyzed.isStart(1) && !analyzed.isStart(6));
+        assert(analyzed.isLeader(0) && analyzed.isLeader(3) && analyzed.isLeader(9));
+        assert(analyzed.isLeader(12) && analyzed.isLeader(13));
+        assert(!analyzed.isLeader(5));
+    }
+
+    printf("%s\n", "Test: Analysis rejects bad programs;");
+    {
+        uint8_t outside[] = {OP_JMP, 9, 0, OP_HALT};
+        uint8_t middle[] = {OP_JZ, R0, 5, 0, OP_LCONSB, R0, 1, OP_HALT};
+        uint8_t reg[] = {OP_INC, REGISTER_COUNT, OP_HALT};
+        uint8_t unknown[] = {INSTRUCTION_COUNT};
+        uint8_t runsOff[] = {OP_NOP};
+        assert(!Program(outside, sizeof(outside)).verified);
+        assert(!Program(middle, sizeof(middle)).verified);
+        assert(!Program(reg, sizeof(reg)).verified);
+        assert(!Program(unknown, sizeof(unknown)).verified);
+        assert(!Program(runsOff, sizeof(runsOff)).verified);
+    }
+
+    printf("%s\n", "Test: Cache shares programs and evicts the least recently used;");
+    {
+        uint8_t first[] = {OP_INC, R0, OP_HALT};
+        uint8_t second[] = {OP_DEC, R0, OP_HALT};
+        ProgramCache cache;
+        bool hit = true;
+
+        std::shared_ptr<const Program> a = cache.load(first, sizeof(first), &hit);
+        assert(!hit);
+        assert(cache.load(first, sizeof(first), &hit) == a);
+        assert(hit);
+        std::shared_ptr<const Program> b = cache.load(second, sizeof(second), &hit);
+        assert(!hit && b != a);
+        assert(cache.count() == 2);
+        assert(cache.hits() == 1 && cache.misses() == 2);
+
+        cache.load(first, sizeof(first));
+        cache.setBudget(a->footprint());
+        assert(cache.count() == 1);
+        assert(cache.load(first, sizeof(first), &hit) == a && hit);
+        // evicted programs stay alive while someone holds them
+        assert(b->code[0] == OP_DEC);
+        assert(cache.load(second, sizeof(second), &hit) != b && !hit);
     }
 }
 
-void TEST_CASE_OP_LCONS()
+void TEST_CASE_PREEMPTION()
 {
-    printf("%s\n", "Test: Load zero;");
+    printf("%s\n", "Test: Deadline stops a runaway loop;");
     {
         uint8_t program[] = {
-            OP_LCONS, R0, 0, 0, 0, 0,
-            OP_HALT};
+            OP_INC, R0,
+            OP_JMP, 0, 0};
         VM vm(program, sizeof(program));
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.runFor(2000000) == ExecResult::VM_DEADLINE);
+        assert(vm.getRegister(IP) == 0);
+        const uint32_t count = vm.getRegister(R0);
+        assert(count > 0);
+        assert(vm.runFor(1000000) == ExecResult::VM_DEADLINE);
+        assert(vm.getRegister(R0) > count);
     }
 
-    printf("%s\n", "Test: Load max;");
+    printf("%s\n", "Test: Interrupt from another thread;");
     {
         uint8_t program[] = {
-            OP_LCONS, R0, 0xFF, 0xFF, 0xFF, 0xFF,
-            OP_HALT};
+            OP_INC, R0,
+            OP_JMP, 0, 0};
         VM vm(program, sizeof(program));
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == UINT32_MAX);
+        std::thread host([&vm] {
+            usleep(5000);
+            vm.interrupt();
+        });
+        assert(vm.runUntil(0) == ExecResult::VM_INTERRUPTED);
+        host.join();
+        assert(vm.getRegister(IP) == 0);
+        assert(vm.runUntil(0, 10) == ExecResult::VM_PAUSED);
     }
-}
 
-void TEST_CASE_OP_LCONSW()
-{
-    printf("%s\n", "Test: Load zero;");
+    printf("%s\n", "Test: A plain run drops the interrupt request;");
     {
         uint8_t program[] = {
-            OP_LCONSW, R0, 0, 0,
+            OP_INC, R0,
+            OP_JMP, 0, 0};
+        VM vm(program, sizeof(program));
+        vm.interrupt();
+        assert(vm.run(10) == ExecResult::VM_PAUSED);
+        assert(vm.getRegister(R0) == 5);
+        assert(vm.runUntil(0, 10) == ExecResult::VM_PAUSED);
+        assert(vm.getRegister(R0) == 10);
+    }
+
+    printf("%s\n", "Test: Straight-line code never samples the clock;");
+    {
+        uint8_t program[] = {
+            OP_INC, R0,
             OP_HALT};
         VM vm(program, sizeof(program));
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.runUntil(1) == ExecResult::VM_FINISHED);
+        assert(vm.getRegister(R0) == 1);
     }
 
-    printf("%s\n", "Test: Load max;");
+    printf("%s\n", "Test: Calls are preemption points;");
     {
         uint8_t program[] = {
-            OP_LCONSW, R0, 0xFF, 0xFF,
+            OP_CALL, 4, 0,
+            OP_HALT,
+            OP_INC, R0,
             OP_HALT};
         VM vm(program, sizeof(program));
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        assert(vm.runUntil(1) == ExecResult::VM_DEADLINE);
+        assert(vm.getRegister(IP) == 4);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == UINT16_MAX);
+        assert(vm.getRegister(R0) == 1);
     }
 }
 
-void TEST_CASE_OP_LCONSB()
+void TEST_CASE_OPCODE_PROFILE()
 {
-    printf("%s\n", "Test: Load zero;");
+    uint8_t program[] = {
+        OP_LCONSB, R0, 10,
+        OP_ADD, R1, R1, R0,
+        OP_DEC, R0,
+        OP_JNZ, R0, 3, 0,
+        OP_HALT};
+
+    printf("%s\n", "Test: Retired counts and histograms;");
     {
-        uint8_t program[] = {
-            OP_LCONSB, R0, 0,
-            OP_HALT};
+        OpcodeProfile profile;
         VM vm(program, sizeof(program));
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        vm.attachProfile(&profile);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
+        assert(vm.getRegister(R1) == 55);
+        assert(profile.count(OP_LCONSB) == 1);
+        assert(profile.count(OP_ADD) == 10);
+        assert(profile.count(OP_DEC) == 10);
+        assert(profile.count(OP_JNZ) == 10);
+        assert(profile.count(OP_HALT) == 1);
+        assert(profile.total() == 32);
+
+        uint64_t samples = 0;
+        for (uint8_t b = 0; b < OPPROFILE_BUCKETS; b++)
+            samples += profile.histogram(OP_ADD, b);
+        assert(samples == 10);
     }
 
-    printf("%s\n", "Test: Load max;");
+    printf("%s\n", "Test: Faulting instruction is counted;");
     {
-        uint8_t program[] = {
-            OP_LCONSB, R0, 0xFF,
+        uint8_t faulting[] = {
+            OP_INC, R1,
+            OP_LOAD_P, R0, R1,
             OP_HALT};
+        OpcodeProfile profile;
+        VM vm(faulting, sizeof(faulting));
+        vm.attachProfile(&profile);
+        vm.setRegister(R1, 0xFFFE);
+        assert(vm.run() == ExecResult::VM_ERR_INVALID_ADDRESS);
+        assert(profile.count(OP_INC) == 1);
+        assert(profile.count(OP_LOAD_P) == 1);
+        assert(profile.count(OP_HALT) == 0);
+        assert(profile.total() == 2);
+    }
+
+    printf("%s\n", "Test: Detached profile is not updated;");
+    {
+        OpcodeProfile profile;
         VM vm(program, sizeof(program));
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        vm.attachProfile(&profile);
+        vm.attachProfile(nullptr);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == UINT8_MAX);
+        assert(profile.total() == 0);
+    }
+
+    printf("%s\n", "Test: JSON and CSV dumps;");
+    {
+        OpcodeProfile profile;
+        VM vm(program, sizeof(program));
+        vm.attachProfile(&profile);
+        assert(vm.runFor(1000000000) == ExecResult::VM_FINISHED);
+
+        char *json = nullptr;
+        size_t jsonLen = 0;
+        FILE *out = open_memstream(&json, &jsonLen);
+        profile.writeJson(out);
+        fclose(out);
+        assert(strstr(json, "{\"op\": \"add\", \"count\": 10,") != nullptr);
+        assert(strstr(json, "{\"op\": \"halt\", \"count\": 1,") != nullptr);
+        assert(strstr(json, "\"mul\"") == nullptr);
+        free(json);
+
+        char *csv = nullptr;
+        size_t csvLen = 0;
+        out = open_memstream(&csv, &csvLen);
+        profile.writeCsv(out);
+        fclose(out);
+        assert(strncmp(csv, "op,count,cycles,cycles_per_op,lt_1,", 35) == 0);
+        assert(strstr(csv, "\njnz,10,") != nullptr);
+        free(csv);
     }
 }
 
-void TEST_CASE_OP_MOV()
+SamplingProfiler *activeProfiler = nullptr;
+
+bool sampleOnInterrupt(uint8_t code)
 {
-    uint8_t program[] = {
-        OP_MOV, R0, R1,
-        OP_HALT};
-    VM vm(program, sizeof(program));
+    activeProfiler->sample();
+    return true;
+}
 
-    printf("%s\n", "Test: Load zero;");
+void TEST_CASE_SAMPLING_PROFILER()
+{
+    printf("%s\n", "Test: Samples carry the shadow call stack;");
     {
-        vm.reset();
-        vm.setRegister(R1, 0);
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 0);
-    }
+        uint8_t program[] = {
+            OP_CALL, 4, 0,
+            OP_HALT,
+            OP_PUSH, RA,
+            OP_CALL, 12, 0,
+            OP_POP, RA,
+            OP_RET,
+            OP_INT, 1,
+            OP_RET};
+
+        SamplingProfiler profiler;
+        profiler.addLabel(0, "main");
+        profiler.addLabel(4, "f");
+        profiler.addLabel(12, "g");
+        activeProfiler = &profiler;
 
-    printf("%s\n", "Test: Load 1122334455U;");
-    {
-        vm.reset();
-        vm.setRegister(R1, 1122334455U);
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        VM vm(program, sizeof(program));
+        vm.onInterrupt(sampleOnInterrupt);
+        assert(profiler.start(&vm, 1000000));
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == 1122334455U);
+        profiler.stop();
+        assert(profiler.sampleCount() == 1);
+
+        char *folded = nullptr;
+        size_t foldedLen = 0;
+        FILE *out = open_memstream(&folded, &foldedLen);
+        profiler.writeFolded(out);
+        fclose(out);
+        assert(strcmp(folded, "main;f;g;g+0x1 1\n") == 0);
+        free(folded);
     }
 
-    printf("%s\n", "Test: Load max;");
+    printf("%s\n", "Test: Timer samples a busy subroutine;");
     {
-        vm.reset();
-        vm.setRegister(R1, UINT32_MAX);
-        vm.setRegister(R0, _U32_GARBAGE); // set garbage
+        uint8_t program[] = {
+            OP_LCONS, R0, 0x00, 0x2D, 0x31, 0x01,
+            OP_CALL, 10, 0,
+            OP_HALT,
+            OP_DEC, R0,
+            OP_JNZ, R0, 10, 0,
+            OP_RET};
+
+        SamplingProfiler profiler;
+        profiler.addLabel(0, "main");
+        profiler.addLabel(10, "spin");
+
+        VM vm(program, sizeof(program));
+        assert(profiler.start(&vm, 1000));
+        assert(!SamplingProfiler().start(&vm));
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.getRegister(R0) == UINT32_MAX);
+        profiler.stop();
+        assert(profiler.sampleCount() > 0);
+        assert(profiler.dropped() == 0);
+
+        char *folded = nullptr;
+        size_t foldedLen = 0;
+        FILE *out = open_memstream(&folded, &foldedLen);
+        profiler.writeFolded(out);
+        fclose(out);
+        assert(strncmp(folded, "main;spin", 9) == 0);
+        free(folded);
     }
 }
 
-void TEST_CASE_OP_PUSH()
+void TEST_CASE_EXECUTION_TRACE()
 {
     uint8_t program[] = {
-        OP_PUSH, R0,
+        OP_LCONSB, R0, 7,
+        OP_ADD, R1, R0, R0,
+        OP_POP, R2,
         OP_HALT};
-    VM vm(program, sizeof(program));
 
-    printf("%s\n", "Test: Zero;");
+    printf("%s\n", "Test: Trace ends at the failing instruction;");
     {
-        vm.setRegister(R0, 0);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 4);
-        assert(vm.stackPop() == 0);
+        ExecutionTrace trace(3);
+        assert(trace.capacity() == 4);
+        VM vm(program, sizeof(program));
+        vm.attachTrace(&trace);
+        assert(vm.run() == ExecResult::VM_ERR_STACK_UNDERFLOW);
+        assert(trace.size() == 3);
+        assert(trace.executed() == 3);
+        assert(trace.at(0).ip == 0 && trace.at(0).op == OP_LCONSB && trace.at(0).value == 7);
+        assert(trace.at(1).ip == 3 && trace.at(1).retired && trace.at(1).value == 14);
+        assert(trace.at(2).ip == 7 && trace.at(2).op == OP_POP && !trace.at(2).retired);
     }
 
-    printf("%s\n", "Test: 1123497651;");
+    printf("%s\n", "Test: Ring keeps the last records;");
     {
-        vm.reset();
-        vm.setRegister(R0, 1123497651);
+        uint8_t loop[] = {
+            OP_LCONSB, R0, 10,
+            OP_DEC, R0,
+            OP_JNZ, R0, 3, 0,
+            OP_HALT};
+
+        ExecutionTrace trace(4);
+        VM vm(loop, sizeof(loop));
+        vm.attachTrace(&trace);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 4);
-        assert(vm.stackPop() == 1123497651);
+        assert(trace.executed() == 22);
+        assert(trace.size() == 4);
+        assert(trace.at(0).op == OP_JNZ && trace.at(1).op == OP_DEC && trace.at(1).value == 0);
+        assert(trace.at(3).op == OP_HALT && !trace.at(3).retired);
     }
 
-    printf("%s\n", "Test: UINT32_MAX;");
+    printf("%s\n", "Test: Binary dump and disassembly;");
     {
-        vm.reset();
-        vm.setRegister(R0, UINT32_MAX);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 4);
-        assert(vm.stackPop() == UINT32_MAX);
+        ExecutionTrace trace;
+        VM vm(program, sizeof(program));
+        vm.attachTrace(&trace);
+        vm.run();
+
+        char *dump = nullptr;
+        size_t dumpLen = 0;
+        FILE *out = open_memstream(&dump, &dumpLen);
+        assert(trace.writeBinary(out));
+        fclose(out);
+
+        ExecutionTrace loaded(1);
+        FILE *in = fmemopen(dump, dumpLen, "rb");
+        assert(loaded.readBinary(in));
+        fclose(in);
+
+        // a header claiming far more records than follow it
+        const uint32_t count = 0x7FFFFFFF;
+        const uint64_t executed = 0xFFFFFFFF;
+        memcpy(dump + 4, &count, sizeof(count));
+        memcpy(dump + 8, &executed, sizeof(executed));
+        ExecutionTrace corrupt(1);
+        in = fmemopen(dump, dumpLen, "rb");
+        assert(!corrupt.readBinary(in));
+        fclose(in);
+        free(dump);
+        assert(loaded.size() == 3 && loaded.executed() == 3);
+        assert(loaded.at(1).value == 14);
+
+        char *text = nullptr;
+        size_t textLen = 0;
+        out = open_memstream(&text, &textLen);
+        loaded.disassemble(out, program, sizeof(program));
+        fclose(out);
+        assert(strstr(text, "0x0003  add r1, r0, r0") != nullptr);
+        assert(strstr(text, "r1=0x0000000e") != nullptr);
+        assert(strstr(text, "0x0007  pop r2") != nullptr);
+        assert(strstr(text, "<- stopped") != nullptr);
+        free(text);
     }
 }
 
-void TEST_CASE_OP_POP()
+void TEST_CASE_BLOCK_COVERAGE()
 {
     uint8_t program[] = {
-        OP_POP, R0,
+        OP_LCONSB, R0, 3,
+        OP_DEC, R0,
+        OP_JNZ, R0, 3, 0,
+        OP_HALT,
+        OP_NOP,
         OP_HALT};
-    VM vm(program, sizeof(program));
 
-    printf("%s\n", "Test: Zero;");
-    {
-        vm.stackPush(0);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 0);
-        assert(vm.getRegister(R0) == 0);
-    }
+    std::shared_ptr<const Program> code = std::make_shared<const Program>(program, sizeof(program));
 
-    printf("%s\n", "Test: 1123497651;");
+    printf("%s\n", "Test: Counts block entries;");
     {
-        vm.reset();
-        vm.stackPush(1123497651);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 0);
-        assert(vm.getRegister(R0) == 1123497651);
-    }
+        BlockCoverage coverage(code);
+        assert(coverage.blockCount() == 3);
+        assert(coverage.blockStart(0) == 0 && coverage.blockStart(1) == 3 && coverage.blockStart(2) == 9);
 
-    printf("%s\n", "Test: UINT32_MAX;");
-    {
-        vm.reset();
-        vm.stackPush(UINT32_MAX);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 0);
-        assert(vm.getRegister(R0) == UINT32_MAX);
+        VM vm(program, sizeof(program));
+        vm.attachCoverage(&coverage);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(coverage.count(0) == 1);
+        assert(coverage.count(1) == 3);
+        assert(coverage.count(2) == 1);
+        assert(coverage.covered() == 3);
+    }
+
+    printf("%s\n", "Test: Merges runs and instances;");
+    {
+        BlockCoverage first(code);
+        BlockCoverage second(code);
+        VM vm1(program, sizeof(program));
+        VM vm2(program, sizeof(program));
+        vm1.attachCoverage(&first);
+        vm2.attachCoverage(&second);
+        vm1.run();
+        vm1.reset();
+        vm1.run();
+        vm2.run();
+        assert(first.count(1) == 6);
+        assert(first.merge(second));
+        assert(first.count(1) == 9);
+
+        uint8_t other[] = {OP_HALT};
+        BlockCoverage unrelated(std::make_shared<const Program>(other, sizeof(other)));
+        assert(!first.merge(unrelated));
+
+        char *saved = nullptr;
+        size_t savedLen = 0;
+        FILE *out = open_memstream(&saved, &savedLen);
+        assert(first.save(out));
+        fclose(out);
+        FILE *in = fmemopen(saved, savedLen, "rb");
+        assert(second.load(in));
+        fclose(in);
+        free(saved);
+        assert(second.count(0) == 4);
+        assert(second.count(1) == 12);
+    }
+
+    printf("%s\n", "Test: Report ranks hot blocks;");
+    {
+        BlockCoverage coverage(code);
+        VM vm(program, sizeof(program));
+        vm.attachCoverage(&coverage);
+        vm.run();
+
+        char *report = nullptr;
+        size_t reportLen = 0;
+        FILE *out = open_memstream(&report, &reportLen);
+        coverage.writeReport(out);
+        fclose(out);
+        assert(strstr(report, "3 of 3 blocks covered, 5 block entries") != nullptr);
+        const char *hot = strstr(report, "\n1      3 ");
+        assert(hot != nullptr && strstr(hot, "0x0003-0x0008 dec r0") != nullptr);
+        free(report);
     }
 }
 
-void TEST_CASE_OP_POP2()
+void TEST_CASE_PERF_COUNTERS()
 {
     uint8_t program[] = {
-        OP_POP2, R0, R1,
+        OP_LCONSW, R0, 0x10, 0x27,
+        OP_DEC, R0,
+        OP_JNZ, R0, 4, 0,
         OP_HALT};
-    VM vm(program, sizeof(program));
+    const uint32_t hash = hashProgram(program, sizeof(program));
 
-    printf("%s\n", "Test: Zero;");
+    printf("%s\n", "Test: VM counts retired instructions;");
     {
-        vm.stackPush(0);
-        vm.stackPush(0);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 0);
-        assert(vm.getRegister(R0) == 0);
-        assert(vm.getRegister(R1) == 0);
+        VM vm(program, sizeof(program));
+        assert(vm.run(1001) == ExecResult::VM_PAUSED);
+        assert(vm.retired() == 1001);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        assert(vm.retired() == 20001);
+    }
+
+    printf("%s\n", "Test: Counters are attributed per VM and program;");
+    {
+        PerfCounters perf;
+        VM vm1(program, sizeof(program));
+        VM vm2(program, sizeof(program));
+        assert(perf.run(&vm1, hash) == ExecResult::VM_FINISHED);
+        vm1.reset();
+        assert(perf.run(&vm1, hash) == ExecResult::VM_FINISHED);
+        assert(perf.run(&vm2, hash, 100) == ExecResult::VM_PAUSED);
+
+        const PerfStats *first = perf.stats(&vm1, hash);
+        const PerfStats *second = perf.stats(&vm2, hash);
+        assert(first != nullptr && second != nullptr);
+        assert(perf.stats(&vm1, hash + 1) == nullptr);
+        assert(first->runs == 2 && first->retired == 40002);
+        assert(second->runs == 1 && second->retired == 100);
+        if (perf.available(PERF_INSTRUCTIONS))
+            assert(first->values[PERF_INSTRUCTIONS] > first->retired);
+        if (perf.available(PERF_TASK_CLOCK))
+            assert(first->values[PERF_TASK_CLOCK] > 0);
+
+        char *report = nullptr;
+        size_t reportLen = 0;
+        FILE *out = open_memstream(&report, &reportLen);
+        perf.writeReport(out);
+        fclose(out);
+        assert(strncmp(report, "vm,program,runs,retired", 23) == 0);
+        assert(strstr(report, ",2,40002") != nullptr);
+        free(report);
     }
+}
 
-    printf("%s\n", "Test: 1123497651 / 123;");
+void TEST_CASE_CALL_GRAPH()
+{
+    printf("%s\n", "Test: Exclusive and inclusive costs;");
     {
-        vm.reset();
-        vm.stackPush(1123497651);
-        vm.stackPush(123);
+        uint8_t program[] = {
+            OP_CALL, 7, 0,
+            OP_CALL, 7, 0,
+            OP_HALT,
+            OP_PUSH, RA,
+            OP_CALL, 15, 0,
+            OP_POP, RA,
+            OP_RET,
+            OP_NOP,
+            OP_RET};
+
+        CallGraphProfiler profiler;
+        profiler.addLabel(0, "main");
+        profiler.addLabel(7, "f");
+        profiler.addLabel(15, "g");
+        VM vm(program, sizeof(program));
+        vm.attachCallGraph(&profiler);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        profiler.unwind();
+        assert(profiler.instructions() == 14);
+
+        const CallGraphFunction *main = profiler.function(0);
+        const CallGraphFunction *f = profiler.function(7);
+        const CallGraphFunction *g = profiler.function(15);
+        assert(main != nullptr && f != nullptr && g != nullptr);
+        assert(main->selfInstructions == 2 && main->inclusiveInstructions == 14);
+        assert(f->calls == 2 && f->selfInstructions == 8 && f->inclusiveInstructions == 12);
+        assert(g->calls == 2 && g->selfInstructions == 4 && g->inclusiveInstructions == 4);
+        assert(profiler.edgeCalls(0, 7) == 2);
+        assert(profiler.edgeCalls(7, 15) == 2);
+        assert(profiler.edgeCalls(0, 15) == 0);
+
+        char *callgrind = nullptr;
+        size_t callgrindLen = 0;
+        FILE *out = open_memstream(&callgrind, &callgrindLen);
+        profiler.writeCallgrind(out);
+        fclose(out);
+        assert(strstr(callgrind, "events: Instructions Cycles\n") != nullptr);
+        assert(strstr(callgrind, "fn=(1) main\n0x0000 2 ") != nullptr);
+        assert(strstr(callgrind, "cfn=(2) f\ncalls=1 0x0007\n0x0000 6 ") != nullptr);
+        assert(strstr(callgrind, "cfn=(2)\ncalls=1 0x0007\n0x0003 6 ") != nullptr);
+        assert(strstr(callgrind, "cfn=(3) g\ncalls=2 0x000f\n0x0009 4 ") != nullptr);
+        free(callgrind);
+    }
+
+    printf("%s\n", "Test: Recursion is counted once;");
+    {
+        uint8_t program[] = {
+            OP_LCONSB, R0, 3,
+            OP_CALL, 7, 0,
+            OP_HALT,
+            OP_JZ, R0, 20, 0,
+            OP_DEC, R0,
+            OP_PUSH, RA,
+            OP_CALL, 7, 0,
+            OP_POP, RA,
+            OP_RET};
+
+        CallGraphProfiler profiler;
+        VM vm(program, sizeof(program));
+        vm.attachCallGraph(&profiler);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 0);
-        assert(vm.getRegister(R0) == 123);
-        assert(vm.getRegister(R1) == 1123497651);
+        profiler.unwind();
+
+        const CallGraphFunction *r = profiler.function(7);
+        assert(r->calls == 4);
+        assert(r->selfInstructions == 20);
+        assert(r->inclusiveInstructions == 20);
+        assert(profiler.edgeCalls(7, 7) == 3);
+        assert(profiler.edgeCalls(0, 7) == 1);
     }
 
-    printf("%s\n", "Test: UINT32_MAX;");
+    printf("%s\n", "Test: Tail calls replace the caller;");
     {
-        vm.reset();
-        vm.stackPush(UINT32_MAX);
-        vm.stackPush(UINT32_MAX);
+        uint8_t program[] = {
+            OP_CALLF, 4, 0,
+            OP_HALT,
+            OP_TAILCALL, 7, 0, // 4
+            OP_NOP, // 7
+            OP_RETF};
+
+        CallGraphProfiler profiler;
+        VM vm(program, sizeof(program));
+        vm.attachCallGraph(&profiler);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 0);
-        assert(vm.getRegister(R0) == UINT32_MAX);
-        assert(vm.getRegister(R1) == UINT32_MAX);
+        profiler.unwind();
+
+        const CallGraphFunction *main = profiler.function(0);
+        const CallGraphFunction *f = profiler.function(4);
+        const CallGraphFunction *g = profiler.function(7);
+        assert(main->selfInstructions == 1 && main->inclusiveInstructions == 4);
+        assert(f->calls == 1 && f->selfInstructions == 1 && f->inclusiveInstructions == 1);
+        assert(g->calls == 1 && g->selfInstructions == 2 && g->inclusiveInstructions == 2);
+        assert(profiler.edgeCalls(0, 4) == 1);
+        assert(profiler.edgeCalls(0, 7) == 1);
+        assert(profiler.edgeCalls(4, 7) == 0);
     }
 }
 
-void TEST_CASE_OP_DUP()
+void TEST_CASE_MEMORY_HEATMAP()
 {
     uint8_t program[] = {
-        OP_DUP,
+        OP_LCONSB, R0, 5,
+        OP_PUSH, R0,
+        OP_PUSH, R0,
+        OP_PUSH, R0,
+        OP_POP2, R1, R2,
+        OP_POP, R3,
+        OP_STOR, 0x40, 0, R0,
+        OP_LOAD, R4, 0x40, 0,
+        OP_LOAD, R4, 0x40, 0,
+        OP_MEMCPY, 0x80, 0, 0x40, 0, 0x44, 0,
         OP_HALT};
-    VM vm(program, sizeof(program));
-
-    printf("%s\n", "Test: Zero;");
-    {
-        vm.stackPush(0);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 8);
-        assert(vm.stackPop() == 0);
-        assert(vm.stackPop() == 0);
-    }
 
-    printf("%s\n", "Test: 1123497651 ;");
+    printf("%s\n", "Test: Reads and writes per line;");
     {
-        vm.reset();
-        vm.stackPush(1123497651);
+        MemoryHeatmap heatmap(sizeof(program), 256, 4);
+        VM vm(program, sizeof(program));
+        vm.attachHeatmap(&heatmap);
         assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 8);
-        assert(vm.stackPop() == 1123497651);
-        assert(vm.stackPop() == 1123497651);
+        assert(heatmap.lineCount() == 5);
+        assert(heatmap.reads(0) == 0 && heatmap.writes(0) == 0);
+        assert(heatmap.reads(1) == 3 && heatmap.writes(1) == 1);
+        assert(heatmap.reads(2) == 1 && heatmap.writes(2) == 1);
+        assert(heatmap.reads(3) == 0 && heatmap.writes(3) == 1);
+        assert(heatmap.reads(4) == 2 && heatmap.writes(4) == 3);
+        assert(heatmap.stackHighWater() == 12);
     }
 
-    printf("%s\n", "Test: UINT32_MAX;");
+    printf("%s\n", "Test: Working set over time;");
     {
-        vm.reset();
-        vm.stackPush(UINT32_MAX);
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(vm.stackCount() == 8);
-        assert(vm.stackPop() == UINT32_MAX);
-        assert(vm.stackPop() == UINT32_MAX);
+        MemoryHeatmap heatmap(sizeof(program), 256, 4);
+        VM vm(program, sizeof(program));
+        vm.attachHeatmap(&heatmap);
+        vm.run();
+        assert(heatmap.workingSet().size() == 2);
+        assert(heatmap.workingSet()[0] == 1);
+        assert(heatmap.workingSet()[1] == 2);
+
+        char *curve = nullptr;
+        size_t curveLen = 0;
+        FILE *out = open_memstream(&curve, &curveLen);
+        heatmap.writeWorkingSet(out);
+        fclose(out);
+        assert(strcmp(curve, "window,instructions,lines,bytes\n0,4,1,64\n1,4,2,128\n2,2,3,192\n") == 0);
+        free(curve);
+
+        char *map = nullptr;
+        size_t mapLen = 0;
+        out = open_memstream(&map, &mapLen);
+        heatmap.writeHeatmap(out);
+        fclose(out);
+        assert(strstr(map, "reads (log scale, '@' = 3 accesses per line)\n0x0000 | @. *|\n") != nullptr);
+        assert(strstr(map, "0x0000 | ...@|\n") != nullptr);
+        assert(strstr(map, "stack high-water mark: 12 of 256 bytes") != nullptr);
+        free(map);
     }
 }
 
-uint8_t intCode;
-bool intContinue;
-
-bool handleInterrupt(uint8_t code)
+void TEST_CASE_VM_STATS()
 {
-    intCode = code;
-    return intContinue;
-}
+    uint8_t program[] = {
+        OP_READ, R0,
+        OP_READC, R1,
+        OP_PUSH, R0,
+        OP_PUSH, R1,
+        OP_POP2, R2, R3,
+        OP_INT, 1,
+        OP_INC, R0,
+        OP_PRINT, R0, 1,
+        OP_READS, 30, 0, 8, 0,
+        OP_PRINTS, 30, 0,
+        OP_HALT,
+        0, 0, 0, 0, 0, 0, 0, 0};
+    char input[] = "41\nhello world\n";
 
-void TEST_CASE_OP_INT()
-{
-    printf("%s\n", "Test: Code is correct;");
+    printf("%s\n", "Test: Counters of one VM;");
     {
-        uint8_t program[] = {
-            OP_INT, 3,
-            OP_HALT};
+        char *output = nullptr;
+        size_t outputLen = 0;
+        FILE *in = fmemopen(input, strlen(input), "r");
+        FILE *out = open_memstream(&output, &outputLen);
+
         VM vm(program, sizeof(program));
         vm.onInterrupt(handleInterrupt);
         intContinue = true;
-        intCode = 0;
-
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(intCode == 3);
-
-        vm.reset();
-        uint8_t *memory = vm.memory();
-        intCode = 0;
-        memory[1] = 253;
-
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(intCode == 253);
-    }
+        vm.setInput(in);
+        vm.setOutput(out);
+        assert(vm.run(3) == ExecResult::VM_PAUSED);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        fclose(out);
+        fclose(in);
+        free(output);
+
+        const VMStats &stats = vm.stats();
+        assert(stats.get(STAT_INSTRUCTIONS) == vm.retired());
+        assert(stats.get(STAT_RUNS) == 2);
+        assert(stats.get(STAT_INTERRUPTS) == 1);
+        assert(stats.get(STAT_BYTES_READ) == 10);
+        assert(stats.get(STAT_BYTES_PRINTED) == 10);
+        assert(stats.get(STAT_PEAK_STACK) == 8);
+        assert(stats.result(ExecResult::VM_PAUSED) == 1);
+        assert(stats.result(ExecResult::VM_FINISHED) == 1);
+        assert(stats.result(ExecResult::VM_ERR_STACK_OVERFLOW) == 0);
+    }
+
+    printf("%s\n", "Test: Aggregate includes exited threads;");
+    {
+        uint64_t before[STAT_COUNT];
+        uint64_t after[STAT_COUNT];
+        VMStats::aggregate(before);
+
+        std::thread worker([]() {
+            uint8_t loop[] = {
+                OP_LCONSB, R0, 10,
+                OP_DEC, R0,
+                OP_JNZ, R0, 3, 0,
+                OP_HALT};
+            VM vm(loop, sizeof(loop));
+            vm.run();
+            vm.reset();
+            vm.run();
+        });
+        worker.join();
+
+        VMStats::aggregate(after);
+        assert(after[STAT_RUNS] - before[STAT_RUNS] == 2);
+        assert(after[STAT_INSTRUCTIONS] - before[STAT_INSTRUCTIONS] == 42);
+        assert(after[STAT_RESULTS + ExecResult::VM_FINISHED] - before[STAT_RESULTS + ExecResult::VM_FINISHED] == 2);
+    }
+
+    printf("%s\n", "Test: Batch fallback steps are not runs;");
+    {
+        uint64_t before[STAT_COUNT];
+        uint64_t after[STAT_COUNT];
+        VMStats::aggregate(before);
 
-    printf("%s\n", "Test: Can stop exec;");
-    {
         uint8_t program[] = {
-            OP_INT, 3,
-            OP_LCONSB, R0, 123,
+            OP_PUSH, R0,
+            OP_POP, R1,
             OP_HALT};
+        VMBatch batch(program, sizeof(program), 8);
+        batch.run();
+        assert(batch.result(0) == ExecResult::VM_FINISHED);
+
+        VMStats::aggregate(after);
+        assert(after[STAT_RUNS] == before[STAT_RUNS]);
+        assert(after[STAT_RESULTS + ExecResult::VM_PAUSED] == before[STAT_RESULTS + ExecResult::VM_PAUSED]);
+    }
+
+    printf("%s\n", "Test: Prometheus text export;");
+    {
+        uint8_t overflow[] = {
+            OP_PUSH, R0,
+            OP_JMP, 0, 0};
+        VM vm(overflow, sizeof(overflow), 64);
+        assert(vm.run() == ExecResult::VM_ERR_STACK_OVERFLOW);
+
+        StatsExporter exporter;
+        exporter.watch(&vm, "over\"flow");
+
+        char *text = nullptr;
+        size_t textLen = 0;
+        FILE *out = open_memstream(&text, &textLen);
+        exporter.writePrometheus(out);
+        fclose(out);
+        assert(strstr(text, "# TYPE microbytevm_instructions_total counter\nmicrobytevm_instructions_total ") != nullptr);
+        assert(strstr(text, "# TYPE microbytevm_peak_stack_bytes gauge\n") != nullptr);
+        assert(strstr(text, "microbytevm_results_total{result=\"stack_overflow\"} ") != nullptr);
+        assert(strstr(text, "microbytevm_vm_runs_total{vm=\"over\\\"flow\"} 1\n") != nullptr);
+        assert(strstr(text, "microbytevm_vm_results_total{vm=\"over\\\"flow\",result=\"stack_overflow\"} 1\n") != nullptr);
+        free(text);
+
+        char path[] = "/tmp/microbytevm_statsXXXXXX";
+        const int fd = mkstemp(path);
+        close(fd);
+        assert(exporter.writeFile(path));
+        FILE *in = fopen(path, "r");
+        char line[256];
+        assert(fgets(line, sizeof(line), in) != nullptr);
+        assert(strncmp(line, "# HELP microbytevm_instructions_total ", 38) == 0);
+        fclose(in);
+        unlink(path);
+
+        exporter.unwatch(&vm);
+        out = open_memstream(&text, &textLen);
+        exporter.writePrometheus(out);
+        fclose(out);
+        assert(strstr(text, "microbytevm_vm_") == nullptr);
+        free(text);
+    }
+
+    printf("%s\n", "Test: Scrape over a Unix socket;");
+    {
         VM vm(program, sizeof(program));
-        vm.onInterrupt(handleInterrupt);
-        intContinue = true;
-        intCode = 0;
-
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(intCode == 3);
-        assert(vm.getRegister(R0) == 123);
-        assert(vm.getRegister(IP) == 5);
+        StatsExporter exporter;
+        exporter.watch(&vm, "idle");
+
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/microbytevm_stats_%d.sock", (int)getpid());
+        assert(exporter.serve(path));
+
+        for (int i = 0; i < 2; i++)
+        {
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            strcpy(addr.sun_path, path);
+            const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            assert(connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+            const char request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+            assert(write(fd, request, strlen(request)) == (ssize_t)strlen(request));
+
+            std::string response;
+            char buffer[4096];
+            ssize_t len;
+            while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+                response.append(buffer, len);
+            close(fd);
+            assert(response.compare(0, 17, "HTTP/1.0 200 OK\r\n") == 0);
+            assert(response.find("Content-Type: text/plain; version=0.0.4\r\n") != std::string::npos);
+            assert(response.find("microbytevm_vm_runs_total{vm=\"idle\"} 0\n") != std::string::npos);
+        }
 
-        intContinue = false;
-        intCode = 0;
-        vm.reset();
-        assert(vm.run() == ExecResult::VM_FINISHED);
-        assert(intCode == 3);
-        assert(vm.getRegister(R0) == 0);
-        assert(vm.getRegister(IP) == 1);
+        exporter.stop();
+        assert(access(path, F_OK) != 0);
     }
 
-    printf("%s\n", "Test: Unhandled interrupt causes error;");
+    printf("%s\n", "Test: Idle client does not block stop;");
     {
-        uint8_t program[] = {
-            OP_INT, 3,
-            OP_LCONSB, R0, 123,
-            OP_HALT};
-        VM vm(program, sizeof(program));
-        assert(vm.run() == ExecResult::VM_ERR_UNHANDLED_INTERRUPT);
-        assert(vm.getRegister(IP) == 1);
+        StatsExporter exporter;
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/microbytevm_idle_%d.sock", (int)getpid());
+        assert(exporter.serve(path));
+
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, path);
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        assert(connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+        usleep(20000);
+
+        const uint64_t before = VM::clock();
+        exporter.stop();
+        assert(VM::clock() - before < STATS_REQUEST_TIMEOUT_MS * 1000000ULL / 2);
+        close(fd);
     }
 }
 
-void TEST_CASE_OP_HALT()
+VM *recordedVM = nullptr;
+bool handleRecordedInterrupt(uint8_t code)
 {
-    uint8_t program[] = {
-        OP_HALT,
-        OP_LCONSB, R0, 1,
-        OP_HALT};
-    VM vm(program, sizeof(program));
-    vm.setRegister(R0, 123);
-    assert(vm.run() == ExecResult::VM_FINISHED);
-    assert(vm.getRegister(R0) == 123);
-    assert(vm.getRegister(IP) == 0);
+    // host changes while handling an interrupt are part of the recording
+    recordedVM->setRegister(R5, recordedVM->getRegister(R5) + code);
+    recordedVM->memory(40)[0] = 'X';
+    return code != 0;
 }
 
-void TEST_CASE_OP_NOP()
+void TEST_CASE_RECORD_REPLAY()
 {
     uint8_t program[] = {
-        OP_NOP,
-        OP_HALT};
-    VM vm(program, sizeof(program));
-    assert(vm.run() == ExecResult::VM_FINISHED);
+        OP_READ, R0,
+        OP_READC, R1,
+        OP_READS, 40, 0, 8, 0,
+        OP_INT, 7,
+        OP_INT, 7,
+        OP_READF, R2,
+        OP_ADD, R3, R0, R5,
+        OP_PRINT, R3, 1,
+        OP_PRINTS, 40, 0,
+        OP_INT, 0,
+        OP_HALT,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    char input[] = "41\nhello w\n2.5";
 
-    printf("%s\n", "Test: Registers unchanged;");
+    printf("%s\n", "Test: Replay reproduces a recorded run without input;");
     {
-        for (uint8_t i = R0; i <= T9; i++)
-            assert(vm.getRegister((Register)i) == 0);
+        char *recorded = nullptr;
+        size_t recordedLen = 0;
+        FILE *in = fmemopen(input, strlen(input), "r");
+        FILE *out = open_memstream(&recorded, &recordedLen);
+
+        ReplayLog log;
+        VM vm(program, sizeof(program));
+        recordedVM = &vm;
+        vm.onInterrupt(handleRecordedInterrupt);
+        vm.setInput(in);
+        vm.setOutput(out);
+        vm.setRegister(R5, 100);
+        vm.recordTo(&log);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+        vm.recordTo(nullptr);
+        fclose(out);
+        fclose(in);
+        assert(strcmp(recorded, "155\nXello w") == 0);
+        assert(vm.getRegister(R2) == 0x40200000);
+        assert(log.events() == 10);
+        assert(log.size() < 64);
+
+        char *replayed = nullptr;
+        size_t replayedLen = 0;
+        out = open_memstream(&replayed, &replayedLen);
+        VM copy(program, sizeof(program));
+        copy.setInput(nullptr);
+        copy.setOutput(out);
+        assert(copy.replayFrom(&log));
+        assert(copy.getRegister(R5) == 100);
+        assert(copy.run() == ExecResult::VM_FINISHED);
+        fclose(out);
+        assert(log.finished());
+        assert(strcmp(replayed, recorded) == 0);
+        assert(copy.retired() == vm.retired());
+        for (uint8_t r = 0; r < REGISTER_COUNT; r++)
+            assert(copy.getRegister((Register)r) == vm.getRegister((Register)r));
+        assert(memcmp(copy.memory(), vm.memory(), sizeof(program) + 256) == 0);
+        assert(copy.stats().get(STAT_BYTES_READ) == vm.stats().get(STAT_BYTES_READ));
+        free(recorded);
+        free(replayed);
+
+        printf("%s\n", "Test: Replay log survives a save and load;");
+        FILE *f = tmpfile();
+        assert(log.save(f));
+        rewind(f);
+        ReplayLog loaded;
+        assert(loaded.load(f));
+        fclose(f);
+        assert(loaded.events() == log.events() && loaded.size() == log.size());
+        assert(loaded.programLength() == sizeof(program) && loaded.stackSize() == 256);
+
+        out = fopen("/dev/null", "w");
+        VM fromFile(loaded.memory(), loaded.programLength(), loaded.stackSize());
+        fromFile.setOutput(out);
+        assert(fromFile.replayFrom(&loaded));
+        assert(fromFile.run() == ExecResult::VM_FINISHED);
+        fclose(out);
+        assert(fromFile.getRegister(R3) == 155);
+        assert(fromFile.getRegister(R2) == vm.getRegister(R2));
+        assert(fromFile.retired() == vm.retired());
+
+        printf("%s\n", "Test: Replay stops where the program diverges from the log;");
+        VM smaller(program, sizeof(program), 128);
+        assert(!smaller.replayFrom(&log));
+        VM different(program, sizeof(program));
+        assert(different.replayFrom(&log));
+        // a read where the recorded run was interrupted
+        different.memory()[9] = OP_READ;
+        different.memory()[10] = T6;
+        assert(different.run() == ExecResult::VM_ERR_REPLAY_DIVERGED);
+        assert(different.getRegister(IP) == 10);
+    }
+
+    printf("%s\n", "Test: Pending interrupts replay in the state they resumed with;");
+    {
+        uint8_t pending[] = {
+            OP_INT, 1,
+            OP_INC, R0,
+            OP_HALT};
+        ReplayLog log;
+        VM vm(pending, sizeof(pending));
+        vm.onInterruptAsync(handleAsyncRead);
+        vm.setRegister(R1, 42);
+        vm.recordTo(&log);
+        assert(vm.run() == ExecResult::VM_WAITING);
+        vm.setRegister(R0, 122);
+        vm.memory(vm.getRegister(SP) - 4)[0] = 9;
+        assert(vm.resume(42));
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        VM copy(pending, sizeof(pending));
+        assert(copy.replayFrom(&log));
+        assert(copy.getRegister(R1) == 42);
+        assert(copy.run() == ExecResult::VM_FINISHED);
+        assert(copy.getRegister(R0) == 123);
+        assert(copy.getRegister(IP) == vm.getRegister(IP));
+        assert(copy.memory(copy.getRegister(SP) - 4)[0] == 9);
+    }
+
+    printf("%s\n", "Test: An unhandled interrupt replays as one;");
+    {
+        uint8_t unhandled[] = {
+            OP_INC, R0,
+            OP_INT, 3,
+            OP_HALT};
+        ReplayLog log;
+        VM vm(unhandled, sizeof(unhandled));
+        vm.recordTo(&log);
+        assert(vm.run() == ExecResult::VM_ERR_UNHANDLED_INTERRUPT);
+
+        VM copy(unhandled, sizeof(unhandled));
+        assert(copy.replayFrom(&log));
+        assert(copy.run() == ExecResult::VM_ERR_UNHANDLED_INTERRUPT);
+        assert(copy.getRegister(R0) == 1);
+        assert(log.finished());
     }
 
-    printf("%s\n", "Test: Correct IP;");
+    printf("%s\n", "Test: Replay file claiming more events than it holds;");
     {
-        assert(vm.getRegister(IP) == 1);
+        uint8_t program[] = {
+            OP_HALT};
+        ReplayLog log;
+        VM vm(program, sizeof(program));
+        vm.recordTo(&log);
+        assert(vm.run() == ExecResult::VM_FINISHED);
+
+        FILE *f = tmpfile();
+        assert(log.save(f));
+        assert(log.size() == 0);
+        // the event length ends the header, which the starting memory follows
+        const uint64_t eventsLen = 1ULL << 50;
+        assert(fseek(f, ftell(f) - sizeof(program) - 256 - sizeof(eventsLen), SEEK_SET) == 0);
+        assert(fwrite(&eventsLen, sizeof(eventsLen), 1, f) == 1);
+        rewind(f);
+        ReplayLog loaded;
+        assert(!loaded.load(f));
+        fclose(f);
     }
 }
 
@@ -2416,6 +6191,19 @@ TEST_CASE_OP_AND();
 TEST_CASE_OP_OR();
 TEST_CASE_OP_XOR();
 TEST_CASE_OP_NOT();
+TEST_CASE_OP_ADDI();
+TEST_CASE_OP_SUBI();
+TEST_CASE_OP_MULI();
+TEST_CASE_OP_DIVI();
+TEST_CASE_OP_SHIFTI();
+TEST_CASE_OP_LOGICI();
+TEST_CASE_OP_FLOATI();
+TEST_CASE_OP_BIT_COUNTS();
+TEST_CASE_OP_ROTATE();
+TEST_CASE_OP_BIT_FIELDS();
+TEST_CASE_OP_CMOV();
+TEST_CASE_OP_SELECT();
+TEST_CASE_OP_MIN_MAX();
 TEST_CASE_OP_JMP();
 TEST_CASE_OP_JR();
 TEST_CASE_OP_JZ();
@@ -2430,8 +6218,23 @@ TEST_CASE_OP_JB();
 TEST_CASE_OP_JL();
 TEST_CASE_OP_JBE();
 TEST_CASE_OP_JLE();
+TEST_CASE_OP_JCCI();
+TEST_CASE_OP_DJNZ();
+TEST_CASE_OP_RELATIVE_JUMPS();
+TEST_CASE_OP_SWITCH();
+TEST_CASE_OP_CHECKSUMS();
+TEST_CASE_OP_FMA();
+TEST_CASE_OP_FLOAT_UNARY();
+TEST_CASE_OP_FMIN_FMAX();
+TEST_CASE_OP_FLOAT_ROUNDING();
+TEST_CASE_OP_FLOAT_JUMPS();
 TEST_CASE_OP_F2I();
 TEST_CASE_OP_I2F();
+TEST_CASE_OP_QWORD();
+TEST_CASE_OP_QWORD_MEMORY();
+TEST_CASE_OP_DOUBLE();
+TEST_CASE_OP_WIDE_CONVERSIONS();
+TEST_CASE_OP_PRINTQ();
 TEST_CASE_OP_STOR();
 TEST_CASE_OP_STOR_P();
 TEST_CASE_OP_STORW();
@@ -2446,6 +6249,9 @@ TEST_CASE_OP_LOADB();
 TEST_CASE_OP_LOADB_P();
 TEST_CASE_OP_MEMCPY();
 TEST_CASE_OP_MEMCPY_P();
+TEST_CASE_OP_DISPLACEMENT();
+TEST_CASE_OP_INDEXED();
+TEST_CASE_OP_POST_INCREMENT();
 TEST_CASE_OP_LCONS();
 TEST_CASE_OP_LCONSW();
 TEST_CASE_OP_LCONSB();
@@ -2454,7 +6260,22 @@ TEST_CASE_OP_PUSH();
 TEST_CASE_OP_POP();
 TEST_CASE_OP_POP2();
 TEST_CASE_OP_DUP();
+TEST_CASE_OP_CALLF();
 TEST_CASE_OP_INT();
+TEST_CASE_OP_INT_ASYNC();
+TEST_CASE_IO_REDIRECT();
 TEST_CASE_OP_HALT();
 TEST_CASE_OP_NOP();
+TEST_CASE_BATCH();
+TEST_CASE_PROGRAM_CACHE();
+TEST_CASE_PREEMPTION();
+TEST_CASE_OPCODE_PROFILE();
+TEST_CASE_SAMPLING_PROFILER();
+TEST_CASE_EXECUTION_TRACE();
+TEST_CASE_BLOCK_COVERAGE();
+TEST_CASE_PERF_COUNTERS();
+TEST_CASE_CALL_GRAPH();
+TEST_CASE_MEMORY_HEATMAP();
+TEST_CASE_VM_STATS();
+TEST_CASE_RECORD_REPLAY();
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "trace.h"
+#include "opcodes.h"
+
+struct TraceFileHeader
+{
+    uint32_t magic;
+    uint32_t count;
+    uint64_t executed;
+};
+
+ExecutionTrace::ExecutionTrace(uint32_t capacity)
+{
+    this->allocate(capacity);
+}
+
+ExecutionTrace::~ExecutionTrace()
+{
+    delete[] this->_records;
+}
+
+void ExecutionTrace::allocate(uint32_t capacity)
+{
+    uint32_t size = 1;
+    while (size < capacity && size < 0x80000000U)
+        size <<= 1;
+
+    delete[] this->_records;
+    this->_records = new TraceRecord[size];
+    this->_mask = size - 1;
+    this->clear();
+}
+
+void ExecutionTrace::clear()
+{
+    memset(this->_records, 0, (this->_mask + 1) * sizeof(TraceRecord));
+    this->_head = 0;
+}
+
+uint32_t ExecutionTrace::capacity()
+{
+    return this->_mask + 1;
+}
+
+uint32_t ExecutionTrace::size()
+{
+    return this->_head < this->capacity() ? (uint32_t)this->_head : this->capacity();
+}
+
+uint64_t ExecutionTrace::executed()
+{
+    return this->_head;
+}
+
+TraceRecord ExecutionTrace::at(uint32_t i)
+{
+    return this->_records[(this->_head - this->size() + i) & this->_mask];
+}
+
+bool ExecutionTrace::writeBinary(FILE *out)
+{
+    TraceFileHeader header = {TRACE_MAGIC, this->size(), this->_head};
+    if (fwrite(&header, sizeof(header), 1, out) != 1)
+        return false;
+
+    for (uint32_t i = 0; i < header.count; i++)
+    {
+        const TraceRecord record = this->at(i);
+        if (fwrite(&record, sizeof(record), 1, out) != 1)
+            return false;
+    }
+    return true;
+}
+
+bool ExecutionTrace::readBinary(FILE *in)
+{
+    TraceFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != TRACE_MAGIC || header.count > header.executed)
+        return false;
+
+    // only allocate for the records the file actually holds
+    const long start = ftell(in);
+    if (start < 0 || fseek(in, 0, SEEK_END) != 0)
+        return false;
+    const long end = ftell(in);
+    if (end < start || fseek(in, start, SEEK_SET) != 0 ||
+        (uint64_t)header.count * sizeof(TraceRecord) > (uint64_t)(end - start))
+        return false;
+
+    this->allocate(header.count);
+    this->_head = header.executed;
+    for (uint32_t i = 0; i < header.count; i++)
+    {
+        TraceRecord &record = this->_records[(header.executed - header.count + i) & this->_mask];
+        if (fread(&record, sizeof(record), 1, in) != 1)
+        {
+            this->clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ExecutionTrace::disassemble(FILE *out, const uint8_t *program, uint16_t progLen)
+{
+    char text[64];
+
+    for (uint32_t i = 0; i < this->size(); i++)
+    {
+        const TraceRecord record = this->at(i);
+
+        // code may have been rewritten since, fall back to the recorded opcode
+        const bool decoded = record.ip < progLen && program[record.ip] == record.op &&
+                             ::disassemble(program, progLen, record.ip, text, sizeof(text)) != 0;
+        if (!decoded)
+            snprintf(text, sizeof(text), "%s ?", record.op < INSTRUCTION_COUNT ? OP_INFO[record.op].name : ".byte");
+
+        fprintf(out, "%06llu  0x%04x  %-28s", (unsigned long long)(this->_head - this->size() + i), record.ip, text);
+        if (!record.retired)
+            fprintf(out, "  <- stopped");
+        else if (decoded && OP_INFO[record.op].operands[0] == 'r')
+            fprintf(out, "  %s=0x%08x", registerName(program[record.ip + 1]), record.value);
+        fprintf(out, "\n");
+    }
+}
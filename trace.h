@@ -0,0 +1,69 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "vm.h"
+
+#define TRACE_MAGIC 0x5254424D // "MBTR"
+
+// One executed instruction. The layout is fixed so that a ring can be dumped
+// to disk as is.
+struct TraceRecord
+{
+    uint16_t ip;
+    uint8_t op;
+    uint8_t retired; // 0 when the instruction stopped the VM: an error, halt or wait
+    uint32_t value;  // the first register operand after the instruction, when it has one
+};
+
+static_assert(sizeof(TraceRecord) == 8, "TraceRecord must stay 8 bytes");
+
+// Ring buffer of the last executed instructions of a VM. Recording is a fixed
+// store with a masked index and no branches, cheap enough to keep attached in
+// production and dump when a run returns an error.
+class ExecutionTrace
+{
+  public:
+    // capacity is rounded up to a power of two
+    ExecutionTrace(uint32_t capacity = 1024);
+    ~ExecutionTrace();
+
+    inline void dispatch(uint16_t ip, uint8_t op)
+    {
+        TraceRecord &record = this->_records[this->_head & this->_mask];
+        record.ip = ip;
+        record.op = op;
+        record.retired = 0;
+        record.value = 0;
+        this->_head++;
+    }
+
+    inline void retire(uint32_t value)
+    {
+        TraceRecord &record = this->_records[(this->_head - 1) & this->_mask];
+        record.retired = 1;
+        record.value = value;
+    }
+
+    void clear();
+    uint32_t capacity();
+    // records held, at most capacity
+    uint32_t size();
+    // instructions dispatched since the last clear
+    uint64_t executed();
+    // oldest record first
+    TraceRecord at(uint32_t i);
+
+    bool writeBinary(FILE *out);
+    bool readBinary(FILE *in);
+    // one line per record, decoded against the program the trace was taken from
+    void disassemble(FILE *out, const uint8_t *program, uint16_t progLen);
+
+  protected:
+    void allocate(uint32_t capacity);
+
+    TraceRecord *_records = nullptr;
+    uint32_t _mask = 0;
+    uint64_t _head = 0;
+};
+
+#endif // __TRACE_H__
@@ -0,0 +1,48 @@
+#include "trace.h"
+
+#include <vector>
+
+// Decoder for trace dumps written by ExecutionTrace::writeBinary: prints the
+// recorded instructions as disassembly of the program they were taken from.
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        printf("Usage: %s trace_file bin_file\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[2], "rb");
+    if (f == nullptr)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    std::vector<uint8_t> program;
+    fseek(f, 0, SEEK_END);
+    program.resize(ftell(f));
+    rewind(f);
+    if (fread(program.data(), 1, program.size(), f) != program.size())
+        program.clear();
+    fclose(f);
+
+    f = fopen(argv[1], "rb");
+    if (f == nullptr)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    ExecutionTrace trace;
+    const bool loaded = trace.readBinary(f);
+    fclose(f);
+    if (!loaded)
+    {
+        fprintf(stderr, "%s: not a trace file\n", argv[1]);
+        return 1;
+    }
+
+    printf("%llu instructions executed, last %u:\n", (unsigned long long)trace.executed(), trace.size());
+    trace.disassemble(stdout, program.data(), program.size());
+    return 0;
+}
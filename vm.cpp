@@ -1,4 +1,15 @@
 #include "vm.h"
+#include "opprofile.h"
+#include "sampler.h"
+#include "trace.h"
+#include "coverage.h"
+#include "callgraph.h"
+#include "heatmap.h"
+#include "replay.h"
+#include "checksum.h"
+
+#include <math.h>
+#include <time.h>
 
 #define _NEXT_BYTE this->_memory[++this->_registers[IP]]
 #define _NEXT_SHORT ({ this->_registers[IP] += 2; this->_memory[this->_registers[IP]-1]\
@@ -9,6 +20,29 @@
         this->_memory[this->_registers[IP] - 1] << 16 | this->_memory[this->_registers[IP]] << 24; \
 })
 
+#define _PRINTED(n)                         \
+    {                                       \
+        const int printed = (n);            \
+        if (printed > 0)                    \
+            this->_bytesPrinted += printed; \
+    }
+
+// takes the value from the replay log, or reads it from the host and records it
+#define _INPUT_VALUE(dest, read)                                       \
+    {                                                                  \
+        uint32_t consumed = 0;                                         \
+        if (this->_replayer != nullptr)                                \
+        {                                                              \
+            if (!this->_replayer->nextValue(&(dest), &consumed))       \
+                return ExecResult::VM_ERR_REPLAY_DIVERGED;             \
+        }                                                              \
+        else                                                           \
+            consumed = (read);                                         \
+        if (this->_recorder != nullptr)                                \
+            this->_recorder->value(dest, consumed);                    \
+        this->_bytesRead += consumed;                                  \
+    }
+
 #ifndef VM_DISABLE_CHECKS
 #define _CHECK_ADDR_VALID(a) \
     if (a >= this->_memSize) \
@@ -18,26 +52,135 @@
 #define _CHECK_REGISTER_VALID(r) \
     if (r >= REGISTER_COUNT)     \
         return ExecResult::VM_ERR_INVALID_REGISTER;
-#define _CHECK_CAN_PUSH(n)                                              \
-    if (this->_registers[SP] - (n * sizeof(uint32_t)) < this->_progLen) \
-        return ExecResult::VM_ERR_STACK_OVERFLOW;
+// the push checks compare against the lowest SP reached so far, so the stack peak
+// is tracked by the same compare, and only a new low also checks for overflow
+#define _CHECK_CAN_PUSH(n)                                                   \
+    if (this->_registers[SP] - (n * sizeof(uint32_t)) < this->_lowestSp)     \
+    {                                                                        \
+        if (this->_registers[SP] - (n * sizeof(uint32_t)) < this->_progLen)  \
+            return ExecResult::VM_ERR_STACK_OVERFLOW;                        \
+        this->_lowestSp = this->_registers[SP] - (n * sizeof(uint32_t));     \
+    }
 #define _CHECK_CAN_POP(n)                                               \
     if (this->_registers[SP] + (n * sizeof(uint32_t)) > this->_memSize) \
         return ExecResult::VM_ERR_STACK_UNDERFLOW;                      \
     if (this->_registers[SP] < this->_progLen)                          \
         return ExecResult::VM_ERR_STACK_OVERFLOW;
+#define _CHECK_CAN_RESERVE(n)                           \
+    if (this->_registers[SP] < this->_lowestSp + n)     \
+    {                                                   \
+        if (this->_registers[SP] < this->_progLen + n)  \
+            return ExecResult::VM_ERR_STACK_OVERFLOW;   \
+        this->_lowestSp = this->_registers[SP] - n;     \
+    }
+#define _CHECK_PAIR_VALID(r) \
+    if (r >= T9)             \
+        return ExecResult::VM_ERR_INVALID_REGISTER;
+// an instruction with an unknown condition code is as invalid as an unknown opcode
+#define _CHECK_CONDITION_VALID(c) \
+    if (c >= CONDITION_COUNT)     \
+        return ExecResult::VM_ERR_UNKNOWN_OPCODE;
+// one check for the whole range of bytes starting at a, an empty range is always valid
+#define _CHECK_RANGE_VALID(a, bytes)                                \
+    if (bytes > 0 && (uint32_t)a + bytes - 1 >= this->_memSize) \
+        return ExecResult::VM_ERR_INVALID_ADDRESS;
 #else
 #define _CHECK_ADDR_VALID(a)
 #define _CHECK_BYTES_AVAIL(n)
 #define _CHECK_REGISTER_VALID(r)
 #define _CHECK_CAN_PUSH(n)
 #define _CHECK_CAN_POP(n)
+#define _CHECK_CAN_RESERVE(n)
+#define _CHECK_PAIR_VALID(r)
+#define _CHECK_CONDITION_VALID(c)
+#define _CHECK_RANGE_VALID(a, bytes)
 #endif
 
+// 64-bit values live in a register pair, the low half in r and the high half in r + 1
+#define _QWORD(r) ({ uint64_t value; memcpy(&value, &this->_registers[r], sizeof(value)); value; })
+#define _DOUBLE(r) ({ double value; memcpy(&value, &this->_registers[r], sizeof(value)); value; })
+#define _SET_QWORD(r, v)                                              \
+    {                                                                 \
+        const uint64_t value = (v);                                   \
+        memcpy(&this->_registers[r], &value, sizeof(value));          \
+    }
+#define _SET_DOUBLE(r, v)                                             \
+    {                                                                 \
+        const double value = (v);                                     \
+        memcpy(&this->_registers[r], &value, sizeof(value));          \
+    }
+
+// bits [start, start + len) of a register, clipped to its 32 bits
+static inline uint32_t fieldMask(uint8_t start, uint8_t len)
+{
+    if (start >= 32 || len == 0)
+        return 0;
+    return (len >= 32 ? UINT32_MAX : (1U << len) - 1) << start;
+}
+
+// a cc b for the conditional moves and selects
+static inline bool testCondition(uint8_t cc, uint32_t a, uint32_t b)
+{
+    float fa, fb;
+    memcpy(&fa, &a, sizeof(fa));
+    memcpy(&fb, &b, sizeof(fb));
+    switch (cc)
+    {
+    case COND_E:
+        return a == b;
+    case COND_NE:
+        return a != b;
+    case COND_A:
+        return a > b;
+    case COND_G:
+        return (int32_t)a > (int32_t)b;
+    case COND_AE:
+        return a >= b;
+    case COND_GE:
+        return (int32_t)a >= (int32_t)b;
+    case COND_B:
+        return a < b;
+    case COND_L:
+        return (int32_t)a < (int32_t)b;
+    case COND_BE:
+        return a <= b;
+    case COND_LE:
+        return (int32_t)a <= (int32_t)b;
+    case COND_FE:
+        return fa == fb;
+    case COND_FNE:
+        return fa != fb;
+    case COND_FG:
+        return fa > fb;
+    case COND_FGE:
+        return fa >= fb;
+    case COND_FL:
+        return fa < fb;
+    case COND_FLE:
+        return fa <= fb;
+    }
+    return false;
+}
+
+// fscanf of a single value, returning the number of characters it consumed
+static uint32_t scanValue(FILE *in, const char *format, void *dest)
+{
+    int consumed = 0;
+    fscanf(in, format, dest, &consumed);
+    return consumed;
+}
+
+static uint32_t readChar(FILE *in, uint32_t *dest)
+{
+    *dest = fgetc(in);
+    return *dest != (uint32_t)EOF;
+}
+
 VM::VM(uint8_t *program, uint16_t progLen, uint16_t stackSize)
     : _memory(new uint8_t[progLen + stackSize]), _memSize(progLen + stackSize), _progLen(progLen), _stackSize(stackSize), FSIG(false), RSIG(0)
 {
     memcpy(this->_memory, program, progLen);
+    this->_lowestSp = this->_memSize;
     this->reset();
 }
 
@@ -50,9 +193,14 @@ void VM::reset()
 {
     this->FSIG = false;
     this->RSIG = 0;
+    this->_waiting = false;
+    this->_pendingToken = 0;
+    this->_interrupted.store(false, std::memory_order_relaxed);
     memset(&this->_memory[this->_progLen], 0, this->_stackSize);
     memset(this->_registers, 0, REGISTER_COUNT * sizeof(uint32_t));
     this->_registers[SP] = this->_progLen + this->_stackSize;
+    // the entry's frame is empty, LEAVE there leaves the stack empty
+    this->_registers[BP] = this->_registers[SP];
 }
 
 void VM::onInterrupt(bool (*callback)(uint8_t))
@@ -60,6 +208,41 @@ void VM::onInterrupt(bool (*callback)(uint8_t))
     this->_interruptCallback = callback;
 }
 
+void VM::setOutput(FILE *out)
+{
+    this->_out = out;
+}
+
+void VM::setInput(FILE *in)
+{
+    this->_in = in;
+}
+
+void VM::onInterruptAsync(InterruptResult (*callback)(VM *, uint8_t, uint32_t *))
+{
+    this->_asyncCallback = callback;
+}
+
+bool VM::waiting()
+{
+    return this->_waiting;
+}
+
+uint32_t VM::pendingToken()
+{
+    return this->_pendingToken;
+}
+
+bool VM::resume(uint32_t token)
+{
+    if (!this->_waiting || token != this->_pendingToken)
+        return false;
+    this->_waiting = false;
+    if (this->_recorder != nullptr)
+        this->_recorder->state(this->_registers, this->_memory);
+    return true;
+}
+
 uint32_t VM::stackCount()
 {
     return this->_progLen + this->_stackSize - this->_registers[SP];
@@ -94,6 +277,17 @@ void VM::setRegister(Register reg, uint32_t val)
     this->_registers[reg] = val;
 }
 
+uint64_t VM::getRegister64(Register reg)
+{
+    return (uint64_t)this->_registers[reg + 1] << 32 | this->_registers[reg];
+}
+
+void VM::setRegister64(Register reg, uint64_t val)
+{
+    this->_registers[reg] = (uint32_t)val;
+    this->_registers[reg + 1] = (uint32_t)(val >> 32);
+}
+
 int VM::getRegisterSig()
 {
     int temp = this->RSIG;
@@ -113,16 +307,243 @@ void VM::setFlagSig(bool val)
     this->FSIG = val;
 }
 
+// Compile-time execution policy for VM::_run. Preemptible runs sample the
+// interrupt flag and the clock; instrumented runs call the hooks of attached
+// profilers around every instruction. run() picks the plain instantiation
+// when nothing is attached, so neither costs anything when unused.
+template <bool Preempt, bool Instrument>
+struct RunPolicy
+{
+    static const bool preempt = Preempt;
+    static const bool instrument = Instrument;
+};
+
+// adds the instructions a run retired to the VM's total on every way out of _run
+struct RetiredCount
+{
+    uint64_t &total;
+    const uint32_t &count;
+    ~RetiredCount() { total += count; }
+};
+
+// the instruction a run ends on (halt, a fault, a finishing or pending interrupt)
+// returns from inside the switch without retiring; the profile still counts it
+struct EndingInstruction
+{
+    OpcodeProfile *profile;
+    uint8_t instr;
+    uint64_t begin;
+    ~EndingInstruction()
+    {
+        if (profile != nullptr && instr < INSTRUCTION_COUNT)
+            profile->record(instr, begin != 0 ? cycleCounter() - begin : 0);
+    }
+};
+
+uint64_t VM::retired()
+{
+    return this->_retired;
+}
+
+const VMStats &VM::stats()
+{
+    return this->_stats;
+}
+
+void VM::_publish(ExecResult result, uint64_t retired)
+{
+    uint64_t deltas[STAT_COUNT] = {0};
+    deltas[STAT_INSTRUCTIONS] = this->_retired - retired;
+    deltas[STAT_RUNS] = 1;
+    deltas[STAT_INTERRUPTS] = this->_interrupts;
+    deltas[STAT_BYTES_PRINTED] = this->_bytesPrinted;
+    deltas[STAT_BYTES_READ] = this->_bytesRead;
+    deltas[STAT_PEAK_STACK] = this->_memSize - this->_lowestSp;
+    deltas[STAT_RESULTS + result] = 1;
+    this->_interrupts = 0;
+    this->_bytesPrinted = 0;
+    this->_bytesRead = 0;
+
+    this->_stats.add(deltas);
+    VMStats::local().add(deltas);
+}
+
+uint64_t VM::clock()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void VM::interrupt()
+{
+    this->_interrupted.store(true, std::memory_order_relaxed);
+}
+
+void VM::attachProfile(OpcodeProfile *profile)
+{
+    this->_profile = profile;
+}
+
+void VM::attachSampler(SamplingProfiler *sampler)
+{
+    this->_sampler = sampler;
+}
+
+void VM::attachTrace(ExecutionTrace *trace)
+{
+    this->_trace = trace;
+}
+
+void VM::attachCoverage(BlockCoverage *coverage)
+{
+    this->_coverage = coverage;
+}
+
+void VM::attachCallGraph(CallGraphProfiler *callgraph)
+{
+    this->_callgraph = callgraph;
+}
+
+void VM::attachHeatmap(MemoryHeatmap *heatmap)
+{
+    this->_heatmap = heatmap;
+}
+
+void VM::recordTo(ReplayLog *log)
+{
+    this->_recorder = log;
+    if (log != nullptr)
+        log->begin(this->_registers, this->FSIG, this->RSIG, this->_memory, this->_progLen, this->_stackSize);
+}
+
+bool VM::replayFrom(ReplayLog *log)
+{
+    if (log != nullptr &&
+        !log->restore(this->_registers, &this->FSIG, &this->RSIG, this->_memory, this->_progLen, this->_stackSize))
+        return false;
+    this->_replayer = log;
+    this->_waiting = false;
+    return true;
+}
+
+inline bool VM::_instrumented()
+{
+    return this->_profile != nullptr || this->_sampler != nullptr || this->_trace != nullptr ||
+           this->_coverage != nullptr || this->_callgraph != nullptr || this->_heatmap != nullptr;
+}
+
+// whether any attachment needs the cycles each instruction took
+inline bool VM::_timed()
+{
+    return this->_profile != nullptr || this->_callgraph != nullptr;
+}
+
+inline void VM::_dispatch(uint16_t ip, uint8_t instr)
+{
+    if (this->_trace != nullptr)
+        this->_trace->dispatch(ip, instr);
+    if (this->_coverage != nullptr)
+        this->_coverage->enter(ip);
+}
+
+inline void VM::_retire(uint16_t ip, uint8_t instr, uint64_t begin)
+{
+    const uint64_t cycles = this->_timed() ? cycleCounter() - begin : 0;
+    if (this->_profile != nullptr)
+        this->_profile->record(instr, cycles);
+    if (this->_callgraph != nullptr)
+        this->_callgraph->retire(ip, OP_INFO[instr].flags, this->_registers[IP], cycles);
+    if (this->_heatmap != nullptr)
+        this->_heatmap->retire(this->_registers[SP]);
+    if (this->_trace != nullptr)
+    {
+        // the operand byte is only a register for some opcodes, clamp instead of branching
+        const uint8_t reg = this->_memory[ip + 1 < this->_memSize ? ip + 1 : ip];
+        this->_trace->retire(this->_registers[reg < REGISTER_COUNT ? reg : IP]);
+    }
+}
+
+inline void VM::_call(uint16_t target)
+{
+    if (this->_sampler != nullptr)
+        this->_sampler->push(target);
+}
+
+inline void VM::_return()
+{
+    if (this->_sampler != nullptr)
+        this->_sampler->pop();
+}
+
+inline void VM::_read(uint32_t addr, uint32_t len)
+{
+    if (this->_heatmap != nullptr)
+        this->_heatmap->read(addr, len);
+}
+
+inline void VM::_write(uint32_t addr, uint32_t len)
+{
+    if (this->_heatmap != nullptr)
+        this->_heatmap->write(addr, len);
+}
+
 ExecResult VM::run(uint32_t maxInstr)
+{
+    const uint64_t retired = this->_retired;
+    const ExecResult result = this->_instrumented() ? this->_run<RunPolicy<false, true>>(maxInstr)
+                                                    : this->_run<RunPolicy<false, false>>(maxInstr);
+    // run() never checks the flag, a request made before or during it must
+    // not stop a later runUntil() at its first back-edge
+    this->_interrupted.store(false, std::memory_order_relaxed);
+    this->_publish(result, retired);
+    return result;
+}
+
+ExecResult VM::_runUnpublished(uint32_t maxInstr)
+{
+    return this->_run<RunPolicy<false, false>>(maxInstr);
+}
+
+ExecResult VM::runUntil(uint64_t deadline, uint32_t maxInstr)
+{
+    const uint64_t retired = this->_retired;
+    this->_deadline = deadline;
+    const ExecResult result = this->_instrumented() ? this->_run<RunPolicy<true, true>>(maxInstr)
+                                                    : this->_run<RunPolicy<true, false>>(maxInstr);
+    this->_publish(result, retired);
+    return result;
+}
+
+ExecResult VM::runFor(uint64_t nanos, uint32_t maxInstr)
+{
+    return this->runUntil(VM::clock() + nanos, maxInstr);
+}
+
+template <class Policy>
+ExecResult VM::_run(uint32_t maxInstr)
 {
     uint32_t instrCount = 0;
+    RetiredCount retired = {this->_retired, instrCount};
+    EndingInstruction ending = {Policy::instrument ? this->_profile : nullptr, INSTRUCTION_COUNT, 0};
+
+    if (this->_waiting)
+        return ExecResult::VM_WAITING;
 
     while (maxInstr == 0 || instrCount < maxInstr)
     {
+        const uint32_t start = this->_registers[IP];
         _CHECK_ADDR_VALID(this->_registers[IP])
         const uint8_t instr = this->_memory[this->_registers[IP]];
         if (instr >= INSTRUCTION_COUNT)
             return ExecResult::VM_ERR_UNKNOWN_OPCODE;
+        const uint64_t begin = Policy::instrument && this->_timed() ? cycleCounter() : 0;
+        if (Policy::instrument)
+        {
+            this->_dispatch(start, instr);
+            ending.instr = instr;
+            ending.begin = begin;
+        }
 
         switch (instr)
         {
@@ -139,9 +560,61 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_BYTES_AVAIL(1)
             const uint8_t code = _NEXT_BYTE;
 
+            if (this->_replayer != nullptr)
+            {
+                if (this->_replayer->nextUnhandled(code))
+                    return ExecResult::VM_ERR_UNHANDLED_INTERRUPT;
+                // a pending interrupt completes at once, in the state it was resumed with
+                InterruptResult result;
+                if (!this->_replayer->nextInterrupt(code, &result) ||
+                    !this->_replayer->nextState(this->_registers, this->_memory))
+                    return ExecResult::VM_ERR_REPLAY_DIVERGED;
+                this->_interrupts++;
+                if (result == INT_FINISH)
+                    return ExecResult::VM_FINISHED;
+                break;
+            }
+            if (this->_recorder != nullptr)
+                this->_recorder->snapshot(this->_registers, this->_memory);
+
+            if (this->_asyncCallback != nullptr)
+            {
+                uint32_t token = 0;
+                this->_interrupts++;
+                const InterruptResult result = this->_asyncCallback(this, code, &token);
+                if (this->_recorder != nullptr)
+                {
+                    this->_recorder->interrupt(code, result);
+                    // a pending interrupt is logged with the state resume() finds
+                    if (result != INT_PENDING)
+                        this->_recorder->state(this->_registers, this->_memory);
+                }
+                if (result == INT_FINISH)
+                    return ExecResult::VM_FINISHED;
+                if (result == INT_PENDING)
+                {
+                    // resume at the next instruction once the host completes the token
+                    this->_registers[IP]++;
+                    this->_pendingToken = token;
+                    this->_waiting = true;
+                    return ExecResult::VM_WAITING;
+                }
+                break;
+            }
             if (this->_interruptCallback == nullptr)
+            {
+                if (this->_recorder != nullptr)
+                    this->_recorder->unhandled(code);
                 return ExecResult::VM_ERR_UNHANDLED_INTERRUPT;
-            if (!this->_interruptCallback(code))
+            }
+            this->_interrupts++;
+            const bool proceed = this->_interruptCallback(code);
+            if (this->_recorder != nullptr)
+            {
+                this->_recorder->interrupt(code, proceed ? INT_CONTINUE : INT_FINISH);
+                this->_recorder->state(this->_registers, this->_memory);
+            }
+            if (!proceed)
                 return ExecResult::VM_FINISHED;
             break;
         }
@@ -187,6 +660,8 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_CAN_PUSH(1)
             this->_registers[SP] -= 4;
             memcpy(&this->_memory[this->_registers[SP]], &this->_registers[reg], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_write(this->_registers[SP], 4);
             break;
         }
         case OP_POP:
@@ -197,6 +672,8 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_CAN_POP(1)
             memcpy(&this->_registers[reg], &this->_memory[this->_registers[SP]], sizeof(uint32_t));
             this->_registers[SP] += 4;
+            if (Policy::instrument)
+                this->_read(this->_registers[SP] - 4, 4);
             break;
         }
         case OP_POP2:
@@ -211,6 +688,8 @@ ExecResult VM::run(uint32_t maxInstr)
             this->_registers[SP] += 4;
             memcpy(&this->_registers[reg2], &this->_memory[this->_registers[SP]], sizeof(uint32_t));
             this->_registers[SP] += 4;
+            if (Policy::instrument)
+                this->_read(this->_registers[SP] - 8, 8);
             break;
         }
         case OP_DUP:
@@ -218,6 +697,11 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_CAN_PUSH(1)
             this->_registers[SP] -= 4;
             memcpy(&this->_memory[this->_registers[SP]], &this->_memory[this->_registers[SP]] + 4, sizeof(uint32_t));
+            if (Policy::instrument)
+            {
+                this->_read(this->_registers[SP] + 4, 4);
+                this->_write(this->_registers[SP], 4);
+            }
             break;
         }
         case OP_CALL:
@@ -225,159 +709,413 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_BYTES_AVAIL(2)
             this->_registers[RA] = this->_registers[IP] + 3;
             this->_registers[IP] = _NEXT_SHORT - 1;
+            if (Policy::instrument)
+                this->_call(this->_registers[IP] + 1);
             break;
         }
         case OP_RET:
         {
             this->_registers[IP] = this->_registers[RA] - 1;
+            if (Policy::instrument)
+                this->_return();
             break;
         }
-        case OP_STOR:
-        {
-            _CHECK_BYTES_AVAIL(3)
-            const uint16_t addr = _NEXT_SHORT;
-            const uint8_t reg = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg)
-            _CHECK_ADDR_VALID((uint32_t)addr + 3)
-            memcpy(&this->_memory[addr], &this->_registers[reg], sizeof(uint32_t));
-            break;
-        }
-        case OP_STOR_P:
+        case OP_CALLF:
         {
             _CHECK_BYTES_AVAIL(2)
-            const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            const uint16_t dest = this->_registers[reg1];
-            _CHECK_ADDR_VALID((uint32_t)dest + 3)
-            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint32_t));
+            _CHECK_CAN_PUSH(2)
+            const uint32_t frame[2] = {this->_registers[BP], this->_registers[IP] + 3};
+            this->_registers[SP] -= 8;
+            memcpy(&this->_memory[this->_registers[SP]], frame, sizeof(frame));
+            this->_registers[BP] = this->_registers[SP];
+            this->_registers[IP] = _NEXT_SHORT - 1;
+            if (Policy::instrument)
+            {
+                this->_write(this->_registers[SP], 8);
+                this->_call(this->_registers[IP] + 1);
+            }
             break;
         }
-        case OP_STORW:
+        case OP_RETF:
         {
-            _CHECK_BYTES_AVAIL(3)
-            const uint16_t addr = _NEXT_SHORT;
-            const uint8_t reg = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg)
-            _CHECK_ADDR_VALID((uint32_t)addr + 1)
-            memcpy(&this->_memory[addr], &this->_registers[reg], sizeof(uint16_t));
+            _CHECK_CAN_POP(2)
+            uint32_t frame[2];
+            memcpy(frame, &this->_memory[this->_registers[SP]], sizeof(frame));
+            this->_registers[SP] += 8;
+            this->_registers[BP] = frame[0];
+            this->_registers[IP] = frame[1] - 1;
+            if (Policy::instrument)
+            {
+                this->_read(this->_registers[SP] - 8, 8);
+                this->_return();
+            }
             break;
         }
-        case OP_STORW_P:
+        case OP_ENTER:
         {
             _CHECK_BYTES_AVAIL(2)
-            const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            const uint16_t dest = this->_registers[reg1];
-            _CHECK_ADDR_VALID((uint32_t)dest + 1)
-            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint16_t));
+            const uint16_t size = _NEXT_SHORT;
+            // one check for the whole frame
+            _CHECK_CAN_RESERVE((uint32_t)size)
+            this->_registers[SP] -= size;
             break;
         }
-        case OP_STORB:
+        case OP_LEAVE:
         {
-            _CHECK_BYTES_AVAIL(3)
-            const uint16_t addr = _NEXT_SHORT;
-            const uint8_t reg = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg)
-            _CHECK_ADDR_VALID(addr)
-            memcpy(&this->_memory[addr], &this->_registers[reg], sizeof(uint8_t));
+            this->_registers[SP] = this->_registers[BP];
             break;
         }
-        case OP_STORB_P:
+        case OP_TAILCALL:
         {
             _CHECK_BYTES_AVAIL(2)
-            const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            const uint16_t dest = this->_registers[reg1];
-            _CHECK_ADDR_VALID((uint32_t)dest)
-            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint8_t));
-            break;
-        }
-        case OP_LOAD:
-        {
-            _CHECK_BYTES_AVAIL(3)
-            const uint8_t reg = _NEXT_BYTE;
-            const uint16_t addr = _NEXT_SHORT;
-            _CHECK_REGISTER_VALID(reg)
-            _CHECK_ADDR_VALID((uint32_t)addr + 3)
-            memcpy(&this->_registers[reg], &this->_memory[addr], sizeof(uint32_t));
+            this->_registers[SP] = this->_registers[BP];
+            this->_registers[IP] = _NEXT_SHORT - 1;
+            if (Policy::instrument)
+            {
+                this->_return();
+                this->_call(this->_registers[IP] + 1);
+            }
             break;
         }
-        case OP_LOAD_P:
+        case OP_LOAD_D:
         {
-            _CHECK_BYTES_AVAIL(2)
+            _CHECK_BYTES_AVAIL(4)
             const uint8_t reg1 = _NEXT_BYTE;
             const uint8_t reg2 = _NEXT_BYTE;
+            const int16_t disp = (int16_t)_NEXT_SHORT;
             _CHECK_REGISTER_VALID(reg1)
             _CHECK_REGISTER_VALID(reg2)
-            const uint16_t src = this->_registers[reg2];
+            const uint16_t src = this->_registers[reg2] + disp;
             _CHECK_ADDR_VALID((uint32_t)src + 3)
             memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_read(src, 4);
             break;
         }
-        case OP_LOADW:
-        {
-            _CHECK_BYTES_AVAIL(3)
-            const uint8_t reg = _NEXT_BYTE;
-            const uint16_t addr = _NEXT_SHORT;
-            _CHECK_REGISTER_VALID(reg)
-            _CHECK_ADDR_VALID((uint32_t)addr + 1)
-            this->_registers[reg] = 0;
-            memcpy(&this->_registers[reg], &this->_memory[addr], sizeof(uint16_t));
-            break;
-        }
-        case OP_LOADW_P:
+        case OP_LOADW_D:
         {
-            _CHECK_BYTES_AVAIL(2)
+            _CHECK_BYTES_AVAIL(4)
             const uint8_t reg1 = _NEXT_BYTE;
             const uint8_t reg2 = _NEXT_BYTE;
+            const int16_t disp = (int16_t)_NEXT_SHORT;
             _CHECK_REGISTER_VALID(reg1)
             _CHECK_REGISTER_VALID(reg2)
-            const uint16_t src = this->_registers[reg2];
+            const uint16_t src = this->_registers[reg2] + disp;
             _CHECK_ADDR_VALID((uint32_t)src + 1)
             this->_registers[reg1] = 0;
             memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_read(src, 2);
             break;
         }
-        case OP_LOADB:
-        {
-            _CHECK_BYTES_AVAIL(3)
-            const uint8_t reg = _NEXT_BYTE;
-            const uint16_t addr = _NEXT_SHORT;
-            _CHECK_REGISTER_VALID(reg)
-            _CHECK_ADDR_VALID((uint32_t)addr)
-            this->_registers[reg] = this->_memory[addr];
-            break;
-        }
-        case OP_LOADB_P:
+        case OP_LOADB_D:
         {
-            _CHECK_BYTES_AVAIL(2)
+            _CHECK_BYTES_AVAIL(4)
             const uint8_t reg1 = _NEXT_BYTE;
             const uint8_t reg2 = _NEXT_BYTE;
+            const int16_t disp = (int16_t)_NEXT_SHORT;
             _CHECK_REGISTER_VALID(reg1)
             _CHECK_REGISTER_VALID(reg2)
-            const uint16_t src = this->_registers[reg2];
+            const uint16_t src = this->_registers[reg2] + disp;
             _CHECK_ADDR_VALID((uint32_t)src)
             this->_registers[reg1] = this->_memory[src];
+            if (Policy::instrument)
+                this->_read(src, 1);
             break;
         }
-        case OP_MEMCPY:
+        case OP_STOR_D:
         {
-            _CHECK_BYTES_AVAIL(6)
-            const uint16_t dest = _NEXT_SHORT;
-            const uint16_t source = _NEXT_SHORT;
-            const uint16_t bytes = _NEXT_SHORT;
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const int16_t disp = (int16_t)_NEXT_SHORT;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1] + disp;
+            _CHECK_ADDR_VALID((uint32_t)dest + 3)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_write(dest, 4);
+            break;
+        }
+        case OP_STORW_D:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const int16_t disp = (int16_t)_NEXT_SHORT;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1] + disp;
+            _CHECK_ADDR_VALID((uint32_t)dest + 1)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_write(dest, 2);
+            break;
+        }
+        case OP_STORB_D:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const int16_t disp = (int16_t)_NEXT_SHORT;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1] + disp;
+            _CHECK_ADDR_VALID((uint32_t)dest)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint8_t));
+            if (Policy::instrument)
+                this->_write(dest, 1);
+            break;
+        }
+        case OP_LOAD_X:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            const uint8_t scale = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_REGISTER_VALID(reg3)
+            const uint16_t src = this->_registers[reg2] + this->_registers[reg3] * scale;
+            _CHECK_ADDR_VALID((uint32_t)src + 3)
+            memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_read(src, 4);
+            break;
+        }
+        case OP_LOADW_X:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            const uint8_t scale = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_REGISTER_VALID(reg3)
+            const uint16_t src = this->_registers[reg2] + this->_registers[reg3] * scale;
+            _CHECK_ADDR_VALID((uint32_t)src + 1)
+            this->_registers[reg1] = 0;
+            memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_read(src, 2);
+            break;
+        }
+        case OP_LOADB_X:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            const uint8_t scale = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_REGISTER_VALID(reg3)
+            const uint16_t src = this->_registers[reg2] + this->_registers[reg3] * scale;
+            _CHECK_ADDR_VALID((uint32_t)src)
+            this->_registers[reg1] = this->_memory[src];
+            if (Policy::instrument)
+                this->_read(src, 1);
+            break;
+        }
+        case OP_STOR_X:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            const uint8_t scale = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg3)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1] + this->_registers[reg3] * scale;
+            _CHECK_ADDR_VALID((uint32_t)dest + 3)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_write(dest, 4);
+            break;
+        }
+        case OP_STORW_X:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            const uint8_t scale = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg3)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1] + this->_registers[reg3] * scale;
+            _CHECK_ADDR_VALID((uint32_t)dest + 1)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_write(dest, 2);
+            break;
+        }
+        case OP_STORB_X:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            const uint8_t scale = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg3)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1] + this->_registers[reg3] * scale;
+            _CHECK_ADDR_VALID((uint32_t)dest)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint8_t));
+            if (Policy::instrument)
+                this->_write(dest, 1);
+            break;
+        }
+        case OP_LOAD_PI:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t src = this->_registers[reg2];
+            _CHECK_ADDR_VALID((uint32_t)src + 3)
+            // the pointer first, so that a load into it wins
+            this->_registers[reg2] += 4;
+            memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_read(src, 4);
+            break;
+        }
+        case OP_LOADW_PI:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t src = this->_registers[reg2];
+            _CHECK_ADDR_VALID((uint32_t)src + 1)
+            // the pointer first, so that a load into it wins
+            this->_registers[reg2] += 2;
+            this->_registers[reg1] = 0;
+            memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_read(src, 2);
+            break;
+        }
+        case OP_LOADB_PI:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t src = this->_registers[reg2];
+            _CHECK_ADDR_VALID((uint32_t)src)
+            // the pointer first, so that a load into it wins
+            this->_registers[reg2] += 1;
+            this->_registers[reg1] = this->_memory[src];
+            if (Policy::instrument)
+                this->_read(src, 1);
+            break;
+        }
+        case OP_STOR_PI:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1];
+            _CHECK_ADDR_VALID((uint32_t)dest + 3)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint32_t));
+            this->_registers[reg1] += 4;
+            if (Policy::instrument)
+                this->_write(dest, 4);
+            break;
+        }
+        case OP_STORW_PI:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1];
+            _CHECK_ADDR_VALID((uint32_t)dest + 1)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint16_t));
+            this->_registers[reg1] += 2;
+            if (Policy::instrument)
+                this->_write(dest, 2);
+            break;
+        }
+        case OP_STORB_PI:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1];
+            _CHECK_ADDR_VALID((uint32_t)dest)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint8_t));
+            this->_registers[reg1] += 1;
+            if (Policy::instrument)
+                this->_write(dest, 1);
+            break;
+        }
+        case OP_MEMCPY_D:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const int16_t destDisp = (int16_t)_NEXT_SHORT;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const int16_t sourceDisp = (int16_t)_NEXT_SHORT;
+            const uint8_t reg3 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_REGISTER_VALID(reg3)
+            const uint16_t dest = this->_registers[reg1] + destDisp;
+            const uint16_t source = this->_registers[reg2] + sourceDisp;
+            const uint16_t bytes = this->_registers[reg3];
             _CHECK_ADDR_VALID((uint32_t)source + bytes - 1)
             _CHECK_ADDR_VALID((uint32_t)dest + bytes - 1)
-            memcpy(&this->_memory[dest], &this->_memory[source], bytes);
+            memmove(&this->_memory[dest], &this->_memory[source], bytes);
+            if (Policy::instrument)
+            {
+                this->_read(source, bytes);
+                this->_write(dest, bytes);
+            }
             break;
         }
-        case OP_MEMCPY_P:
+        case OP_MEMCPY_X:
+        {
+            _CHECK_BYTES_AVAIL(5)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t reg4 = _NEXT_BYTE;
+            const uint8_t scale = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_REGISTER_VALID(reg4)
+            _CHECK_REGISTER_VALID(reg3)
+            const uint32_t offset = this->_registers[reg4] * scale;
+            const uint16_t dest = this->_registers[reg1] + offset;
+            const uint16_t source = this->_registers[reg2] + offset;
+            const uint16_t bytes = this->_registers[reg3];
+            _CHECK_ADDR_VALID((uint32_t)source + bytes - 1)
+            _CHECK_ADDR_VALID((uint32_t)dest + bytes - 1)
+            memmove(&this->_memory[dest], &this->_memory[source], bytes);
+            if (Policy::instrument)
+            {
+                this->_read(source, bytes);
+                this->_write(dest, bytes);
+            }
+            break;
+        }
+        case OP_MEMCPY_PI:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t reg1 = _NEXT_BYTE;
@@ -391,283 +1129,1719 @@ ExecResult VM::run(uint32_t maxInstr)
             const uint16_t bytes = this->_registers[reg3];
             _CHECK_ADDR_VALID((uint32_t)source + bytes - 1)
             _CHECK_ADDR_VALID((uint32_t)dest + bytes - 1)
-            memcpy(&this->_memory[dest], &this->_memory[source], bytes);
+            memmove(&this->_memory[dest], &this->_memory[source], bytes);
+            this->_registers[reg1] += bytes;
+            this->_registers[reg2] += bytes;
+            if (Policy::instrument)
+            {
+                this->_read(source, bytes);
+                this->_write(dest, bytes);
+            }
             break;
         }
-        case OP_INC:
+        case OP_MOVQ:
         {
-            _CHECK_BYTES_AVAIL(1)
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(reg1, _QWORD(reg2))
+            break;
+        }
+        case OP_LCONSQ:
+        {
+            _CHECK_BYTES_AVAIL(9)
             const uint8_t reg = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg)
-            this->_registers[reg]++;
+            const uint32_t low = _NEXT_INT;
+            const uint32_t high = _NEXT_INT;
+            _CHECK_PAIR_VALID(reg)
+            this->_registers[reg] = low;
+            this->_registers[reg + 1] = high;
             break;
         }
-        case OP_FINC:
+        case OP_LOADQ:
         {
-            _CHECK_BYTES_AVAIL(1)
+            _CHECK_BYTES_AVAIL(3)
             const uint8_t reg = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg)
-
-            if(this->FSIG){
-                float floatValue = static_cast<float>(this->RSIG);
-                floatValue++;
-                this->RSIG = static_cast<int>(floatValue);
-            }else{
-                (*((float *)&this->_registers[reg]))++;
-            }
-            // \/ antiga forma para valores uint32_t;
-            // (*((float *)&this->_registers[reg]))++;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_ADDR_VALID((uint32_t)addr + 7)
+            memcpy(&this->_registers[reg], &this->_memory[addr], sizeof(uint64_t));
+            if (Policy::instrument)
+                this->_read(addr, 8);
+            break;
+        }
+        case OP_LOADQ_D:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const int16_t disp = (int16_t)_NEXT_SHORT;
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t src = this->_registers[reg2] + disp;
+            _CHECK_ADDR_VALID((uint32_t)src + 7)
+            memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint64_t));
+            if (Policy::instrument)
+                this->_read(src, 8);
+            break;
+        }
+        case OP_STORQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint16_t addr = _NEXT_SHORT;
+            const uint8_t reg = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_ADDR_VALID((uint32_t)addr + 7)
+            memcpy(&this->_memory[addr], &this->_registers[reg], sizeof(uint64_t));
+            if (Policy::instrument)
+                this->_write(addr, 8);
+            break;
+        }
+        case OP_STORQ_D:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const int16_t disp = (int16_t)_NEXT_SHORT;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1] + disp;
+            _CHECK_ADDR_VALID((uint32_t)dest + 7)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint64_t));
+            if (Policy::instrument)
+                this->_write(dest, 8);
+            break;
+        }
+        case OP_ADDQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) + _QWORD(reg2))
+            break;
+        }
+        case OP_SUBQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) - _QWORD(reg2))
+            break;
+        }
+        case OP_MULQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) * _QWORD(reg2))
+            break;
+        }
+        case OP_DIVQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) / _QWORD(reg2))
+            break;
+        }
+        case OP_IDIVQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, (int64_t)_QWORD(reg1) / (int64_t)_QWORD(reg2))
+            break;
+        }
+        case OP_MODQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) % _QWORD(reg2))
+            break;
+        }
+        case OP_IMODQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, (int64_t)_QWORD(reg1) % (int64_t)_QWORD(reg2))
+            break;
+        }
+        case OP_ANDQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) & _QWORD(reg2))
+            break;
+        }
+        case OP_ORQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) | _QWORD(reg2))
+            break;
+        }
+        case OP_XORQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) ^ _QWORD(reg2))
+            break;
+        }
+        case OP_SHLQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) << (this->_registers[reg2] & 63))
+            break;
+        }
+        case OP_SHRQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _SET_QWORD(rreg, _QWORD(reg1) >> (this->_registers[reg2] & 63))
+            break;
+        }
+        case OP_ISHRQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _SET_QWORD(rreg, (int64_t)_QWORD(reg1) >> (this->_registers[reg2] & 63))
+            break;
+        }
+        case OP_CMPQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            const int64_t a = (int64_t)_QWORD(reg1);
+            const int64_t b = (int64_t)_QWORD(reg2);
+            *((int32_t *)&this->_registers[rreg]) = a < b ? -1 : a > b;
+            break;
+        }
+        case OP_UCMPQ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            const uint64_t a = _QWORD(reg1);
+            const uint64_t b = _QWORD(reg2);
+            *((int32_t *)&this->_registers[rreg]) = a < b ? -1 : a > b;
+            break;
+        }
+        case OP_DADD:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_DOUBLE(rreg, _DOUBLE(reg1) + _DOUBLE(reg2))
+            break;
+        }
+        case OP_DSUB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_DOUBLE(rreg, _DOUBLE(reg1) - _DOUBLE(reg2))
+            break;
+        }
+        case OP_DMUL:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_DOUBLE(rreg, _DOUBLE(reg1) * _DOUBLE(reg2))
+            break;
+        }
+        case OP_DDIV:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            _SET_DOUBLE(rreg, _DOUBLE(reg1) / _DOUBLE(reg2))
+            break;
+        }
+        case OP_DCMP:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_PAIR_VALID(reg1)
+            _CHECK_PAIR_VALID(reg2)
+            const double a = _DOUBLE(reg1);
+            const double b = _DOUBLE(reg2);
+            // 2 when either is NaN
+            *((int32_t *)&this->_registers[rreg]) = a < b ? -1 : a > b ? 1 : a == b ? 0 : 2;
+            break;
+        }
+        case OP_SEXQ:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_REGISTER_VALID(reg1)
+            _SET_QWORD(reg, (int64_t) * ((int32_t *)&this->_registers[reg1]))
+            break;
+        }
+        case OP_ZEXQ:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_REGISTER_VALID(reg1)
+            _SET_QWORD(reg, this->_registers[reg1])
+            break;
+        }
+        case OP_I2D:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_REGISTER_VALID(reg1)
+            _SET_DOUBLE(reg, *((int32_t *)&this->_registers[reg1]))
+            break;
+        }
+        case OP_D2I:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_PAIR_VALID(reg1)
+            *((int32_t *)&this->_registers[reg]) = (int32_t)_DOUBLE(reg1);
+            break;
+        }
+        case OP_F2D:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_REGISTER_VALID(reg1)
+            _SET_DOUBLE(reg, *((float *)&this->_registers[reg1]))
+            break;
+        }
+        case OP_D2F:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_PAIR_VALID(reg1)
+            *((float *)&this->_registers[reg]) = (float)_DOUBLE(reg1);
+            break;
+        }
+        case OP_Q2D:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_PAIR_VALID(reg1)
+            _SET_DOUBLE(reg, (double)(int64_t)_QWORD(reg1))
+            break;
+        }
+        case OP_D2Q:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_PAIR_VALID(reg1)
+            _SET_QWORD(reg, (int64_t)_DOUBLE(reg1))
+            break;
+        }
+        case OP_Q2F:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_PAIR_VALID(reg1)
+            *((float *)&this->_registers[reg]) = (float)(int64_t)_QWORD(reg1);
+            break;
+        }
+        case OP_F2Q:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+            _CHECK_REGISTER_VALID(reg1)
+            _SET_QWORD(reg, (int64_t) * ((float *)&this->_registers[reg1]))
+            break;
+        }
+        case OP_PRINTQ:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t ln = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+
+            _PRINTED(fprintf(this->_out, "%lld", (long long)_QWORD(reg)))
+            if (ln != 0)
+                _PRINTED(fputc('\n', this->_out) != EOF)
+            break;
+        }
+        case OP_PRINTD:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint8_t ln = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(reg)
+
+            _PRINTED(fprintf(this->_out, "%f", _DOUBLE(reg)))
+            if (ln != 0)
+                _PRINTED(fputc('\n', this->_out) != EOF)
+            break;
+        }
+        case OP_POPCNT:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            const uint32_t value = this->_registers[reg1];
+            this->_registers[rreg] = __builtin_popcount(value);
+            break;
+        }
+        case OP_CLZ:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            const uint32_t value = this->_registers[reg1];
+            this->_registers[rreg] = value == 0 ? 32 : __builtin_clz(value);
+            break;
+        }
+        case OP_CTZ:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            const uint32_t value = this->_registers[reg1];
+            this->_registers[rreg] = value == 0 ? 32 : __builtin_ctz(value);
+            break;
+        }
+        case OP_BSWAP:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            const uint32_t value = this->_registers[reg1];
+            this->_registers[rreg] = __builtin_bswap32(value);
+            break;
+        }
+        case OP_ROL:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint32_t value = this->_registers[reg1];
+            const uint32_t count = this->_registers[reg2] & 31;
+            this->_registers[rreg] = (value << count) | (value >> ((32 - count) & 31));
+            break;
+        }
+        case OP_ROR:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint32_t value = this->_registers[reg1];
+            const uint32_t count = this->_registers[reg2] & 31;
+            this->_registers[rreg] = (value >> count) | (value << ((32 - count) & 31));
+            break;
+        }
+        case OP_ROLIB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            const uint32_t value = this->_registers[reg1];
+            const uint32_t count = imm & 31;
+            this->_registers[rreg] = (value << count) | (value >> ((32 - count) & 31));
+            break;
+        }
+        case OP_RORIB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            const uint32_t value = this->_registers[reg1];
+            const uint32_t count = imm & 31;
+            this->_registers[rreg] = (value >> count) | (value << ((32 - count) & 31));
+            break;
+        }
+        case OP_BEXT:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t start = _NEXT_BYTE;
+            const uint8_t len = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            const uint32_t mask = fieldMask(start, len);
+            this->_registers[rreg] = mask == 0 ? 0 : (this->_registers[reg1] & mask) >> start;
+            break;
+        }
+        case OP_BINS:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t start = _NEXT_BYTE;
+            const uint8_t len = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            const uint32_t mask = fieldMask(start, len);
+            if (mask != 0)
+                this->_registers[rreg] = (this->_registers[rreg] & ~mask) | ((this->_registers[reg1] << start) & mask);
+            break;
+        }
+        case OP_CMOV:
+        {
+            _CHECK_BYTES_AVAIL(5)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t cc = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_CONDITION_VALID(cc)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_REGISTER_VALID(reg3)
+            const bool taken = testCondition(cc, this->_registers[reg2], this->_registers[reg3]);
+            this->_registers[rreg] = taken ? this->_registers[reg1] : this->_registers[rreg];
+            break;
+        }
+        case OP_CMOVI:
+        {
+            _CHECK_BYTES_AVAIL(8)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t cc = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_CONDITION_VALID(cc)
+            _CHECK_REGISTER_VALID(reg2)
+            const bool taken = testCondition(cc, this->_registers[reg2], imm);
+            this->_registers[rreg] = taken ? this->_registers[reg1] : this->_registers[rreg];
+            break;
+        }
+        case OP_SELECT:
+        {
+            _CHECK_BYTES_AVAIL(6)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t cc = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            const uint8_t reg4 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_CONDITION_VALID(cc)
+            _CHECK_REGISTER_VALID(reg3)
+            _CHECK_REGISTER_VALID(reg4)
+            const bool taken = testCondition(cc, this->_registers[reg3], this->_registers[reg4]);
+            this->_registers[rreg] = taken ? this->_registers[reg1] : this->_registers[reg2];
+            break;
+        }
+        case OP_SELECTI:
+        {
+            _CHECK_BYTES_AVAIL(9)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t cc = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_CONDITION_VALID(cc)
+            _CHECK_REGISTER_VALID(reg3)
+            const bool taken = testCondition(cc, this->_registers[reg3], imm);
+            this->_registers[rreg] = taken ? this->_registers[reg1] : this->_registers[reg2];
+            break;
+        }
+        case OP_MIN:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint32_t a = this->_registers[reg1];
+            const uint32_t b = this->_registers[reg2];
+            this->_registers[rreg] = a < b ? a : b;
+            break;
+        }
+        case OP_MAX:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint32_t a = this->_registers[reg1];
+            const uint32_t b = this->_registers[reg2];
+            this->_registers[rreg] = a > b ? a : b;
+            break;
+        }
+        case OP_IMIN:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const int32_t a = this->_registers[reg1];
+            const int32_t b = this->_registers[reg2];
+            this->_registers[rreg] = a < b ? a : b;
+            break;
+        }
+        case OP_IMAX:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const int32_t a = this->_registers[reg1];
+            const int32_t b = this->_registers[reg2];
+            this->_registers[rreg] = a > b ? a : b;
+            break;
+        }
+        case OP_SWITCH:
+        {
+            _CHECK_BYTES_AVAIL(5)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint16_t count = _NEXT_SHORT;
+            const uint16_t fallback = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+            // one check for the whole table, then one compare picks an entry or the default
+            _CHECK_BYTES_AVAIL(2 * (uint32_t)count)
+            const uint32_t index = this->_registers[reg];
+            uint16_t target = fallback;
+            if (index < count)
+                memcpy(&target, &this->_memory[this->_registers[IP] + 1 + 2 * index], sizeof(uint16_t));
+            this->_registers[IP] = target - 1;
+            break;
+        }
+        case OP_CRC32C:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t addr = this->_registers[reg1];
+            const uint16_t bytes = this->_registers[reg2];
+            _CHECK_RANGE_VALID(addr, bytes)
+            this->_registers[rreg] = crc32c(this->_registers[rreg], &this->_memory[addr], bytes);
+            if (Policy::instrument)
+                this->_read(addr, bytes);
+            break;
+        }
+        case OP_HASH64:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_PAIR_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t addr = this->_registers[reg1];
+            const uint16_t bytes = this->_registers[reg2];
+            _CHECK_RANGE_VALID(addr, bytes)
+            _SET_QWORD(rreg, hash64(_QWORD(rreg), &this->_memory[addr], bytes))
+            if (Policy::instrument)
+                this->_read(addr, bytes);
+            break;
+        }
+        case OP_ADLER32:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t addr = this->_registers[reg1];
+            const uint16_t bytes = this->_registers[reg2];
+            _CHECK_RANGE_VALID(addr, bytes)
+            this->_registers[rreg] = adler32(this->_registers[rreg], &this->_memory[addr], bytes);
+            if (Policy::instrument)
+                this->_read(addr, bytes);
+            break;
+        }
+        case OP_FLETCHER32:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t addr = this->_registers[reg1];
+            const uint16_t bytes = this->_registers[reg2];
+            _CHECK_RANGE_VALID(addr, bytes)
+            this->_registers[rreg] = fletcher32(this->_registers[rreg], &this->_memory[addr], bytes);
+            if (Policy::instrument)
+                this->_read(addr, bytes);
+            break;
+        }
+        case OP_FMA:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_REGISTER_VALID(reg3)
+            // rounded once, vfmadd when the host has FMA
+            *((float *)&this->_registers[rreg]) = fmaf(*((float *)&this->_registers[reg1]), *((float *)&this->_registers[reg2]), *((float *)&this->_registers[reg3]));
+            break;
+        }
+        case OP_FSQRT:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            *((float *)&this->_registers[rreg]) = sqrtf(*((float *)&this->_registers[reg1]));
+            break;
+        }
+        case OP_FABS:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = this->_registers[reg1] & 0x7FFFFFFF;
+            break;
+        }
+        case OP_FNEG:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = this->_registers[reg1] ^ 0x80000000;
+            break;
+        }
+        case OP_FMIN:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((float *)&this->_registers[rreg]) = floatMin(*((float *)&this->_registers[reg1]), *((float *)&this->_registers[reg2]));
+            break;
+        }
+        case OP_FMAX:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((float *)&this->_registers[rreg]) = floatMax(*((float *)&this->_registers[reg1]), *((float *)&this->_registers[reg2]));
+            break;
+        }
+        case OP_FFLOOR:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            *((float *)&this->_registers[rreg]) = floorf(*((float *)&this->_registers[reg1]));
+            break;
+        }
+        case OP_FCEIL:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            *((float *)&this->_registers[rreg]) = ceilf(*((float *)&this->_registers[reg1]));
+            break;
+        }
+        case OP_FROUND:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            *((float *)&this->_registers[rreg]) = floatRound(*((float *)&this->_registers[reg1]));
+            break;
+        }
+        case OP_JFE:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+
+            if (*((float *)&this->_registers[reg1]) == *((float *)&this->_registers[reg2]))
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JFNE:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+
+            if (*((float *)&this->_registers[reg1]) != *((float *)&this->_registers[reg2]))
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JFG:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+
+            if (*((float *)&this->_registers[reg1]) > *((float *)&this->_registers[reg2]))
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JFGE:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+
+            if (*((float *)&this->_registers[reg1]) >= *((float *)&this->_registers[reg2]))
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JFL:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+
+            if (*((float *)&this->_registers[reg1]) < *((float *)&this->_registers[reg2]))
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JFLE:
+        {
+            _CHECK_BYTES_AVAIL(4)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+
+            if (*((float *)&this->_registers[reg1]) <= *((float *)&this->_registers[reg2]))
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_STOR:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint16_t addr = _NEXT_SHORT;
+            const uint8_t reg = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_ADDR_VALID((uint32_t)addr + 3)
+            memcpy(&this->_memory[addr], &this->_registers[reg], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_write(addr, 4);
+            break;
+        }
+        case OP_STOR_P:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1];
+            _CHECK_ADDR_VALID((uint32_t)dest + 3)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_write(dest, 4);
+            break;
+        }
+        case OP_STORW:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint16_t addr = _NEXT_SHORT;
+            const uint8_t reg = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_ADDR_VALID((uint32_t)addr + 1)
+            memcpy(&this->_memory[addr], &this->_registers[reg], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_write(addr, 2);
+            break;
+        }
+        case OP_STORW_P:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1];
+            _CHECK_ADDR_VALID((uint32_t)dest + 1)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_write(dest, 2);
+            break;
+        }
+        case OP_STORB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint16_t addr = _NEXT_SHORT;
+            const uint8_t reg = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_ADDR_VALID(addr)
+            memcpy(&this->_memory[addr], &this->_registers[reg], sizeof(uint8_t));
+            if (Policy::instrument)
+                this->_write(addr, 1);
+            break;
+        }
+        case OP_STORB_P:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t dest = this->_registers[reg1];
+            _CHECK_ADDR_VALID((uint32_t)dest)
+            memcpy(&this->_memory[dest], &this->_registers[reg2], sizeof(uint8_t));
+            if (Policy::instrument)
+                this->_write(dest, 1);
+            break;
+        }
+        case OP_LOAD:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_ADDR_VALID((uint32_t)addr + 3)
+            memcpy(&this->_registers[reg], &this->_memory[addr], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_read(addr, 4);
+            break;
+        }
+        case OP_LOAD_P:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t src = this->_registers[reg2];
+            _CHECK_ADDR_VALID((uint32_t)src + 3)
+            memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint32_t));
+            if (Policy::instrument)
+                this->_read(src, 4);
+            break;
+        }
+        case OP_LOADW:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_ADDR_VALID((uint32_t)addr + 1)
+            this->_registers[reg] = 0;
+            memcpy(&this->_registers[reg], &this->_memory[addr], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_read(addr, 2);
+            break;
+        }
+        case OP_LOADW_P:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t src = this->_registers[reg2];
+            _CHECK_ADDR_VALID((uint32_t)src + 1)
+            this->_registers[reg1] = 0;
+            memcpy(&this->_registers[reg1], &this->_memory[src], sizeof(uint16_t));
+            if (Policy::instrument)
+                this->_read(src, 2);
+            break;
+        }
+        case OP_LOADB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+            _CHECK_ADDR_VALID((uint32_t)addr)
+            this->_registers[reg] = this->_memory[addr];
+            if (Policy::instrument)
+                this->_read(addr, 1);
+            break;
+        }
+        case OP_LOADB_P:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            const uint16_t src = this->_registers[reg2];
+            _CHECK_ADDR_VALID((uint32_t)src)
+            this->_registers[reg1] = this->_memory[src];
+            if (Policy::instrument)
+                this->_read(src, 1);
+            break;
+        }
+        case OP_MEMCPY:
+        {
+            _CHECK_BYTES_AVAIL(6)
+            const uint16_t dest = _NEXT_SHORT;
+            const uint16_t source = _NEXT_SHORT;
+            const uint16_t bytes = _NEXT_SHORT;
+            _CHECK_ADDR_VALID((uint32_t)source + bytes - 1)
+            _CHECK_ADDR_VALID((uint32_t)dest + bytes - 1)
+            memcpy(&this->_memory[dest], &this->_memory[source], bytes);
+            if (Policy::instrument)
+            {
+                this->_read(source, bytes);
+                this->_write(dest, bytes);
+            }
+            break;
+        }
+        case OP_MEMCPY_P:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t reg3 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            _CHECK_REGISTER_VALID(reg3)
+            const uint16_t dest = this->_registers[reg1];
+            const uint16_t source = this->_registers[reg2];
+            const uint16_t bytes = this->_registers[reg3];
+            _CHECK_ADDR_VALID((uint32_t)source + bytes - 1)
+            _CHECK_ADDR_VALID((uint32_t)dest + bytes - 1)
+            memcpy(&this->_memory[dest], &this->_memory[source], bytes);
+            if (Policy::instrument)
+            {
+                this->_read(source, bytes);
+                this->_write(dest, bytes);
+            }
+            break;
+        }
+        case OP_INC:
+        {
+            _CHECK_BYTES_AVAIL(1)
+            const uint8_t reg = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+            this->_registers[reg]++;
+            break;
+        }
+        case OP_FINC:
+        {
+            _CHECK_BYTES_AVAIL(1)
+            const uint8_t reg = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+
+            if(this->FSIG){
+                float floatValue = static_cast<float>(this->RSIG);
+                floatValue++;
+                this->RSIG = static_cast<int>(floatValue);
+            }else{
+                (*((float *)&this->_registers[reg]))++;
+            }
+            // \/ antiga forma para valores uint32_t;
+            // (*((float *)&this->_registers[reg]))++;
+            break;
+        }
+        case OP_DEC:
+        {
+            _CHECK_BYTES_AVAIL(1)
+            const uint8_t reg = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+            this->_registers[reg]--;
+            break;
+        }
+        case OP_FDEC:
+        {
+            _CHECK_BYTES_AVAIL(1)
+            const uint8_t reg = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+
+            if(this->FSIG){
+                float floatValue = static_cast<float>(this->RSIG);
+                floatValue--;
+                this->RSIG = static_cast<int>(floatValue);
+            }else{
+                (*((float *)&this->_registers[reg]))--;
+            }
+            // \/ antiga forma para valores uint32_t;
+            // (*((float *)&this->_registers[reg]))--;
+            break;
+        }
+        case OP_ADD:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] + this->_registers[reg2];
+            break;
+        }
+        case OP_FADD:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) + *((float *)&this->_registers[reg2]);
+            break;
+        }
+        case OP_SUB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] - this->_registers[reg2];
+            break;
+        }
+        case OP_FSUB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) - *((float *)&this->_registers[reg2]);
+            break;
+        }
+        case OP_MUL:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] * this->_registers[reg2];
+            break;
+        }
+        case OP_IMUL:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) * *((int32_t *)&this->_registers[reg2]);
+            break;
+        }
+        case OP_FMUL:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) * *((float *)&this->_registers[reg2]);
+            break;
+        }
+        case OP_DIV:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] / this->_registers[reg2];
+            break;
+        }
+        case OP_IDIV:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) / *((int32_t *)&this->_registers[reg2]);
+            break;
+        }
+        case OP_FDIV:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) / *((float *)&this->_registers[reg2]);
+            break;
+        }
+        case OP_SHL:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] << this->_registers[reg2];
+            break;
+        }
+        case OP_SHR:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] >> this->_registers[reg2];
+            break;
+        }
+        case OP_ISHR:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) >> *((int32_t *)&this->_registers[reg2]);
+            break;
+        }
+        case OP_MOD:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] % this->_registers[reg2];
+            break;
+        }
+        case OP_IMOD:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) % *((int32_t *)&this->_registers[reg2]);
+            break;
+        }
+        case OP_AND:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] & this->_registers[reg2];
+            break;
+        }
+        case OP_OR:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] | this->_registers[reg2];
+            break;
+        }
+        case OP_XOR:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t reg2 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            _CHECK_REGISTER_VALID(reg2)
+            this->_registers[rreg] = this->_registers[reg1] ^ this->_registers[reg2];
+            break;
+        }
+        case OP_NOT:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = ~this->_registers[reg1];
+            break;
+        }
+        case OP_ADDI:
+        {
+            _CHECK_BYTES_AVAIL(6)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = this->_registers[reg1] + imm;
+            break;
+        }
+        case OP_ADDIB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = this->_registers[reg1] + imm;
+            break;
+        }
+        case OP_SUBI:
+        {
+            _CHECK_BYTES_AVAIL(6)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = this->_registers[reg1] - imm;
+            break;
+        }
+        case OP_SUBIB:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = this->_registers[reg1] - imm;
             break;
         }
-        case OP_DEC:
+        case OP_MULI:
         {
-            _CHECK_BYTES_AVAIL(1)
-            const uint8_t reg = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg)
-            this->_registers[reg]--;
+            _CHECK_BYTES_AVAIL(6)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = this->_registers[reg1] * imm;
             break;
         }
-        case OP_FDEC:
+        case OP_MULIB:
         {
-            _CHECK_BYTES_AVAIL(1)
-            const uint8_t reg = _NEXT_BYTE;
-            _CHECK_REGISTER_VALID(reg)
-
-            if(this->FSIG){
-                float floatValue = static_cast<float>(this->RSIG);
-                floatValue--;
-                this->RSIG = static_cast<int>(floatValue);
-            }else{
-                (*((float *)&this->_registers[reg]))--;
-            }
-            // \/ antiga forma para valores uint32_t;
-            // (*((float *)&this->_registers[reg]))--;
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t rreg = _NEXT_BYTE;
+            const uint8_t reg1 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(rreg)
+            _CHECK_REGISTER_VALID(reg1)
+            this->_registers[rreg] = this->_registers[reg1] * imm;
             break;
         }
-        case OP_ADD:
+        case OP_DIVI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] + this->_registers[reg2];
+            this->_registers[rreg] = this->_registers[reg1] / imm;
             break;
         }
-        case OP_FADD:
+        case OP_DIVIB:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) + *((float *)&this->_registers[reg2]);
+            this->_registers[rreg] = this->_registers[reg1] / imm;
             break;
         }
-        case OP_SUB:
+        case OP_IDIVI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] - this->_registers[reg2];
+            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) / (int32_t)imm;
             break;
         }
-        case OP_FSUB:
+        case OP_MODI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) - *((float *)&this->_registers[reg2]);
+            this->_registers[rreg] = this->_registers[reg1] % imm;
             break;
         }
-        case OP_MUL:
+        case OP_MODIB:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] * this->_registers[reg2];
+            this->_registers[rreg] = this->_registers[reg1] % imm;
             break;
         }
-        case OP_IMUL:
+        case OP_IMODI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) * *((int32_t *)&this->_registers[reg2]);
+            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) % (int32_t)imm;
             break;
         }
-        case OP_FMUL:
+        case OP_SHLIB:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) * *((float *)&this->_registers[reg2]);
+            this->_registers[rreg] = this->_registers[reg1] << (imm & 31);
             break;
         }
-        case OP_DIV:
+        case OP_SHRIB:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] / this->_registers[reg2];
+            this->_registers[rreg] = this->_registers[reg1] >> (imm & 31);
             break;
         }
-        case OP_IDIV:
+        case OP_ISHRIB:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) / *((int32_t *)&this->_registers[reg2]);
+            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) >> (imm & 31);
             break;
         }
-        case OP_FDIV:
+        case OP_ANDI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) / *((float *)&this->_registers[reg2]);
+            this->_registers[rreg] = this->_registers[reg1] & imm;
             break;
         }
-        case OP_SHL:
+        case OP_ANDIB:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] << this->_registers[reg2];
+            this->_registers[rreg] = this->_registers[reg1] & imm;
             break;
         }
-        case OP_SHR:
+        case OP_ORI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] >> this->_registers[reg2];
+            this->_registers[rreg] = this->_registers[reg1] | imm;
             break;
         }
-        case OP_ISHR:
+        case OP_ORIB:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) >> *((int32_t *)&this->_registers[reg2]);
+            this->_registers[rreg] = this->_registers[reg1] | imm;
             break;
         }
-        case OP_MOD:
+        case OP_XORI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] % this->_registers[reg2];
+            this->_registers[rreg] = this->_registers[reg1] ^ imm;
             break;
         }
-        case OP_IMOD:
+        case OP_XORIB:
         {
             _CHECK_BYTES_AVAIL(3)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint8_t imm = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            *((int32_t *)&this->_registers[rreg]) = *((int32_t *)&this->_registers[reg1]) % *((int32_t *)&this->_registers[reg2]);
+            this->_registers[rreg] = this->_registers[reg1] ^ imm;
             break;
         }
-        case OP_AND:
+        case OP_FADDI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] & this->_registers[reg2];
+            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) + *((const float *)&imm);
             break;
         }
-        case OP_OR:
+        case OP_FSUBI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] | this->_registers[reg2];
+            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) - *((const float *)&imm);
             break;
         }
-        case OP_XOR:
+        case OP_FMULI:
         {
-            _CHECK_BYTES_AVAIL(3)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
-            const uint8_t reg2 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            _CHECK_REGISTER_VALID(reg2)
-            this->_registers[rreg] = this->_registers[reg1] ^ this->_registers[reg2];
+            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) * *((const float *)&imm);
             break;
         }
-        case OP_NOT:
+        case OP_FDIVI:
         {
-            _CHECK_BYTES_AVAIL(2)
+            _CHECK_BYTES_AVAIL(6)
             const uint8_t rreg = _NEXT_BYTE;
             const uint8_t reg1 = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
             _CHECK_REGISTER_VALID(rreg)
             _CHECK_REGISTER_VALID(reg1)
-            this->_registers[rreg] = ~this->_registers[reg1];
+            *((float *)&this->_registers[rreg]) = *((float *)&this->_registers[reg1]) / *((const float *)&imm);
             break;
         }
         case OP_U2I:
@@ -872,6 +3046,177 @@ ExecResult VM::run(uint32_t maxInstr)
                 this->_registers[IP] = addr - 1;
             break;
         }
+        case OP_JEI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (this->_registers[reg] == imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JNEI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (this->_registers[reg] != imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JAI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (this->_registers[reg] > imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JGI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (*((int32_t *)&this->_registers[reg]) > (int32_t)imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JAEI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (this->_registers[reg] >= imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JGEI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (*((int32_t *)&this->_registers[reg]) >= (int32_t)imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JBI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (this->_registers[reg] < imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JLI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (*((int32_t *)&this->_registers[reg]) < (int32_t)imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JBEI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (this->_registers[reg] <= imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JLEI:
+        {
+            _CHECK_BYTES_AVAIL(7)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint32_t imm = _NEXT_INT;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (*((int32_t *)&this->_registers[reg]) <= (int32_t)imm)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_DJNZ:
+        {
+            _CHECK_BYTES_AVAIL(3)
+            const uint8_t reg = _NEXT_BYTE;
+            const uint16_t addr = _NEXT_SHORT;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (--this->_registers[reg] != 0)
+                this->_registers[IP] = addr - 1;
+            break;
+        }
+        case OP_JMP_S:
+        {
+            _CHECK_BYTES_AVAIL(1)
+            const int8_t offset = _NEXT_BYTE;
+            this->_registers[IP] = start + offset - 1;
+            break;
+        }
+        case OP_JZ_S:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const int8_t offset = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (this->_registers[reg] == 0)
+                this->_registers[IP] = start + offset - 1;
+            break;
+        }
+        case OP_JNZ_S:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const int8_t offset = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (this->_registers[reg] != 0)
+                this->_registers[IP] = start + offset - 1;
+            break;
+        }
+        case OP_DJNZ_S:
+        {
+            _CHECK_BYTES_AVAIL(2)
+            const uint8_t reg = _NEXT_BYTE;
+            const int8_t offset = _NEXT_BYTE;
+            _CHECK_REGISTER_VALID(reg)
+
+            if (--this->_registers[reg] != 0)
+                this->_registers[IP] = start + offset - 1;
+            break;
+        }
         case OP_PRINT:
         {
             _CHECK_BYTES_AVAIL(2)
@@ -879,9 +3224,9 @@ ExecResult VM::run(uint32_t maxInstr)
             const uint8_t ln = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(reg)
 
-            printf("%u", this->_registers[reg]);
+            _PRINTED(fprintf(this->_out, "%u", this->_registers[reg]))
             if (ln != 0)
-                putchar('\n');
+                _PRINTED(fputc('\n', this->_out) != EOF)
             break;
         }
         case OP_PRINTI:
@@ -891,9 +3236,9 @@ ExecResult VM::run(uint32_t maxInstr)
             const uint8_t ln = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(reg)
 
-            printf("%d", *((int32_t *)&this->_registers[reg]));
+            _PRINTED(fprintf(this->_out, "%d", *((int32_t *)&this->_registers[reg])))
             if (ln != 0)
-                putchar('\n');
+                _PRINTED(fputc('\n', this->_out) != EOF)
             break;
         }
         case OP_PRINTF:
@@ -903,9 +3248,9 @@ ExecResult VM::run(uint32_t maxInstr)
             const uint8_t ln = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(reg)
 
-            printf("%f", *((float *)&this->_registers[reg]));
+            _PRINTED(fprintf(this->_out, "%f", *((float *)&this->_registers[reg])))
             if (ln != 0)
-                putchar('\n');
+                _PRINTED(fputc('\n', this->_out) != EOF)
             break;
         }
         case OP_PRINTC:
@@ -914,7 +3259,7 @@ ExecResult VM::run(uint32_t maxInstr)
             const uint8_t reg = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(reg)
             char *c = (char *)&this->_registers[reg];
-            putchar(*c);
+            _PRINTED(fputc(*c, this->_out) != EOF)
             break;
         }
         case OP_PRINTS:
@@ -926,7 +3271,7 @@ ExecResult VM::run(uint32_t maxInstr)
 
             while (*curChar != '\0')
             {
-                putchar(*curChar);
+                _PRINTED(fputc(*curChar, this->_out) != EOF)
                 curChar++;
                 _CHECK_ADDR_VALID((uint8_t *)curChar - this->_memory)
             }
@@ -934,7 +3279,7 @@ ExecResult VM::run(uint32_t maxInstr)
         }
         case OP_PRINTLN:
         {
-            putchar('\n');
+            _PRINTED(fputc('\n', this->_out) != EOF)
             break;
         }
         case OP_READ:
@@ -942,7 +3287,7 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_BYTES_AVAIL(1)
             const uint8_t reg = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(reg)
-            scanf("%u", &this->_registers[reg]);
+            _INPUT_VALUE(this->_registers[reg], scanValue(this->_in, "%u%n", &this->_registers[reg]))
             break;
         }
         case OP_READI:
@@ -950,7 +3295,7 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_BYTES_AVAIL(1)
             const uint8_t reg = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(reg)
-            scanf("%d", (int32_t *)&this->_registers[reg]);
+            _INPUT_VALUE(this->_registers[reg], scanValue(this->_in, "%d%n", (int32_t *)&this->_registers[reg]))
             break;
         }
         case OP_READF:
@@ -958,7 +3303,7 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_BYTES_AVAIL(1)
             const uint8_t reg = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(reg)
-            scanf("%f", (float *)&this->_registers[reg]);
+            _INPUT_VALUE(this->_registers[reg], scanValue(this->_in, "%f%n", (float *)&this->_registers[reg]))
             break;
         }
         case OP_READC:
@@ -966,23 +3311,58 @@ ExecResult VM::run(uint32_t maxInstr)
             _CHECK_BYTES_AVAIL(1)
             const uint8_t reg = _NEXT_BYTE;
             _CHECK_REGISTER_VALID(reg)
-            this->_registers[reg] = getchar();
+            _INPUT_VALUE(this->_registers[reg], readChar(this->_in, &this->_registers[reg]))
             break;
         }
         case OP_READS:
         {
             _CHECK_BYTES_AVAIL(4)
             const uint16_t addr = _NEXT_SHORT;
-            size_t maxLen = _NEXT_SHORT;
+            const uint16_t maxLen = _NEXT_SHORT;
             _CHECK_ADDR_VALID((uint32_t)addr + maxLen)
+            if (maxLen == 0)
+                break;
             char *dest = (char *)&this->_memory[addr];
-            getline(&dest, &maxLen, stdin);
+            uint32_t len;
+            if (this->_replayer != nullptr)
+            {
+                if (!this->_replayer->nextString(dest, maxLen, &len))
+                    return ExecResult::VM_ERR_REPLAY_DIVERGED;
+            }
+            else
+            {
+                // the destination lives inside VM memory, so it must never be reallocated
+                if (fgets(dest, maxLen, this->_in) == nullptr)
+                    *dest = '\0';
+                len = strlen(dest);
+            }
+            if (this->_recorder != nullptr)
+                this->_recorder->string(dest, len);
+            this->_bytesRead += len;
             break;
         }
         }
 
         this->_registers[IP]++;
         instrCount++;
+        if (Policy::instrument)
+        {
+            this->_retire(start, instr, begin);
+            ending.instr = INSTRUCTION_COUNT;
+        }
+
+        // only back-edges and calls can keep a program running without bound
+        if (Policy::preempt && (this->_registers[IP] <= start || instr == OP_CALL || instr == OP_CALLF ||
+                                instr == OP_TAILCALL))
+        {
+            if (this->_interrupted.load(std::memory_order_relaxed))
+            {
+                this->_interrupted.store(false, std::memory_order_relaxed);
+                return ExecResult::VM_INTERRUPTED;
+            }
+            if (this->_deadline != 0 && VM::clock() >= this->_deadline)
+                return ExecResult::VM_DEADLINE;
+        }
     }
 
     return ExecResult::VM_PAUSED;
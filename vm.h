@@ -6,6 +6,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <type_traits>
+#include <atomic>
 
 enum ExecResult : uint8_t
 {
@@ -18,6 +19,19 @@ enum ExecResult : uint8_t
     VM_ERR_STACK_OVERFLOW,      // stack overflow
     VM_ERR_STACK_UNDERFLOW,     // stack underflow
     VM_ERR_INVALID_ADDRESS,     // tried to access an invalid memory address
+    VM_WAITING,                 // execution suspended until a pending interrupt completes
+    VM_DEADLINE,                // execution paused since the deadline passed
+    VM_INTERRUPTED,             // execution paused by a call to interrupt() from another thread
+    VM_ERR_REPLAY_DIVERGED,     // the program asked for input the replay log does not hold next
+    VM_ERR_WAIT_FAILED,         // the scheduler could not wait on the pending token's descriptor
+    EXEC_RESULT_COUNT
+};
+
+enum InterruptResult : uint8_t
+{
+    INT_FINISH,   // stop execution, run returns VM_FINISHED
+    INT_CONTINUE, // continue with the next instruction
+    INT_PENDING,  // suspend the VM until the host resumes it with the returned token
 };
 
 enum Instruction : uint8_t
@@ -111,9 +125,230 @@ enum Instruction : uint8_t
     OP_READF,   // read a float from stdin to the specified register
     OP_READC,   // read a single character's code from stdin to the specified register
     OP_READS,   // read a line to the specified memory address, to a maximum length
+    // arithmetic with an immediate, 8-bit ones are zero-extended:
+    OP_ADDI,   // add a 32-bit immediate, e.g.: addi r0, r1, 0x10 0x27 0x00 0x00
+    OP_ADDIB,  // add an 8-bit immediate, e.g.: addib r0, r1, 0x04
+    OP_SUBI,   // subtract a 32-bit immediate, e.g.: subi r0, r1, 0x10 0x27 0x00 0x00
+    OP_SUBIB,  // subtract an 8-bit immediate, e.g.: subib r0, r1, 0x01
+    OP_MULI,   // multiply by a 32-bit immediate (the low 32 bits are the same signed or not)
+    OP_MULIB,  // multiply by an 8-bit immediate, e.g.: mulib r0, r1, 0x0A
+    OP_DIVI,   // divide by a 32-bit immediate, e.g.: divi r0, r1, 0x10 0x27 0x00 0x00
+    OP_DIVIB,  // divide by an 8-bit immediate, e.g.: divib r0, r1, 0x0A
+    OP_IDIVI,  // signed divide by a 32-bit immediate, e.g.: idivi r0, r1, 0xFE 0xFF 0xFF 0xFF
+    OP_MODI,   // modulo of a 32-bit immediate, e.g.: modi r0, r1, 0x10 0x27 0x00 0x00
+    OP_MODIB,  // modulo of an 8-bit immediate, e.g.: modib r0, r1, 0x0A
+    OP_IMODI,  // signed remainder of a 32-bit immediate, e.g.: imodi r0, r1, 0x0A 0x00 0x00 0x00
+    OP_SHLIB,  // logical shift left by an immediate count, e.g.: shlib r0, r1, 0x03
+    OP_SHRIB,  // logical shift right by an immediate count, e.g.: shrib r0, r1, 0x03
+    OP_ISHRIB, // arithmetic shift right by an immediate count, e.g.: ishrib r0, r1, 0x03
+    OP_ANDI,   // and with a 32-bit immediate, e.g.: andi r0, r1, 0xFF 0xFF 0x00 0x00
+    OP_ANDIB,  // and with an 8-bit immediate, e.g.: andib r0, r1, 0x0F
+    OP_ORI,    // or with a 32-bit immediate, e.g.: ori r0, r1, 0x00 0x00 0x01 0x00
+    OP_ORIB,   // or with an 8-bit immediate, e.g.: orib r0, r1, 0x80
+    OP_XORI,   // xor with a 32-bit immediate, e.g.: xori r0, r1, 0xFF 0xFF 0xFF 0xFF
+    OP_XORIB,  // xor with an 8-bit immediate, e.g.: xorib r0, r1, 0x01
+    OP_FADDI,  // add a float immediate, e.g.: addfi r0, r1, 0x00 0x00 0x80 0x3F
+    OP_FSUBI,  // subtract a float immediate, e.g.: subfi r0, r1, 0x00 0x00 0x80 0x3F
+    OP_FMULI,  // multiply by a float immediate, e.g.: mulfi r0, r1, 0x00 0x00 0x00 0x3F
+    OP_FDIVI,  // divide by a float immediate, e.g.: divfi r0, r1, 0x00 0x00 0x20 0x41
+    // branching on an immediate:
+    OP_JEI,    // jump if equal to a 32-bit immediate, e.g. jei r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JNEI,   // jump if not equal to a 32-bit immediate, e.g. jnei r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JAI,    // jump if (unsigned) above a 32-bit immediate, e.g. jai r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JGI,    // jump if (signed) greater than a 32-bit immediate, e.g. jgi r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JAEI,   // jump if (unsigned) above or equal to a 32-bit immediate, e.g. jaei r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JGEI,   // jump if (signed) greater than or equal to a 32-bit immediate, e.g. jgei r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JBI,    // jump if (unsigned) below a 32-bit immediate, e.g. jbi r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JLI,    // jump if (signed) less than a 32-bit immediate, e.g. jli r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JBEI,   // jump if (unsigned) below or equal to a 32-bit immediate, e.g. jbei r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_JLEI,   // jump if (signed) less than or equal to a 32-bit immediate, e.g. jlei r0, 0x0A 0x00 0x00 0x00, 0x1C 0x00
+    OP_DJNZ,   // decrement and jump if the result is not zero, e.g. djnz r0, 0x1C 0x00
+    // relative branching, to a signed byte offset from the address of the jump:
+    OP_JMP_S,  // jump by an offset, e.g.: jmp_s 0xF6
+    OP_JZ_S,   // jump by an offset if zero, e.g.: jz_s r0, 0x0C
+    OP_JNZ_S,  // jump by an offset if not zero, e.g.: jnz_s r0, 0xF6
+    OP_DJNZ_S, // decrement and jump by an offset if the result is not zero, e.g.: djnz_s r0, 0xF6
+    // stack frames, BP points at the saved BP with the return address above it:
+    OP_CALLF,    // push the return address and BP, point BP at them and jump, e.g.: callf 0x10 0x00
+    OP_RETF,     // pop BP and the return address and jump to it, e.g.: retf
+    OP_ENTER,    // reserve a number of bytes for locals below BP, e.g.: enter 0x10 0x00
+    OP_LEAVE,    // release the locals, SP = BP, e.g.: leave
+    OP_TAILCALL, // release the frame's locals and jump, the callee returns to our caller, e.g.: tailcall 0x10 0x00
+    // base register plus a signed 16-bit displacement:
+    OP_LOAD_D,   // e.g.: load_d r0, r1, 0xFC 0xFF loads from r1 - 4
+    OP_LOADW_D,
+    OP_LOADB_D,
+    OP_STOR_D,   // e.g.: stor_d r1, 0x08 0x00, r0 stores r0 at r1 + 8
+    OP_STORW_D,
+    OP_STORB_D,
+    // base register plus an index register times a byte scale:
+    OP_LOAD_X,   // e.g.: load_x r0, r1, r2, 0x04 loads from r1 + r2 * 4
+    OP_LOADW_X,
+    OP_LOADB_X,
+    OP_STOR_X,   // e.g.: stor_x r1, r2, 0x04, r0 stores r0 at r1 + r2 * 4
+    OP_STORW_X,
+    OP_STORB_X,
+    // pointer register advanced by the access size afterwards:
+    OP_LOAD_PI,  // e.g.: load_pi r0, r1 loads from r1, then r1 += 4
+    OP_LOADW_PI,
+    OP_LOADB_PI,
+    OP_STOR_PI,  // e.g.: stor_pi r1, r0 stores r0 at r1, then r1 += 4
+    OP_STORW_PI,
+    OP_STORB_PI,
+    OP_MEMCPY_D,  // copy r2 bytes between displaced bases, e.g.: memcpy_d r0, 0x08 0x00, r1, 0x00 0x00, r2
+    OP_MEMCPY_X,  // copy r4 bytes from r1 + r2 * scale to r0 + r2 * scale, e.g.: memcpy_x r0, r1, r2, 0x10, r4
+    OP_MEMCPY_PI, // copy r2 bytes from r1 to r0 and advance both by r2, e.g.: memcpy_pi r0, r1, r2
+    // 64-bit integers and doubles in register pairs, r holding the low half and r + 1 the high half:
+    OP_MOVQ,    // e.g.: movq r0, r2 copies r2:r3 to r0:r1
+    OP_LCONSQ,  // load a constant, low half first, e.g.: lconsq r0, 0x01 0x00 0x00 0x00, 0x00 0x00 0x00 0x00
+    OP_LOADQ,   // e.g.: loadq r0, 0x08 0x00
+    OP_LOADQ_D, // e.g.: loadq_d r0, r4, 0x08 0x00
+    OP_STORQ,   // e.g.: storq 0x08 0x00, r0
+    OP_STORQ_D, // e.g.: storq_d r4, 0x08 0x00, r0
+    OP_ADDQ,    // e.g.: addq r0, r2, r4 is r0:r1 = r2:r3 + r4:r5
+    OP_SUBQ,
+    OP_MULQ,
+    OP_DIVQ,
+    OP_IDIVQ,
+    OP_MODQ,
+    OP_IMODQ,
+    OP_ANDQ,
+    OP_ORQ,
+    OP_XORQ,
+    OP_SHLQ,    // shift by a 32-bit register, modulo 64, e.g.: shlq r0, r2, r4
+    OP_SHRQ,
+    OP_ISHRQ,
+    OP_CMPQ,    // signed compare into a 32-bit register, -1, 0 or 1, e.g.: cmpq r4, r0, r2
+    OP_UCMPQ,   // unsigned compare, e.g.: ucmpq r4, r0, r2
+    OP_DADD,    // e.g.: dadd r0, r2, r4
+    OP_DSUB,
+    OP_DMUL,
+    OP_DDIV,
+    OP_DCMP,    // compare into a 32-bit register, -1, 0, 1, or 2 when unordered, e.g.: dcmp r4, r0, r2
+    OP_SEXQ,    // sign-extend an integer to a pair, e.g.: sexq r0, r2
+    OP_ZEXQ,    // zero-extend an unsigned integer to a pair, e.g.: zexq r0, r2
+    OP_I2D,     // e.g.: i2d r0, r2
+    OP_D2I,     // e.g.: d2i r2, r0
+    OP_F2D,
+    OP_D2F,
+    OP_Q2D,
+    OP_D2Q,
+    OP_Q2F,
+    OP_F2Q,
+    OP_PRINTQ,  // print a signed 64-bit integer, e.g.: printq r0
+    OP_PRINTD,  // print a double, e.g.: printd r0
+    // bit manipulation, defined for zero inputs and any count:
+    OP_POPCNT, // count the set bits, e.g.: popcnt r0, r1
+    OP_CLZ,    // count the leading zero bits, 32 for zero, e.g.: clz r0, r1
+    OP_CTZ,    // count the trailing zero bits, 32 for zero, e.g.: ctz r0, r1
+    OP_BSWAP,  // reverse the byte order, e.g.: bswap r0, r1
+    OP_ROL,    // rotate left by a register modulo 32, e.g.: rol r0, r1, r2
+    OP_ROR,    // rotate right by a register modulo 32, e.g.: ror r0, r1, r2
+    OP_ROLIB,  // rotate left by a byte modulo 32, e.g.: rolib r0, r1, 0x0D
+    OP_RORIB,  // rotate right by a byte modulo 32, e.g.: rorib r0, r1, 0x0D
+    OP_BEXT,   // extract len bits from start, bits past 31 read as zero, e.g.: bext r0, r1, start, len
+    OP_BINS,   // insert the low len bits of r1 into r0 at start, e.g.: bins r0, r1, start, len
+    // branch-free selection, the condition code compares a to b:
+    OP_CMOV,    // r0 = r1 if a cc b, e.g.: cmov r0, r1, cc, a, b
+    OP_CMOVI,   // e.g.: cmovi r0, r1, cc, a, 0x00 0x01 0x00 0x00
+    OP_SELECT,  // r0 = a cc b ? r1 : r2, e.g.: select r0, r1, r2, cc, a, b
+    OP_SELECTI, // e.g.: selecti r0, r1, r2, cc, a, 0x00 0x01 0x00 0x00
+    OP_MIN,     // unsigned minimum, e.g.: min r0, r1, r2
+    OP_MAX,     // unsigned maximum, e.g.: max r0, r1, r2
+    OP_IMIN,    // signed minimum, e.g.: imin r0, r1, r2
+    OP_IMAX,    // signed maximum, e.g.: imax r0, r1, r2
+    // jump to entry r0 of the table that follows, or to the default when r0 >= count,
+    // e.g.: switch r0, 0x02 0x00, 0x40 0x00, 0x10 0x00, 0x20 0x00
+    OP_SWITCH,
+    // checksums of the r2 bytes at address r1, continuing from the value in r0, see checksum.h:
+    OP_CRC32C,     // e.g.: crc32c r0, r1, r2
+    OP_HASH64,     // 64-bit hash into the pair r0:r1 seeded with it, e.g.: hash64 r0, r2, r3
+    OP_ADLER32,    // e.g.: adler32 r0, r1, r2
+    OP_FLETCHER32, // e.g.: fletcher32 r0, r1, r2
+    // float math; NaN inputs give NaN unless noted:
+    OP_FMA,    // r0 = r1 * r2 + r3 rounded once, e.g.: fma r0, r1, r2, r3
+    OP_FSQRT,  // NaN for negative inputs, -0 for -0, e.g.: fsqrt r0, r1
+    OP_FABS,   // clear the sign bit, also of NaN, e.g.: fabs r0, r1
+    OP_FNEG,   // flip the sign bit, also of NaN, e.g.: fneg r0, r1
+    OP_FMIN,   // see floatMin, e.g.: fmin r0, r1, r2
+    OP_FMAX,   // see floatMax, e.g.: fmax r0, r1, r2
+    OP_FFLOOR, // e.g.: ffloor r0, r1
+    OP_FCEIL,  // e.g.: fceil r0, r1
+    OP_FROUND, // to nearest, ties to even, e.g.: fround r0, r1
+    // float compare and jump, not taken for NaN operands except by jfne:
+    OP_JFE,  // e.g.: jfe r0, r1, 0x1C 0x00
+    OP_JFNE, // e.g.: jfne r0, r1, 0x1C 0x00
+    OP_JFG,  // e.g.: jfg r0, r1, 0x1C 0x00
+    OP_JFGE, // e.g.: jfge r0, r1, 0x1C 0x00
+    OP_JFL,  // e.g.: jfl r0, r1, 0x1C 0x00
+    OP_JFLE, // e.g.: jfle r0, r1, 0x1C 0x00
     INSTRUCTION_COUNT
 };
 
+// Minimum and maximum of fmin/fmax: a NaN operand is ignored, so the result is
+// NaN only when both are, and -0 orders below +0.
+static inline float floatMin(float a, float b)
+{
+    if (a < b)
+        return a;
+    if (b < a || a != a)
+        return b;
+    if (b != b)
+        return a;
+    return __builtin_signbit(a) ? a : b;
+}
+
+static inline float floatMax(float a, float b)
+{
+    if (a > b)
+        return a;
+    if (b > a || a != a)
+        return b;
+    if (b != b)
+        return a;
+    return __builtin_signbit(a) ? b : a;
+}
+
+// Nearest integer with ties to even, whatever rounding mode the host thread
+// has set: truncation and int conversion do not depend on it.
+static inline float floatRound(float a)
+{
+    // 2^23 and above, infinities and NaN are kept
+    if (!(__builtin_fabsf(a) < 8388608.0f))
+        return a;
+    float r = __builtin_truncf(a);
+    const float frac = __builtin_fabsf(a - r);
+    if (frac > 0.5f || (frac == 0.5f && ((int32_t)r & 1)))
+        r += __builtin_copysignf(1.0f, a);
+    // -0.5 rounds to -0
+    return __builtin_copysignf(r, a);
+}
+
+// Condition codes of the conditional move and select opcodes, comparing a to
+// b. A and B compare unsigned and G and L signed, like the jumps; the float
+// conditions are false for NaN operands, except FNE.
+enum Condition : uint8_t
+{
+    COND_E,
+    COND_NE,
+    COND_A,
+    COND_G,
+    COND_AE,
+    COND_GE,
+    COND_B,
+    COND_L,
+    COND_BE,
+    COND_LE,
+    COND_FE,
+    COND_FNE,
+    COND_FG,
+    COND_FGE,
+    COND_FL,
+    COND_FLE,
+    // count
+    CONDITION_COUNT
+};
+
 enum Register : uint8_t
 {
     // preserved across a call
@@ -143,6 +378,48 @@ enum Register : uint8_t
     REGISTER_COUNT
 };
 
+enum StatCounter : uint8_t
+{
+    STAT_INSTRUCTIONS,   // instructions retired
+    STAT_RUNS,           // calls to run() and runUntil()
+    STAT_INTERRUPTS,     // interrupts passed to a handler
+    STAT_BYTES_PRINTED,  // bytes written by the print opcodes
+    STAT_BYTES_READ,     // bytes consumed by the read opcodes
+    STAT_PEAK_STACK,     // deepest stack use in bytes, a maximum rather than a sum; 0 with VM_DISABLE_CHECKS
+    STAT_RESULTS,        // runs ending with each ExecResult, EXEC_RESULT_COUNT counters
+    STAT_COUNT = STAT_RESULTS + EXEC_RESULT_COUNT
+};
+
+// Counters of one VM, or of all the VMs one thread ran. Only the owning
+// thread writes them, with plain relaxed stores, so updates never lock and
+// any thread may read them at any time. A VM publishes its counters at the
+// end of every run.
+class VMStats
+{
+  public:
+    VMStats();
+
+    uint64_t get(StatCounter counter) const;
+    uint64_t result(ExecResult result) const;
+    void add(const uint64_t deltas[STAT_COUNT]);
+
+    // the calling thread's counters, summed by aggregate()
+    static VMStats &local();
+    // totals of every thread, including those that exited
+    static void aggregate(uint64_t values[STAT_COUNT]);
+
+  protected:
+    std::atomic<uint64_t> _values[STAT_COUNT];
+};
+
+class OpcodeProfile;
+class SamplingProfiler;
+class ExecutionTrace;
+class BlockCoverage;
+class CallGraphProfiler;
+class MemoryHeatmap;
+class ReplayLog;
+
 class VM
 {
   public:
@@ -150,8 +427,44 @@ class VM
     ~VM();
 
     ExecResult run(uint32_t maxInstr = 0);
+    // preemptible runs check the interrupt flag and the deadline (in VM::clock()
+    // nanoseconds, 0 for none) at back-edges and calls only
+    ExecResult runUntil(uint64_t deadline, uint32_t maxInstr = 0);
+    ExecResult runFor(uint64_t nanos, uint32_t maxInstr = 0);
+    // asks a preemptible run to return VM_INTERRUPTED; run() ignores the
+    // request and drops it when it returns
+    void interrupt();
+    static uint64_t clock();
+    // instructions retired by every run since construction
+    uint64_t retired();
+    const VMStats &stats();
+
+    // count and time every retired instruction into profile, nullptr detaches
+    void attachProfile(OpcodeProfile *profile);
+    // maintain the sampler's shadow call stack on CALL/RET, nullptr detaches
+    void attachSampler(SamplingProfiler *sampler);
+    // record the last executed instructions into trace, nullptr detaches
+    void attachTrace(ExecutionTrace *trace);
+    // count basic block entries into coverage, nullptr detaches
+    void attachCoverage(BlockCoverage *coverage);
+    // charge instructions and cycles to functions and call edges, nullptr detaches
+    void attachCallGraph(CallGraphProfiler *callgraph);
+    // count memory accesses per line and track the stack depth, nullptr detaches
+    void attachHeatmap(MemoryHeatmap *heatmap);
+    // log every input and interrupt from the current state on into log, nullptr stops
+    void recordTo(ReplayLog *log);
+    // restart from the state log begins with and take every input and interrupt
+    // from it instead of the host, nullptr stops; false if the memory layout differs
+    bool replayFrom(ReplayLog *log);
     void reset();
     void onInterrupt(bool (*callback)(uint8_t));
+    void setOutput(FILE *out);
+    void setInput(FILE *in);
+    void onInterruptAsync(InterruptResult (*callback)(VM *, uint8_t, uint32_t *));
+
+    bool waiting();
+    uint32_t pendingToken();
+    bool resume(uint32_t token);
 
     uint32_t stackCount();
     void stackPush(uint32_t value);
@@ -161,6 +474,9 @@ class VM
 
     uint32_t getRegister(Register reg);
     void setRegister(Register reg, uint32_t val);
+    // the register pair reg, reg + 1 holding a 64-bit value, low half first
+    uint64_t getRegister64(Register reg);
+    void setRegister64(Register reg, uint64_t val);
 
     int getRegisterSig();
     void setRegisterSig(int val);
@@ -174,6 +490,19 @@ class VM
     }
 
   protected:
+    template <class Policy> ExecResult _run(uint32_t maxInstr);
+    void _publish(ExecResult result, uint64_t retired);
+    // run() without instrumentation or publishing, for VMs used as a helper interpreter
+    ExecResult _runUnpublished(uint32_t maxInstr);
+    inline bool _instrumented();
+    inline bool _timed();
+    inline void _dispatch(uint16_t ip, uint8_t instr);
+    inline void _retire(uint16_t ip, uint8_t instr, uint64_t begin);
+    inline void _call(uint16_t target);
+    inline void _return();
+    inline void _read(uint32_t addr, uint32_t len);
+    inline void _write(uint32_t addr, uint32_t len);
+
     /**\/ sinalizador para operações de valores negativos; */
     bool FSIG;
     /**\/ registrador para operações de valores negativos; */
@@ -184,6 +513,28 @@ class VM
     const uint16_t _stackSize;
     const uint16_t _progLen;
     bool (*_interruptCallback)(uint8_t) = nullptr;
+    InterruptResult (*_asyncCallback)(VM *, uint8_t, uint32_t *) = nullptr;
+    bool _waiting = false;
+    uint32_t _pendingToken = 0;
+    FILE *_out = stdout;
+    FILE *_in = stdin;
+    std::atomic<bool> _interrupted{false};
+    uint64_t _deadline = 0;
+    OpcodeProfile *_profile = nullptr;
+    SamplingProfiler *_sampler = nullptr;
+    ExecutionTrace *_trace = nullptr;
+    BlockCoverage *_coverage = nullptr;
+    CallGraphProfiler *_callgraph = nullptr;
+    MemoryHeatmap *_heatmap = nullptr;
+    ReplayLog *_recorder = nullptr;
+    ReplayLog *_replayer = nullptr;
+    uint64_t _retired = 0;
+    // activity not yet published to _stats
+    uint64_t _interrupts = 0;
+    uint64_t _bytesPrinted = 0;
+    uint64_t _bytesRead = 0;
+    uint32_t _lowestSp;
+    VMStats _stats;
 };
 
 #endif // __VM_H__
\ No newline at end of file
@@ -0,0 +1,321 @@
+#include "vmstats.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char *RESULT_NAMES[] = {
+    "finished",         "paused",         "unknown_opcode",  "unsupported_opcode",
+    "invalid_register", "unhandled_interrupt", "stack_overflow", "stack_underflow",
+    "invalid_address",  "waiting",        "deadline",        "interrupted",
+    "replay_diverged",  "wait_failed",
+};
+static_assert(sizeof(RESULT_NAMES) / sizeof(RESULT_NAMES[0]) == EXEC_RESULT_COUNT,
+              "RESULT_NAMES must cover every ExecResult");
+
+const char *resultName(ExecResult result)
+{
+    return result < EXEC_RESULT_COUNT ? RESULT_NAMES[result] : "unknown";
+}
+
+VMStats::VMStats()
+{
+    for (uint32_t i = 0; i < STAT_COUNT; i++)
+        this->_values[i].store(0, std::memory_order_relaxed);
+}
+
+uint64_t VMStats::get(StatCounter counter) const
+{
+    return this->_values[counter].load(std::memory_order_relaxed);
+}
+
+uint64_t VMStats::result(ExecResult result) const
+{
+    return this->_values[STAT_RESULTS + result].load(std::memory_order_relaxed);
+}
+
+void VMStats::add(const uint64_t deltas[STAT_COUNT])
+{
+    // single writer: a load and a store are enough, no read-modify-write
+    for (uint32_t i = 0; i < STAT_COUNT; i++)
+    {
+        const uint64_t value = this->_values[i].load(std::memory_order_relaxed);
+        if (i == STAT_PEAK_STACK)
+        {
+            if (deltas[i] > value)
+                this->_values[i].store(deltas[i], std::memory_order_relaxed);
+        }
+        else if (deltas[i] != 0)
+            this->_values[i].store(value + deltas[i], std::memory_order_relaxed);
+    }
+}
+
+// every live thread's counters, plus the totals of the threads that exited
+static std::mutex threadsLock;
+static std::vector<VMStats *> threadStats;
+static VMStats exitedStats;
+
+struct ThreadStats
+{
+    VMStats stats;
+
+    ThreadStats()
+    {
+        std::lock_guard<std::mutex> guard(threadsLock);
+        threadStats.push_back(&this->stats);
+    }
+
+    ~ThreadStats()
+    {
+        uint64_t values[STAT_COUNT];
+        for (uint32_t i = 0; i < STAT_COUNT; i++)
+            values[i] = this->stats.get((StatCounter)i);
+
+        std::lock_guard<std::mutex> guard(threadsLock);
+        exitedStats.add(values);
+        for (size_t i = 0; i < threadStats.size(); i++)
+        {
+            if (threadStats[i] == &this->stats)
+            {
+                threadStats.erase(threadStats.begin() + i);
+                break;
+            }
+        }
+    }
+};
+
+VMStats &VMStats::local()
+{
+    static thread_local ThreadStats stats;
+    return stats.stats;
+}
+
+void VMStats::aggregate(uint64_t values[STAT_COUNT])
+{
+    std::lock_guard<std::mutex> guard(threadsLock);
+    for (uint32_t i = 0; i < STAT_COUNT; i++)
+        values[i] = exitedStats.get((StatCounter)i);
+
+    for (size_t t = 0; t < threadStats.size(); t++)
+    {
+        for (uint32_t i = 0; i < STAT_COUNT; i++)
+        {
+            const uint64_t value = threadStats[t]->get((StatCounter)i);
+            if (i == STAT_PEAK_STACK)
+                values[i] = value > values[i] ? value : values[i];
+            else
+                values[i] += value;
+        }
+    }
+}
+
+struct Metric
+{
+    StatCounter counter;
+    const char *name;
+    const char *type;
+    const char *help;
+};
+
+static const Metric METRICS[] = {
+    {STAT_INSTRUCTIONS, "instructions_total", "counter", "Instructions retired."},
+    {STAT_RUNS, "runs_total", "counter", "Calls to run() and runUntil()."},
+    {STAT_INTERRUPTS, "interrupts_total", "counter", "Interrupts passed to a handler."},
+    {STAT_BYTES_PRINTED, "printed_bytes_total", "counter", "Bytes written by the print opcodes."},
+    {STAT_BYTES_READ, "read_bytes_total", "counter", "Bytes consumed by the read opcodes."},
+    {STAT_PEAK_STACK, "peak_stack_bytes", "gauge", "Deepest stack use in bytes."},
+};
+
+// label values escape backslash, double quote and newline
+static std::string escapeLabel(const std::string &value)
+{
+    std::string escaped;
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        if (value[i] == '\\' || value[i] == '"')
+            escaped += '\\';
+        if (value[i] == '\n')
+            escaped += "\\n";
+        else
+            escaped += value[i];
+    }
+    return escaped;
+}
+
+StatsExporter::~StatsExporter()
+{
+    this->stop();
+}
+
+void StatsExporter::watch(VM *vm, const char *name)
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    this->_vms.push_back(std::make_pair(vm, escapeLabel(name)));
+}
+
+void StatsExporter::unwatch(VM *vm)
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+    for (size_t i = 0; i < this->_vms.size(); i++)
+    {
+        if (this->_vms[i].first == vm)
+        {
+            this->_vms.erase(this->_vms.begin() + i);
+            return;
+        }
+    }
+}
+
+void StatsExporter::writePrometheus(FILE *out)
+{
+    uint64_t totals[STAT_COUNT];
+    VMStats::aggregate(totals);
+
+    std::lock_guard<std::mutex> guard(this->_lock);
+    for (const Metric &metric : METRICS)
+    {
+        fprintf(out, "# HELP microbytevm_%s %s\n", metric.name, metric.help);
+        fprintf(out, "# TYPE microbytevm_%s %s\n", metric.name, metric.type);
+        fprintf(out, "microbytevm_%s %llu\n", metric.name, (unsigned long long)totals[metric.counter]);
+    }
+    fprintf(out, "# HELP microbytevm_results_total Runs ended with each result.\n");
+    fprintf(out, "# TYPE microbytevm_results_total counter\n");
+    for (uint32_t r = 0; r < EXEC_RESULT_COUNT; r++)
+        fprintf(out, "microbytevm_results_total{result=\"%s\"} %llu\n", RESULT_NAMES[r],
+                (unsigned long long)totals[STAT_RESULTS + r]);
+
+    if (this->_vms.empty())
+        return;
+
+    for (const Metric &metric : METRICS)
+    {
+        fprintf(out, "# HELP microbytevm_vm_%s %s\n", metric.name, metric.help);
+        fprintf(out, "# TYPE microbytevm_vm_%s %s\n", metric.name, metric.type);
+        for (size_t i = 0; i < this->_vms.size(); i++)
+            fprintf(out, "microbytevm_vm_%s{vm=\"%s\"} %llu\n", metric.name, this->_vms[i].second.c_str(),
+                    (unsigned long long)this->_vms[i].first->stats().get(metric.counter));
+    }
+    fprintf(out, "# HELP microbytevm_vm_results_total Runs ended with each result.\n");
+    fprintf(out, "# TYPE microbytevm_vm_results_total counter\n");
+    for (size_t i = 0; i < this->_vms.size(); i++)
+    {
+        const VMStats &stats = this->_vms[i].first->stats();
+        for (uint32_t r = 0; r < EXEC_RESULT_COUNT; r++)
+            fprintf(out, "microbytevm_vm_results_total{vm=\"%s\",result=\"%s\"} %llu\n",
+                    this->_vms[i].second.c_str(), RESULT_NAMES[r],
+                    (unsigned long long)stats.result((ExecResult)r));
+    }
+}
+
+bool StatsExporter::writeFile(const char *path)
+{
+    const std::string tmp = std::string(path) + ".tmp";
+    FILE *out = fopen(tmp.c_str(), "w");
+    if (out == nullptr)
+        return false;
+
+    this->writePrometheus(out);
+    if (fclose(out) != 0 || rename(tmp.c_str(), path) != 0)
+    {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool StatsExporter::serve(const char *socketPath)
+{
+    if (this->_listener >= 0)
+        return false;
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path))
+        return false;
+    strcpy(addr.sun_path, socketPath);
+    unlink(socketPath);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        return false;
+    if (bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 16) != 0 ||
+        pipe(this->_wake) != 0)
+    {
+        close(listener);
+        return false;
+    }
+
+    this->_listener = listener;
+    this->_socketPath = socketPath;
+    this->_server = std::thread(&StatsExporter::_accept, this);
+    return true;
+}
+
+void StatsExporter::stop()
+{
+    if (this->_listener < 0)
+        return;
+
+    // wakes up the server thread, whether it waits for a connection or a request
+    (void)!write(this->_wake[1], "", 1);
+    this->_server.join();
+    close(this->_listener);
+    close(this->_wake[0]);
+    close(this->_wake[1]);
+    unlink(this->_socketPath.c_str());
+    this->_listener = -1;
+    this->_wake[0] = this->_wake[1] = -1;
+}
+
+// false once stop() was called
+bool StatsExporter::_waitReadable(int fd, int timeoutMs)
+{
+    pollfd fds[2] = {{fd, POLLIN, 0}, {this->_wake[0], POLLIN, 0}};
+    while (poll(fds, 2, timeoutMs) < 0)
+        if (errno != EINTR)
+            return false;
+    return fds[1].revents == 0;
+}
+
+void StatsExporter::_accept()
+{
+    for (;;)
+    {
+        if (!this->_waitReadable(this->_listener, -1))
+            return;
+        const int fd = accept(this->_listener, nullptr, nullptr);
+        if (fd < 0 && (errno == EINTR || errno == EAGAIN || errno == ECONNABORTED))
+            continue;
+        if (fd < 0)
+            return;
+
+        // the request itself does not matter, every path is the scrape, but a
+        // client that sends nothing must not hold up the others or stop()
+        if (!this->_waitReadable(fd, STATS_REQUEST_TIMEOUT_MS))
+        {
+            close(fd);
+            return;
+        }
+        char request[512];
+        (void)!recv(fd, request, sizeof(request), MSG_DONTWAIT);
+
+        char *body = nullptr;
+        size_t bodyLen = 0;
+        FILE *out = open_memstream(&body, &bodyLen);
+        this->writePrometheus(out);
+        fclose(out);
+
+        char header[128];
+        const int headerLen = snprintf(header, sizeof(header),
+                                       "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                       "Content-Length: %zu\r\n\r\n",
+                                       bodyLen);
+        if (write(fd, header, headerLen) == headerLen)
+            (void)!write(fd, body, bodyLen);
+        free(body);
+        close(fd);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef __VMSTATS_H__
+#define __VMSTATS_H__
+
+#include "vm.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// name of an ExecResult as used in metric labels, e.g. "stack_overflow"
+const char *resultName(ExecResult result);
+
+// Publishes VMStats in the Prometheus text format: the totals of every thread
+// as microbytevm_*, and the counters of each watched VM as microbytevm_vm_*
+// labelled with its name. Counters only move when a run returns, so VMs
+// running long programs should be driven in runUntil() slices to be seen live.
+// A watched VM must be unwatched before it is destroyed.
+#define STATS_REQUEST_TIMEOUT_MS 1000
+
+class StatsExporter
+{
+  public:
+    ~StatsExporter();
+
+    void watch(VM *vm, const char *name);
+    void unwatch(VM *vm);
+
+    void writePrometheus(FILE *out);
+    // replaces path atomically, for node_exporter's textfile collector
+    bool writeFile(const char *path);
+
+    // answers every connection on a Unix socket with an HTTP scrape response;
+    // a client gets STATS_REQUEST_TIMEOUT_MS to send its request, then is answered anyway
+    bool serve(const char *socketPath);
+    void stop();
+
+  protected:
+    void _accept();
+    bool _waitReadable(int fd, int timeoutMs);
+
+    std::mutex _lock;
+    std::vector<std::pair<VM *, std::string>> _vms;
+    std::thread _server;
+    std::string _socketPath;
+    int _listener = -1;
+    int _wake[2] = {-1, -1}; // self-pipe that stop() writes to, polled next to every fd
+};
+
+#endif // __VMSTATS_H__